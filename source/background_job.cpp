@@ -0,0 +1,86 @@
+/**
+ * @file background_job.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <string.h>
+
+#include <iostream>
+
+#include "background_job.h"
+
+bool StartBackgroundJob(const std::filesystem::path& pLockFile,const std::filesystem::path& pLogFile,const std::function<void()>& pJob)
+{
+	// Anything still buffered would be written twice, once by us and once by the job.
+	std::cout << std::flush;
+	std::clog << std::flush;
+
+	const pid_t pid = fork();
+	if( pid < 0 )
+	{
+		std::cerr << "Failed to fork background job " << strerror(errno) << "\n";
+		return false;
+	}
+
+	if( pid == 0 )
+	{
+		// Fork again so the job is not our child and can not be waited on, or killed, with our session.
+		setsid();
+		if( fork() != 0 )
+			_exit(0);
+
+		const int lock = open(pLockFile.c_str(),O_RDWR|O_CREAT|O_CLOEXEC,0644);
+		if( lock < 0 || flock(lock,LOCK_EX|LOCK_NB) != 0 )
+			_exit(0);// Someone else is already doing it.
+
+		const int devNull = open("/dev/null",O_RDONLY);
+		const int log = open(pLogFile.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+		if( devNull >= 0 )
+			dup2(devNull,STDIN_FILENO);
+		if( log >= 0 )
+		{
+			dup2(log,STDOUT_FILENO);
+			dup2(log,STDERR_FILENO);
+		}
+
+		pJob();
+
+		std::cout << std::flush;
+		std::clog << std::flush;
+		_exit(0);
+	}
+
+	// Only waits for the first fork, which exits straight away.
+	int status;
+	waitpid(pid,&status,0);
+	return true;
+}
+
+bool IsBackgroundJobRunning(const std::filesystem::path& pLockFile)
+{
+	const int lock = open(pLockFile.c_str(),O_RDWR|O_CLOEXEC);
+	if( lock < 0 )
+		return false;
+
+	const bool running = flock(lock,LOCK_EX|LOCK_NB) != 0;
+	close(lock);
+	return running;
+}
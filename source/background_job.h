@@ -0,0 +1,34 @@
+/**
+ * @file background_job.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BACKGROUND_JOB_H__
+#define __BACKGROUND_JOB_H__
+
+#include <functional>
+#include <filesystem>
+
+// Runs pJob in a detached process that outlives seabang. The process holds an exclusive lock on pLockFile while the job runs,
+// if another job already holds it this one does nothing, so there is only ever one job per lock file.
+// Standard output and error go to pLogFile. Returns false if the process could not be started.
+bool StartBackgroundJob(const std::filesystem::path& pLockFile,const std::filesystem::path& pLogFile,const std::function<void()>& pJob);
+
+// Returns true if a background job is holding the lock file.
+bool IsBackgroundJobRunning(const std::filesystem::path& pLockFile);
+
+#endif //#ifndef __BACKGROUND_JOB_H__
@@ -0,0 +1,199 @@
+/**
+ * @file benchmark.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+#include "benchmark.h"
+
+static double TimevalToSeconds(const timeval& pTime)
+{
+	return (double)pTime.tv_sec + ((double)pTime.tv_usec / 1000000.0);
+}
+
+static double TimespecToSeconds(const timespec& pTime)
+{
+	return (double)pTime.tv_sec + ((double)pTime.tv_nsec / 1000000000.0);
+}
+
+/**
+ * @brief Runs the exec once, without a shell in the way, and records how long it took.
+ */
+static bool RunOnce(const std::filesystem::path& pExeName,const std::vector<std::string>& pArgs,int pCPU,double& rWallTime,double& rCPUTime)
+{
+	// Build the args before the clock starts so we only time the exec.
+	std::vector<char*> args;
+	const std::string exeName = pExeName.string();
+	args.push_back((char*)exeName.c_str());
+	for( const std::string& a : pArgs )
+		args.push_back((char*)a.c_str());
+	args.push_back(nullptr);
+
+	timespec start,end;
+	clock_gettime(CLOCK_MONOTONIC,&start);
+
+	const pid_t pid = fork();
+	if( pid < 0 )
+	{
+		std::cerr << "Benchmark failed to fork " << strerror(errno) << "\n";
+		return false;
+	}
+
+	if( pid == 0 )
+	{
+		if( pCPU >= 0 )
+		{
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			CPU_SET(pCPU,&cpuSet);
+			if( sched_setaffinity(0,sizeof(cpuSet),&cpuSet) != 0 )
+			{
+				std::cerr << "Benchmark failed to pin to CPU " << pCPU << " " << strerror(errno) << "\n";
+				_exit(EXIT_FAILURE);
+			}
+		}
+		execv(args[0],args.data());
+		std::cerr << "Benchmark failed to run " << pExeName << " " << strerror(errno) << "\n";
+		_exit(EXIT_FAILURE);
+	}
+
+	int status = 0;
+	rusage usage;
+	if( wait4(pid,&status,0,&usage) == -1 )
+	{
+		std::cerr << "Benchmark failed to wait for child process " << strerror(errno) << "\n";
+		return false;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end);
+
+	rWallTime = TimespecToSeconds(end) - TimespecToSeconds(start);
+	rCPUTime = TimevalToSeconds(usage.ru_utime) + TimevalToSeconds(usage.ru_stime);
+
+	if( WIFEXITED(status) == false || WEXITSTATUS(status) != 0 )
+	{
+		std::cerr << "Benchmark run of " << pExeName << " failed, stopping\n";
+		return false;
+	}
+	return true;
+}
+
+bool RunBenchmark(std::vector<BenchmarkTarget>& rTargets,const std::vector<std::string>& pArgs,const BenchmarkOptions& pOptions)
+{
+	// An explicit flush is needed as the children share our output.
+	std::cout << std::flush;
+
+	const int totalRuns = pOptions.mWarmupRuns + pOptions.mRuns;
+	for( int run = 0 ; run < totalRuns ; run++ )
+	{
+		for( BenchmarkTarget& target : rTargets )
+		{
+			double wall,cpu;
+			if( RunOnce(target.mExeName,pArgs,pOptions.mCPU,wall,cpu) == false )
+				return false;
+
+			if( run >= pOptions.mWarmupRuns )
+			{
+				target.mWallTimes.push_back(wall);
+				target.mCPUTimes.push_back(cpu);
+			}
+		}
+	}
+	return true;
+}
+
+BenchmarkStats CalculateBenchmarkStats(std::vector<double>& rSamples)
+{
+	BenchmarkStats stats;
+	if( rSamples.size() == 0 )
+		return stats;
+
+	std::sort(rSamples.begin(),rSamples.end());
+
+	// Nearest rank percentiles, keeps the values as ones we actually saw.
+	auto percentile = [&rSamples](double pPercent)
+	{
+		size_t rank = (size_t)std::ceil((pPercent / 100.0) * (double)rSamples.size());
+		rank = std::clamp(rank,(size_t)1,rSamples.size());
+		return rSamples[rank-1];
+	};
+
+	stats.mMin = rSamples.front();
+	stats.mMedian = percentile(50.0);
+	stats.mP90 = percentile(90.0);
+	stats.mP99 = percentile(99.0);
+
+	if( rSamples.size() > 1 )
+	{
+		double mean = 0.0;
+		for( double s : rSamples )
+			mean += s;
+		mean /= (double)rSamples.size();
+
+		double sumSq = 0.0;
+		for( double s : rSamples )
+			sumSq += (s - mean) * (s - mean);
+		stats.mStdDev = std::sqrt(sumSq / (double)(rSamples.size() - 1));
+	}
+	return stats;
+}
+
+static void ReportStats(const std::string& pName,const std::string& pWhat,const BenchmarkStats& pStats,size_t pNameWidth)
+{
+	auto ms = [](double pSeconds){return pSeconds * 1000.0;};
+	std::clog << std::left << std::setw(pNameWidth) << pName << std::setw(6) << pWhat << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << ms(pStats.mMin)
+		<< std::setw(12) << ms(pStats.mMedian)
+		<< std::setw(12) << ms(pStats.mP90)
+		<< std::setw(12) << ms(pStats.mP99)
+		<< std::setw(12) << ms(pStats.mStdDev) << "\n";
+}
+
+void ReportBenchmark(std::vector<BenchmarkTarget>& rTargets,const BenchmarkOptions& pOptions)
+{
+	size_t nameWidth = 8;
+	for( const BenchmarkTarget& target : rTargets )
+		nameWidth = std::max(nameWidth,target.mName.size() + 2);
+
+	std::clog << "\nseabang benchmark, " << pOptions.mRuns << " runs after " << pOptions.mWarmupRuns << " warmup runs";
+	if( pOptions.mCPU >= 0 )
+		std::clog << ", pinned to CPU " << pOptions.mCPU;
+	std::clog << ", times in milliseconds\n";
+
+	std::clog << std::left << std::setw(nameWidth + 6) << "" << std::right
+		<< std::setw(12) << "min"
+		<< std::setw(12) << "median"
+		<< std::setw(12) << "p90"
+		<< std::setw(12) << "p99"
+		<< std::setw(12) << "stddev" << "\n";
+
+	for( BenchmarkTarget& target : rTargets )
+	{
+		ReportStats(target.mName,"wall",CalculateBenchmarkStats(target.mWallTimes),nameWidth);
+		ReportStats(target.mName,"cpu",CalculateBenchmarkStats(target.mCPUTimes),nameWidth);
+	}
+}
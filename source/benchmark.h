@@ -0,0 +1,62 @@
+/**
+ * @file benchmark.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+struct BenchmarkOptions
+{
+	int mRuns = 0;			// How many timed runs to do.
+	int mWarmupRuns = 0;	// Runs done before timing starts, results are thrown away.
+	int mCPU = -1;			// The CPU to pin the runs too, -1 means don't pin.
+};
+
+struct BenchmarkStats
+{
+	double mMin = 0.0;
+	double mMedian = 0.0;
+	double mP90 = 0.0;
+	double mP99 = 0.0;
+	double mStdDev = 0.0;
+};
+
+// One executable being benchmarked, the name is used in the report so you can tell profiles apart.
+struct BenchmarkTarget
+{
+	std::string mName;
+	std::filesystem::path mExeName;
+	std::vector<double> mWallTimes;	// In seconds.
+	std::vector<double> mCPUTimes;	// User + system time, in seconds.
+};
+
+// Runs each target directly, no shell, the warmup and timed runs are interleaved between the targets so that they all see the same machine state.
+// Returns false if any of the runs fail to start or exit with an error.
+bool RunBenchmark(std::vector<BenchmarkTarget>& rTargets,const std::vector<std::string>& pArgs,const BenchmarkOptions& pOptions);
+
+// Works out the stats for a set of timings. The samples are sorted in place.
+BenchmarkStats CalculateBenchmarkStats(std::vector<double>& rSamples);
+
+// Writes a table of the results for each target to std::clog.
+void ReportBenchmark(std::vector<BenchmarkTarget>& rTargets,const BenchmarkOptions& pOptions);
+
+#endif //#ifndef __BENCHMARK_H__
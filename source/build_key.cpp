@@ -0,0 +1,130 @@
+/**
+ * @file build_key.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "build_key.h"
+
+std::filesystem::path GetBuildKeyFilename(const std::filesystem::path& pExeName)
+{
+	return (std::filesystem::path(pExeName) += ".key");
+}
+
+bool ReadBuildKey(const std::filesystem::path& pExeName,BuildKey& rKey)
+{
+	std::ifstream file(GetBuildKeyFilename(pExeName));
+	std::string line;
+	bool gotToolchain = false;
+	bool gotFlags = false;
+	while( std::getline(file,line) )
+	{
+		if( line.rfind("toolchain=",0) == 0 )
+		{
+			rKey.mToolchain = line.substr(10);
+			gotToolchain = true;
+		}
+		else if( line.rfind("flags=",0) == 0 )
+		{
+			rKey.mFlags = line.substr(6);
+			gotFlags = true;
+		}
+		else if( line.rfind("source-hash=",0) == 0 )
+		{
+			rKey.mSourceHash = line.substr(12);
+		}
+	}
+	return gotToolchain && gotFlags;
+}
+
+bool WriteBuildKey(const std::filesystem::path& pExeName,const BuildKey& pKey)
+{
+	std::ofstream file(GetBuildKeyFilename(pExeName),std::ios::trunc);
+	file << "toolchain=" << pKey.mToolchain << "\n";
+	file << "flags=" << pKey.mFlags << "\n";
+	if( pKey.mSourceHash.size() > 0 )
+	{
+		file << "source-hash=" << pKey.mSourceHash << "\n";
+	}
+	return file.good();
+}
+
+std::string CompareBuildKey(const BuildKey& pBuilt,const BuildKey& pCurrent)
+{
+	if( pCurrent.mToolchain.size() > 0 && pBuilt.mToolchain != pCurrent.mToolchain )
+	{
+		return "compiler changed\n    was: " + pBuilt.mToolchain + "\n    now: " + pCurrent.mToolchain;
+	}
+
+	if( pBuilt.mFlags != pCurrent.mFlags )
+	{
+		return "flags changed\n    was: " + pBuilt.mFlags + "\n    now: " + pCurrent.mFlags;
+	}
+	return "";
+}
+
+std::filesystem::path GetFailedBuildFilename(const std::filesystem::path& pExeName)
+{
+	return (std::filesystem::path(pExeName) += ".failed");
+}
+
+bool WriteFailedBuild(const std::filesystem::path& pExeName,const BuildKey& pKey,const std::string& pSourceHash,const std::string& pDiagnostics)
+{
+	std::ofstream file(GetFailedBuildFilename(pExeName),std::ios::trunc);
+	file << "toolchain=" << pKey.mToolchain << "\n";
+	file << "flags=" << pKey.mFlags << "\n";
+	file << "source-hash=" << pSourceHash << "\n";
+	file << "\n";
+	file << pDiagnostics;
+	return file.good();
+}
+
+bool ReadFailedBuild(const std::filesystem::path& pExeName,BuildKey& rKey,std::string& rSourceHash,std::string& rDiagnostics)
+{
+	std::ifstream file(GetFailedBuildFilename(pExeName));
+	if( !file )
+		return false;
+
+	// Key lines up to the first empty line, then the diagnostics.
+	int fields = 0;
+	std::string line;
+	while( std::getline(file,line) && line.size() > 0 )
+	{
+		if( line.rfind("toolchain=",0) == 0 )
+		{
+			rKey.mToolchain = line.substr(10);
+			fields++;
+		}
+		else if( line.rfind("flags=",0) == 0 )
+		{
+			rKey.mFlags = line.substr(6);
+			fields++;
+		}
+		else if( line.rfind("source-hash=",0) == 0 )
+		{
+			rSourceHash = line.substr(12);
+			fields++;
+		}
+	}
+
+	std::stringstream diagnostics;
+	diagnostics << file.rdbuf();
+	rDiagnostics = diagnostics.str();
+	return fields == 3;
+}
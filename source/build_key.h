@@ -0,0 +1,53 @@
+/**
+ * @file build_key.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BUILD_KEY_H__
+#define __BUILD_KEY_H__
+
+#include <string>
+#include <filesystem>
+
+// What an exec was built with, other than the source. It is stored next to the exec as <exec>.key.
+// If any of it changes the exec is out of date.
+struct BuildKey
+{
+	std::string mToolchain;	// ToolchainFingerprint::ToString(), empty if the compiler could not be found.
+	std::string mFlags;		// All the flags that change the exec.
+	std::string mSourceHash;	// Of the source and it's includes when it was built. Not compared, kept so a rebuild can be explained.
+};
+
+std::filesystem::path GetBuildKeyFilename(const std::filesystem::path& pExeName);
+
+// Returns false if there is no key for the exec.
+bool ReadBuildKey(const std::filesystem::path& pExeName,BuildKey& rKey);
+bool WriteBuildKey(const std::filesystem::path& pExeName,const BuildKey& pKey);
+
+// Returns an empty string if the exec was built with the current key, if not the reason why it was not.
+// When there is no compiler on this host, so no current toolchain, the toolchain is not checked as nothing can be rebuilt anyway.
+std::string CompareBuildKey(const BuildKey& pBuilt,const BuildKey& pCurrent);
+
+// When a build fails the key, the hash of the source and its dependencies and the compiler's output are stored as <exec>.failed.
+// While none of that changes there is no point building again, the same errors would come out.
+std::filesystem::path GetFailedBuildFilename(const std::filesystem::path& pExeName);
+bool WriteFailedBuild(const std::filesystem::path& pExeName,const BuildKey& pKey,const std::string& pSourceHash,const std::string& pDiagnostics);
+
+// Returns false if there is no failed build recorded for the exec.
+bool ReadFailedBuild(const std::filesystem::path& pExeName,BuildKey& rKey,std::string& rSourceHash,std::string& rDiagnostics);
+
+#endif //#ifndef __BUILD_KEY_H__
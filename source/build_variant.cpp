@@ -0,0 +1,107 @@
+/**
+ * @file build_variant.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "build_variant.h"
+
+static const std::vector<BuildVariant> gBuildVariants =
+{
+	{"release",	{"-O2","-g0","-DRELEASE_BUILD","-DNDEBUG"},{},{}},
+	{"debug",	{"-O0","-g2","-DDEBUG_BUILD"},{},{}},
+	{"asan",	{"-O1","-g2","-fsanitize=address","-fno-omit-frame-pointer","-DDEBUG_BUILD"},{},{}},
+	{"ubsan",	{"-O1","-g2","-fsanitize=undefined","-fno-omit-frame-pointer","-DDEBUG_BUILD"},{},{}},
+	{"tsan",	{"-O1","-g2","-fsanitize=thread","-DDEBUG_BUILD"},{},{}},
+	{"coverage",{"-O0","-g2","--coverage","-DDEBUG_BUILD"},{},{}},
+
+	// For small scripts that are run often, where most of the time is the loader. Linked statically so there is nothing to load or relocate.
+	// If the static libs are not installed it is linked without pie, with libstdc++ static and with gnu hashed symbols, which gets most of the way.
+	{"startup",	{"-O2","-g0","-DRELEASE_BUILD","-DNDEBUG","-fno-pie","-fno-plt","-ffunction-sections","-fdata-sections"},
+				{"-static","-Wl,-O1","-Wl,--gc-sections"},
+				{"-no-pie","-static-libstdc++","-static-libgcc","-Wl,-O1","-Wl,--gc-sections","-Wl,--hash-style=gnu","-Wl,--as-needed"}},
+};
+
+const BuildVariant* FindBuildVariant(const std::string& pName)
+{
+	for( const BuildVariant& variant : gBuildVariants )
+	{
+		if( variant.mName == pName )
+			return &variant;
+	}
+	return nullptr;
+}
+
+std::string GetBuildVariantNames()
+{
+	std::string names;
+	for( const BuildVariant& variant : gBuildVariants )
+	{
+		if( names.size() > 0 )
+			names += ", ";
+		names += variant.mName;
+	}
+	return names;
+}
+
+BuildVariant GetQuickBuildVariant(const BuildVariant& pVariant)
+{
+	// The link args are there to make the real exec start faster, a static link with section gc is the slowest there is and the
+	// quick exec is only run till the real one is built. So it's linked the default way, in the same step as the compile.
+	// -fno-pie has to go with them as the default link is pie, and the sections are only split for the gc.
+	BuildVariant quick = pVariant;
+	quick.mName = pVariant.mName + "-quick";
+	quick.mCompilerArgs.clear();
+	for( const std::string& arg : pVariant.mCompilerArgs )
+	{
+		if( arg != "-fno-pie" && arg != "-ffunction-sections" && arg != "-fdata-sections" )
+			quick.mCompilerArgs.push_back(arg.rfind("-O",0) == 0 ? "-O0" : arg);
+	}
+	quick.mLinkArgs.clear();
+	quick.mFallbackLinkArgs.clear();
+	return quick;
+}
+
+BuildVariant GetZygoteBuildVariant(const BuildVariant& pVariant)
+{
+	BuildVariant zygote = pVariant;
+	zygote.mName = pVariant.mName + "-zygote";
+	zygote.mZygote = true;
+	return zygote;
+}
+
+BuildVariant GetModuleBuildVariant(const BuildVariant& pVariant)
+{
+	// Link args are for making an exec, so are swapped for -shared. The startup variant's -fno-pie would stop it being position independent.
+	BuildVariant module = pVariant;
+	module.mName = pVariant.mName + "-module";
+	module.mModule = true;
+	module.mCompilerArgs.clear();
+	for( const std::string& arg : pVariant.mCompilerArgs )
+	{
+		if( arg != "-fno-pie" )
+			module.mCompilerArgs.push_back(arg);
+	}
+	module.mCompilerArgs.push_back("-fPIC");
+	module.mLinkArgs = {"-shared"};
+	module.mFallbackLinkArgs.clear();
+	return module;
+}
+
+std::filesystem::path GetBuildVariantExeName(const std::filesystem::path& pTempSourcefile,const BuildVariant& pVariant)
+{
+	return (std::filesystem::path(pTempSourcefile) += "." + pVariant.mName + ".exe");
+}
@@ -0,0 +1,57 @@
+/**
+ * @file build_variant.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BUILD_VARIANT_H__
+#define __BUILD_VARIANT_H__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// A set of compiler flags that the code can be built with.
+// Each variant is cached in it's own exec so switching between them does not force a rebuild.
+struct BuildVariant
+{
+	std::string mName;
+	std::vector<std::string> mCompilerArgs;
+	std::vector<std::string> mLinkArgs;			// Only given to the link, if there are any the compile and link are done as two steps.
+	std::vector<std::string> mFallbackLinkArgs;	// Used in place of mLinkArgs if the link fails with them, say when there are no static libs.
+	bool mZygote = false;	// Built with the zygote runtime, see zygote.h.
+	bool mModule = false;	// Built as a shared object for the module host, see module_host.h.
+};
+
+// Returns nullptr if there is no variant with that name.
+const BuildVariant* FindBuildVariant(const std::string& pName);
+
+// Returns a comma separated list of the variant names, for help and error messages.
+std::string GetBuildVariantNames();
+
+// The same flags as the variant but with no optimisation and linked the default way, for when an exec is needed as quickly as possible.
+BuildVariant GetQuickBuildVariant(const BuildVariant& pVariant);
+
+// The same flags as the variant but built so it can be run from a zygote.
+BuildVariant GetZygoteBuildVariant(const BuildVariant& pVariant);
+
+// The same flags as the variant but built as a shared object that the module host can load.
+BuildVariant GetModuleBuildVariant(const BuildVariant& pVariant);
+
+// The exec for a variant is the temporay source file name with the variant name and .exe added.
+std::filesystem::path GetBuildVariantExeName(const std::filesystem::path& pTempSourcefile,const BuildVariant& pVariant);
+
+#endif //#ifndef __BUILD_VARIANT_H__
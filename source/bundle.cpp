@@ -0,0 +1,187 @@
+/**
+ * @file bundle.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <iterator>
+
+#include "bundle.h"
+#include "hash.h"
+#include "lz_compress.h"
+
+static const std::string BUNDLE_MAGIC = "SEABANG-BUNDLE 1";
+
+/**
+ * @brief Reads the manifest lines, leaves the stream at the start of the payload.
+ */
+static bool ReadManifest(std::ifstream& pFile,const std::filesystem::path& pBundleFile,BundleManifest& rManifest)
+{
+	std::string line;
+	if( !std::getline(pFile,line) || line != BUNDLE_MAGIC )
+	{
+		std::cerr << pBundleFile << " is not a seabang bundle\n";
+		return false;
+	}
+
+	// The manifest ends with an empty line.
+	while( std::getline(pFile,line) && line.size() > 0 )
+	{
+		const size_t equality = line.find('=');
+		if( equality == std::string::npos )
+		{
+			std::cerr << pBundleFile << " has a malformed manifest line, " << line << "\n";
+			return false;
+		}
+		rManifest[line.substr(0,equality)] = line.substr(equality+1);
+	}
+
+	if( rManifest.count("payload-size") == 0 || rManifest.count("payload-hash") == 0 )
+	{
+		std::cerr << pBundleFile << " manifest is missing the payload details\n";
+		return false;
+	}
+	return true;
+}
+
+bool WriteBundle(const std::filesystem::path& pBundleFile,BundleManifest pManifest,const std::filesystem::path& pPayloadFile,bool pCompress)
+{
+	uint64_t payloadHash = HASH_SEED;
+	if( HashFile(pPayloadFile,payloadHash) == false )
+	{
+		std::cerr << "Failed to read " << pPayloadFile << " to bundle\n";
+		return false;
+	}
+	pManifest["payload-size"] = std::to_string(std::filesystem::file_size(pPayloadFile));
+	pManifest["payload-hash"] = HashToString(payloadHash);
+
+	std::ofstream bundle(pBundleFile,std::ios::binary|std::ios::trunc);
+	std::ifstream payload(pPayloadFile,std::ios::binary);
+	if( !bundle || !payload )
+	{
+		std::cerr << "Failed to create bundle " << pBundleFile << "\n";
+		return false;
+	}
+
+	// Execs are a few meg at most, so it is compressed in one go.
+	std::vector<uint8_t> compressed;
+	if( pCompress )
+	{
+		const std::vector<char> data((std::istreambuf_iterator<char>(payload)),std::istreambuf_iterator<char>());
+		compressed = LZCompress(data.data(),data.size());
+		pManifest["compression"] = "lz";
+		pManifest["stored-size"] = std::to_string(compressed.size());
+	}
+
+	bundle << BUNDLE_MAGIC << "\n";
+	for( const auto& field : pManifest )
+	{
+		bundle << field.first << "=" << field.second << "\n";
+	}
+	bundle << "\n";
+	if( pCompress )
+	{
+		bundle.write((const char*)compressed.data(),compressed.size());
+	}
+	else
+	{
+		bundle << payload.rdbuf();
+	}
+
+	if( !bundle )
+	{
+		std::cerr << "Failed to write bundle " << pBundleFile << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool ReadBundleManifest(const std::filesystem::path& pBundleFile,BundleManifest& rManifest)
+{
+	std::ifstream bundle(pBundleFile,std::ios::binary);
+	if( !bundle )
+	{
+		std::cerr << "Failed to open bundle " << pBundleFile << "\n";
+		return false;
+	}
+	return ReadManifest(bundle,pBundleFile,rManifest);
+}
+
+bool ExtractBundlePayload(const std::filesystem::path& pBundleFile,const std::filesystem::path& pPayloadFile)
+{
+	std::ifstream bundle(pBundleFile,std::ios::binary);
+	BundleManifest manifest;
+	if( !bundle || ReadManifest(bundle,pBundleFile,manifest) == false )
+		return false;
+
+	const std::filesystem::path tempFile = (std::filesystem::path(pPayloadFile) += ".import." + std::to_string(getpid()));
+	std::ofstream payload(tempFile,std::ios::binary|std::ios::trunc);
+	if( !payload )
+	{
+		std::cerr << "Failed to create " << tempFile << "\n";
+		return false;
+	}
+
+	uint64_t payloadHash = HASH_SEED;
+	uint64_t payloadSize = 0;
+	if( manifest.count("compression") > 0 )
+	{
+		const std::vector<char> stored((std::istreambuf_iterator<char>(bundle)),std::istreambuf_iterator<char>());
+		// A match can not make more than about 255 bytes from one, so a bad size can not have us allocate the world.
+		const uint64_t expectedSize = strtoull(manifest["payload-size"].c_str(),nullptr,10);
+		std::vector<uint8_t> data;
+		if( manifest["compression"] != "lz" || std::to_string(stored.size()) != manifest["stored-size"] || expectedSize > (uint64_t)stored.size() * 255 ||
+			LZDecompress(stored.data(),stored.size(),expectedSize,data) == false )
+		{
+			std::cerr << "The payload in " << pBundleFile << " could not be decompressed\n";
+			payload.close();
+			std::filesystem::remove(tempFile);
+			return false;
+		}
+		payloadHash = HashBytes(data.data(),data.size(),payloadHash);
+		payloadSize = data.size();
+		payload.write((const char*)data.data(),data.size());
+	}
+	else
+	{
+		std::vector<char> buf(64*1024);
+		while( bundle )
+		{
+			bundle.read(buf.data(),buf.size());
+			const size_t got = (size_t)bundle.gcount();
+			payloadHash = HashBytes(buf.data(),got,payloadHash);
+			payloadSize += got;
+			payload.write(buf.data(),got);
+		}
+	}
+	payload.close();
+
+	if( !payload || std::to_string(payloadSize) != manifest["payload-size"] || HashToString(payloadHash) != manifest["payload-hash"] )
+	{
+		std::cerr << "The payload in " << pBundleFile << " is corrupt, size or hash does not match the manifest\n";
+		std::filesystem::remove(tempFile);
+		return false;
+	}
+
+	std::filesystem::rename(tempFile,pPayloadFile);
+	return true;
+}
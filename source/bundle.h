@@ -0,0 +1,42 @@
+/**
+ * @file bundle.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BUNDLE_H__
+#define __BUNDLE_H__
+
+#include <string>
+#include <map>
+#include <filesystem>
+
+// A bundle is a single file holding a text manifest, one key=value per line, followed by the payload, the compiled exec.
+// The manifest values must not contain new lines.
+typedef std::map<std::string,std::string> BundleManifest;
+
+// Writes the manifest and the payload file into one bundle file. The payload size and hash are added to the manifest.
+// If compressed the payload is stored with LZCompress, the manifest gets compression=lz and the size stored, the payload size and hash are still of the exec.
+bool WriteBundle(const std::filesystem::path& pBundleFile,BundleManifest pManifest,const std::filesystem::path& pPayloadFile,bool pCompress = false);
+
+// Reads just the manifest, returns false if the file is not a bundle.
+bool ReadBundleManifest(const std::filesystem::path& pBundleFile,BundleManifest& rManifest);
+
+// Extracts the payload, decompressing it if need be, and checks it against the size and hash in the manifest.
+// It is written to a temporay file that is renamed into place so a half written exec is never seen.
+bool ExtractBundlePayload(const std::filesystem::path& pBundleFile,const std::filesystem::path& pPayloadFile);
+
+#endif //#ifndef __BUNDLE_H__
@@ -0,0 +1,217 @@
+/**
+ * @file cache_tier.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include <fstream>
+#include <algorithm>
+
+#include "cache_tier.h"
+#include "build_key.h"
+#include "token_hash.h"
+#include "zygote.h"
+#include "hash.h"
+
+static const char* COLD_BUNDLE_EXTENSION = ".sbz";
+
+/**
+ * @brief The modification time in nanoseconds, zero if the file is not there.
+ */
+static int64_t GetModifiedTime(const std::filesystem::path& pFile,uint64_t* rSize = nullptr)
+{
+	struct stat Stats;
+	if( stat(pFile.c_str(),&Stats) != 0 )
+		return 0;
+
+	if( rSize )
+		*rSize = Stats.st_size;
+	return (int64_t)Stats.st_mtim.tv_sec * 1000000000LL + Stats.st_mtim.tv_nsec;
+}
+
+uint64_t ParseByteSize(const std::string& pSize,uint64_t pDefault)
+{
+	char* end = nullptr;
+	const uint64_t size = strtoull(pSize.c_str(),&end,10);
+	if( pSize.size() == 0 || end == pSize.c_str() )
+		return pDefault;
+
+	switch( *end )
+	{
+	case 0:
+		return size;
+	case 'k':
+	case 'K':
+		return size * 1024ULL;
+	case 'm':
+	case 'M':
+		return size * 1024ULL * 1024ULL;
+	case 'g':
+	case 'G':
+		return size * 1024ULL * 1024ULL * 1024ULL;
+	}
+	return pDefault;
+}
+
+std::filesystem::path GetColdFilename(const std::filesystem::path& pColdFolder,const std::filesystem::path& pExeName)
+{
+	// Normalised, as the exec path is put together with doubled slashes in places.
+	return pColdFolder / (HashToString(HashString(pExeName.lexically_normal().string())) + COLD_BUNDLE_EXTENSION);
+}
+
+bool ColdCopyIsCurrent(const std::filesystem::path& pColdFolder,const std::filesystem::path& pExeName)
+{
+	const int64_t coldTime = GetModifiedTime(GetColdFilename(pColdFolder,pExeName));
+	return coldTime > 0 && coldTime >= GetModifiedTime(pExeName);
+}
+
+void MarkExecutableUsed(const std::filesystem::path& pExeName)
+{
+	const std::filesystem::path keyFile = GetBuildKeyFilename(pExeName);
+	const int64_t lastUsed = GetModifiedTime(keyFile);
+	if( lastUsed > 0 && lastUsed / 1000000000LL + 60 < time(nullptr) )
+	{
+		utimensat(AT_FDCWD,keyFile.c_str(),nullptr,0);
+	}
+}
+
+/**
+ * @brief Every exec in the temp folder with a build key, least recently used first. The cold tier can be inside the temp folder so it is skipped.
+ */
+static std::vector<HotEntry> GetHotEntries(const std::filesystem::path& pTempFolder,const std::filesystem::path& pColdFolder)
+{
+	std::vector<HotEntry> entries;
+	std::error_code ec;
+	for( auto file = std::filesystem::recursive_directory_iterator(pTempFolder,std::filesystem::directory_options::skip_permission_denied,ec) ; file != std::filesystem::recursive_directory_iterator() ; file.increment(ec) )
+	{
+		if( ec )
+			break;
+
+		if( file->is_directory(ec) && std::filesystem::equivalent(file->path(),pColdFolder,ec) )
+		{
+			file.disable_recursion_pending();
+			continue;
+		}
+
+		if( file->path().extension() != ".key" )
+			continue;
+
+		HotEntry entry;
+		entry.mExeName = std::filesystem::path(file->path()).replace_extension();
+		entry.mLastUsed = GetModifiedTime(file->path());
+		if( GetModifiedTime(entry.mExeName,&entry.mSize) > 0 )
+			entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(),entries.end(),[](const HotEntry& pA,const HotEntry& pB){return pA.mLastUsed < pB.mLastUsed;});
+	return entries;
+}
+
+std::vector<std::filesystem::path> GetColdEntries(const std::filesystem::path& pColdFolder)
+{
+	std::vector<std::pair<int64_t,std::filesystem::path>> found;
+	std::error_code ec;
+	for( const auto& file : std::filesystem::directory_iterator(pColdFolder,ec) )
+	{
+		if( file.path().extension() == COLD_BUNDLE_EXTENSION )
+			found.emplace_back(GetModifiedTime(file.path()),file.path());
+	}
+	std::sort(found.begin(),found.end(),[](const auto& pA,const auto& pB){return pA.first > pB.first;});
+
+	std::vector<std::filesystem::path> entries;
+	for( const auto& entry : found )
+		entries.push_back(entry.second);
+	return entries;
+}
+
+void TrimCacheTiers(const std::filesystem::path& pTempFolder,const std::filesystem::path& pColdFolder,uint64_t pHotSize,uint64_t pColdSize)
+{
+	// Held till we return, closing it lets the next one in.
+	const std::filesystem::path lockFile = pColdFolder / ".trim.lock";
+	const int lock = open(lockFile.c_str(),O_RDWR|O_CREAT|O_CLOEXEC,0644);
+	if( lock < 0 || flock(lock,LOCK_EX|LOCK_NB) != 0 )
+	{
+		if( lock >= 0 )
+			close(lock);
+		return;
+	}
+
+	std::error_code ec;
+	if( pHotSize > 0 )
+	{
+		const std::vector<HotEntry> hot = GetHotEntries(pTempFolder,pColdFolder);
+		uint64_t hotSize = 0;
+		for( const HotEntry& entry : hot )
+			hotSize += entry.mSize;
+
+		for( size_t n = 0 ; n < hot.size() && hotSize > pHotSize ; n++ )
+		{
+			// One without a current cold copy is left, removing it would cost a build.
+			if( ColdCopyIsCurrent(pColdFolder,hot[n].mExeName) == false )
+				continue;
+
+			StopZygote(hot[n].mExeName);
+			std::filesystem::remove(hot[n].mExeName,ec);
+			std::filesystem::remove(GetBuildKeyFilename(hot[n].mExeName),ec);
+			std::filesystem::remove(GetTokenHashFilename(hot[n].mExeName),ec);
+			hotSize -= hot[n].mSize;
+		}
+	}
+
+	if( pColdSize > 0 )
+	{
+		uint64_t coldSize = 0;
+		for( const std::filesystem::path& bundle : GetColdEntries(pColdFolder) )
+		{
+			uint64_t size = 0;
+			GetModifiedTime(bundle,&size);
+			coldSize += size;
+			if( coldSize > pColdSize )
+			{
+				std::filesystem::remove(bundle,ec);
+				std::filesystem::remove(std::filesystem::path(bundle) += ".lock",ec);
+			}
+		}
+	}
+
+	close(lock);
+}
+
+bool HotTierNeedsRestore(const std::filesystem::path& pTempFolder)
+{
+	std::string bootID;
+	std::ifstream("/proc/sys/kernel/random/boot_id") >> bootID;
+	if( bootID.size() == 0 )
+		return false;
+
+	const std::filesystem::path bootFile = pTempFolder / ".seabang" / "hot-tier.boot";
+	std::string lastBootID;
+	std::ifstream(bootFile) >> lastBootID;
+	if( lastBootID == bootID )
+		return false;
+
+	std::error_code ec;
+	std::filesystem::create_directories(bootFile.parent_path(),ec);
+	std::ofstream(bootFile,std::ios::trunc) << bootID << "\n";
+	return true;
+}
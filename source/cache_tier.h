@@ -0,0 +1,65 @@
+/**
+ * @file cache_tier.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __CACHE_TIER_H__
+#define __CACHE_TIER_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// With a cold tier the temp folder, which can be on tmpfs, is the hot tier. Every exec built is also written to the cold tier
+// on disk as a compressed bundle. When the execs in the hot tier add up to more than it's size the least recently used are
+// removed from it, they are put back from the cold tier, which is much quicker than building them, when next run.
+// The time an exec was last used is the modification time of it's build key, for the cold tier that of the bundle.
+
+const uint64_t DEFAULT_HOT_TIER_SIZE = 256ULL * 1024ULL * 1024ULL;
+const uint64_t DEFAULT_COLD_TIER_SIZE = 4ULL * 1024ULL * 1024ULL * 1024ULL;
+
+struct HotEntry
+{
+	std::filesystem::path mExeName;
+	uint64_t mSize = 0;
+	int64_t mLastUsed = 0;
+};
+
+// A number of bytes with an optional K, M or G after it. Returns pDefault if it is empty or not a size.
+uint64_t ParseByteSize(const std::string& pSize,uint64_t pDefault);
+
+std::filesystem::path GetColdFilename(const std::filesystem::path& pColdFolder,const std::filesystem::path& pExeName);
+
+// True if the cold tier has a bundle of the exec that is at least as new as the exec.
+bool ColdCopyIsCurrent(const std::filesystem::path& pColdFolder,const std::filesystem::path& pExeName);
+
+// Marks the exec as used now. Only writes when the last mark is more than a minute old, so most runs only pay for a stat.
+void MarkExecutableUsed(const std::filesystem::path& pExeName);
+
+// The bundles in the cold tier, most recently used first.
+std::vector<std::filesystem::path> GetColdEntries(const std::filesystem::path& pColdFolder);
+
+// Removes the least recently used execs from the hot tier, that have a current copy in the cold tier, till it is no bigger than pHotSize.
+// Then removes the least recently used bundles from the cold tier till it is no bigger than pColdSize.
+// Only one seabang does this at a time, if another is already doing it this returns straight away.
+void TrimCacheTiers(const std::filesystem::path& pTempFolder,const std::filesystem::path& pColdFolder,uint64_t pHotSize,uint64_t pColdSize);
+
+// Returns true the first time it is called for the temp folder after the host has booted, when the hot tier is likely to be empty.
+bool HotTierNeedsRestore(const std::filesystem::path& pTempFolder);
+
+#endif //#ifndef __CACHE_TIER_H__
@@ -0,0 +1,386 @@
+/**
+ * @file compile_trace.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <chrono>
+
+#include "compile_trace.h"
+#include "execute_command.h"
+#include "source_scanner.h"
+#include "json.h"
+
+std::filesystem::path GetTimeTraceFilename(const std::filesystem::path& pExeName)
+{
+	return (std::filesystem::path(pExeName) += ".trace.json");
+}
+
+bool IsClangCompiler(const std::string& pCompiler,const std::string& pToolchain)
+{
+	return pCompiler.find("clang") != std::string::npos || pToolchain.find("clang") != std::string::npos;
+}
+
+std::vector<std::string> GetTimeTraceFlags(bool pClang,const std::filesystem::path& pTraceFile)
+{
+	if( pClang )
+		return {"-ftime-trace=" + pTraceFile.string()};
+
+	// -H lists the headers as they are included, we only need it to know which headers to time.
+	return {"-ftime-report","-H"};
+}
+
+static std::string Trim(const std::string& pString)
+{
+	const size_t start = pString.find_first_not_of(" \t|");
+	const size_t end = pString.find_last_not_of(" \t");
+	return start == std::string::npos ? "" : pString.substr(start,end - start + 1);
+}
+
+std::string ParseGccTimeReport(const std::string& pOutput,GccTimeReport& rReport)
+{
+	std::string diagnostics;
+	std::stringstream lines(pOutput);
+	std::string line;
+	bool inTimeReport = false;
+	bool inGuards = false;
+	while( std::getline(lines,line) )
+	{
+		// -H, one dot per level of include.
+		const size_t dots = line.find_first_not_of('.');
+		if( dots > 0 && dots != std::string::npos && line[dots] == ' ' )
+		{
+			if( dots == 1 )
+				rReport.mHeaders.push_back(line.substr(2));
+			continue;
+		}
+
+		// -H also lists the headers without include guards, just the file names.
+		if( line.rfind("Multiple include guards may be useful for:",0) == 0 )
+		{
+			inGuards = true;
+			continue;
+		}
+		if( inGuards )
+		{
+			if( line.size() > 0 && line.find(": ") == std::string::npos )
+				continue;
+			inGuards = false;
+		}
+
+		if( line.rfind("Time variable",0) == 0 )
+		{
+			inTimeReport = true;
+			continue;
+		}
+
+		if( inTimeReport )
+		{
+			const size_t colon = line.rfind(" :");
+			if( colon != std::string::npos )
+			{
+				const std::string name = Trim(line.substr(0,colon));
+				const char* times = line.c_str() + colon + 2;
+				double user,system,wall;
+				if( name == "TOTAL" )
+				{
+					if( sscanf(times,"%lf %lf %lf",&user,&system,&wall) == 3 )
+						rReport.mTotalSeconds = wall;
+					inTimeReport = false;
+				}
+				else if( sscanf(times," %lf ( %*d%%) %lf ( %*d%%) %lf",&user,&system,&wall) == 3 )
+				{
+					TraceTiming timing;
+					timing.mName = name;
+					timing.mSeconds = wall;
+					if( name.rfind("phase ",0) == 0 )
+						rReport.mPhases.push_back(timing);
+					else
+						rReport.mPasses.push_back(timing);
+				}
+				continue;
+			}
+			if( line.size() == 0 )
+				continue;
+			inTimeReport = false;
+		}
+
+		diagnostics += line + "\n";
+	}
+	return diagnostics;
+}
+
+void MeasureHeaderTimes(const std::string& pCompiler,const std::vector<std::string>& pFlags,const std::filesystem::path& pScratchFile,const std::vector<std::string>& pHeaders,std::vector<TraceTiming>& rTimes)
+{
+	auto timeCompile = [&](const std::string& pSource)
+	{
+		{
+			std::ofstream file(pScratchFile,std::ios::trunc);
+			file << pSource;
+		}
+
+		std::vector<std::string> args = pFlags;
+		args.push_back("-fsyntax-only");
+		args.push_back("-x");
+		args.push_back("c++");
+		args.push_back(pScratchFile);
+
+		std::string output;
+		const auto start = std::chrono::steady_clock::now();
+		ExecuteShellCommand(pCompiler,args,output);
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	// Starting the compiler is not the header's fault.
+	const double baseline = timeCompile("");
+
+	std::vector<std::string> headers = pHeaders;
+	std::sort(headers.begin(),headers.end());
+	headers.erase(std::unique(headers.begin(),headers.end()),headers.end());
+	for( const std::string& header : headers )
+	{
+		TraceTiming timing;
+		timing.mName = header;
+		timing.mSeconds = std::max(0.0,timeCompile("#include \"" + header + "\"\n") - baseline);
+		rTimes.push_back(timing);
+	}
+
+	std::error_code ec;
+	std::filesystem::remove(pScratchFile,ec);
+}
+
+/**
+ * @brief Writes one complete event, times in seconds are written as micro seconds as the format wants.
+ */
+static void WriteTraceEvent(std::ostream& pStream,const std::string& pName,int pThread,double pStart,double pDuration,const std::string& pDetail)
+{
+	pStream << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << pThread << ",\"name\":" << JsonQuote(pName)
+			<< std::fixed << std::setprecision(0) << ",\"ts\":" << pStart * 1000000.0 << ",\"dur\":" << pDuration * 1000000.0;
+	if( pDetail.size() > 0 )
+		pStream << ",\"args\":{\"detail\":" << JsonQuote(pDetail) << "}";
+	pStream << "}";
+}
+
+static void WriteThreadName(std::ostream& pStream,int pThread,const std::string& pName)
+{
+	pStream << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << pThread << ",\"name\":\"thread_name\",\"args\":{\"name\":" << JsonQuote(pName) << "}}";
+}
+
+bool WriteGccTimeTrace(const std::filesystem::path& pTraceFile,const std::string& pSourceName,const GccTimeReport& pReport,const std::vector<TraceTiming>& pHeaderTimes)
+{
+	const std::filesystem::path tempFile = (std::filesystem::path(pTraceFile) += "." + std::to_string(getpid()));
+	{
+		std::ofstream file(tempFile,std::ios::trunc);
+		file << "{\"traceEvents\":[\n";
+		file << "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":" << JsonQuote(pSourceName) << "}}";
+		WriteThreadName(file,1,"phases");
+		WriteThreadName(file,2,"passes");
+		WriteThreadName(file,3,"headers, each compiled on it's own");
+
+		// The same name clang uses for the whole compile, so the report can treat them the same.
+		WriteTraceEvent(file,"ExecuteCompiler",1,0.0,pReport.mTotalSeconds,"");
+
+		// gcc only gives totals, so they are laid end to end.
+		double start = 0.0;
+		for( const TraceTiming& phase : pReport.mPhases )
+		{
+			WriteTraceEvent(file,phase.mName,1,start,phase.mSeconds,"");
+			start += phase.mSeconds;
+		}
+
+		start = 0.0;
+		for( const TraceTiming& pass : pReport.mPasses )
+		{
+			WriteTraceEvent(file,pass.mName,2,start,pass.mSeconds,"");
+			start += pass.mSeconds;
+		}
+
+		start = 0.0;
+		for( const TraceTiming& header : pHeaderTimes )
+		{
+			WriteTraceEvent(file,"Source",3,start,header.mSeconds,header.mName);
+			start += header.mSeconds;
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		if( !file )
+			return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempFile,pTraceFile,ec);
+	return ec ? false : true;
+}
+
+struct ReportTotal
+{
+	double mSeconds = 0.0;
+	int mCount = 0;
+};
+
+typedef std::map<std::string,ReportTotal> ReportTotals;
+
+static void PrintTop(const std::string& pTitle,const ReportTotals& pTotals,int pTop,const char* pEmptyNote)
+{
+	std::vector<std::pair<std::string,ReportTotal>> sorted(pTotals.begin(),pTotals.end());
+	std::sort(sorted.begin(),sorted.end(),[](const auto& a,const auto& b){return a.second.mSeconds > b.second.mSeconds;});
+
+	std::cout << "\n" << pTitle << "\n";
+	std::cout << std::right << std::setw(12) << "total ms" << std::setw(8) << "count" << "  name\n";
+	if( sorted.size() == 0 )
+		std::cout << "  " << pEmptyNote << "\n";
+
+	for( size_t n = 0 ; n < sorted.size() && (int)n < pTop ; n++ )
+	{
+		std::cout << std::right << std::fixed << std::setprecision(1) << std::setw(12) << sorted[n].second.mSeconds * 1000.0
+				<< std::setw(8) << sorted[n].second.mCount << "  " << sorted[n].first << "\n";
+	}
+}
+
+int CompileReport(const std::filesystem::path& pTempFolder,const std::filesystem::path& pTraceOut,int pTop)
+{
+	ReportTotals scripts,headers,templates,phases;
+
+	std::ofstream traceOut;
+	if( pTraceOut.empty() == false )
+	{
+		traceOut.open(pTraceOut,std::ios::trunc);
+		if( !traceOut )
+		{
+			std::cerr << "Failed to open " << pTraceOut << " to write the trace to\n";
+			return EXIT_FAILURE;
+		}
+		traceOut << "{\"traceEvents\":[\n";
+	}
+	bool firstEvent = true;
+	int process = 0;
+
+	std::error_code ec;
+	const std::string suffix = ".trace.json";
+	for( auto it = std::filesystem::recursive_directory_iterator(pTempFolder,std::filesystem::directory_options::skip_permission_denied,ec) ; it != std::filesystem::recursive_directory_iterator() ; it.increment(ec) )
+	{
+		const std::string filename = it->path().string();
+		if( filename.size() <= suffix.size() || filename.compare(filename.size() - suffix.size(),suffix.size(),suffix) != 0 )
+			continue;
+
+		MappedFile file(it->path());
+		JsonValue trace;
+		if( file.IsOpen() == false || ParseJson(file.Data(),file.Size(),trace) == false )
+		{
+			std::cerr << "Skipping " << it->path() << ", it is not valid json\n";
+			continue;
+		}
+
+		// Either an object with the events in traceEvents or just the array of events.
+		JsonValue* events = &trace;
+		for( auto& member : trace.mObject )
+		{
+			if( member.first == "traceEvents" )
+				events = &member.second;
+		}
+
+		// The cache mirrors the source's path, so the path in the temp folder is the script's, with the variant added.
+		std::string script = it->path().lexically_relative(pTempFolder).string();
+		script = "/" + script.substr(0,script.size() - suffix.size());
+		process++;
+		double scriptSeconds = 0.0;
+
+		for( JsonValue& event : events->mArray )
+		{
+			const std::string phase = event.GetString("ph");
+			const std::string name = event.GetString("name");
+			if( phase == "X" )
+			{
+				const double seconds = event.GetNumber("dur") / 1000000.0;
+				const JsonValue* args = event.Find("args");
+				const std::string detail = args ? args->GetString("detail") : "";
+
+				if( name == "ExecuteCompiler" )
+					scriptSeconds = std::max(scriptSeconds,seconds);
+				else if( name == "Source" && detail.size() > 0 )
+				{
+					headers[detail].mSeconds += seconds;
+					headers[detail].mCount++;
+				}
+				else if( name.rfind("Instantiate",0) == 0 && detail.size() > 0 )
+				{
+					templates[detail].mSeconds += seconds;
+					templates[detail].mCount++;
+				}
+				else if( name.rfind("Total ",0) != 0 )
+				{
+					phases[name].mSeconds += seconds;
+					phases[name].mCount++;
+				}
+			}
+
+			if( traceOut.is_open() && (phase != "M" || name != "process_name") )
+			{
+				for( auto& member : event.mObject )
+				{
+					if( member.first == "pid" )
+					{
+						member.second.mType = JsonValue::JSON_NUMBER;
+						member.second.mNumber = process;
+					}
+				}
+				traceOut << (firstEvent ? "" : ",\n");
+				WriteJson(traceOut,event);
+				firstEvent = false;
+			}
+		}
+
+		scripts[script].mSeconds += scriptSeconds;
+		scripts[script].mCount++;
+
+		if( traceOut.is_open() )
+		{
+			traceOut << (firstEvent ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":" << process << ",\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":" << JsonQuote(script) << "}}";
+			firstEvent = false;
+		}
+	}
+
+	if( traceOut.is_open() )
+	{
+		traceOut << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	}
+
+	if( process == 0 )
+	{
+		std::cout << "No compile traces found in " << pTempFolder << ", build with --seabang-time-trace to make them.\n";
+		return EXIT_SUCCESS;
+	}
+
+	std::cout << "seabang compile report, " << process << " traced builds in " << pTempFolder << "\n";
+	PrintTop("Scripts, by compile time",scripts,pTop,"None");
+	PrintTop("Headers, time to compile each one including what it includes",headers,pTop,"None");
+	PrintTop("Templates, time instantiating",templates,pTop,"None, only clang's -ftime-trace times templates, with gcc see the template instantiation phase");
+	PrintTop("Compiler phases and passes",phases,pTop,"None");
+	if( pTraceOut.empty() == false )
+	{
+		std::cout << "\nMerged trace written to " << pTraceOut << "\n";
+	}
+	return EXIT_SUCCESS;
+}
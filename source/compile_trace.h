@@ -0,0 +1,65 @@
+/**
+ * @file compile_trace.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __COMPILE_TRACE_H__
+#define __COMPILE_TRACE_H__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Where the compile is timed the trace is kept next to the exec as <exec>.trace.json, in the chrome trace event format.
+// Clang writes it with -ftime-trace. For gcc it is made from the -ftime-report output, and the headers included by
+// the source are timed by compiling each on it's own, as gcc has no per header timings.
+
+struct TraceTiming
+{
+	std::string mName;
+	double mSeconds = 0.0;
+};
+
+// What gcc's -ftime-report and -H told us.
+struct GccTimeReport
+{
+	std::vector<TraceTiming> mPhases;	// The top level phases, these add up to the total.
+	std::vector<TraceTiming> mPasses;	// The rest, they overlap the phases.
+	double mTotalSeconds = 0.0;
+	std::vector<std::string> mHeaders;	// The headers the source includes directly.
+};
+
+std::filesystem::path GetTimeTraceFilename(const std::filesystem::path& pExeName);
+
+bool IsClangCompiler(const std::string& pCompiler,const std::string& pToolchain);
+
+// The extra compiler args needed to time the compile.
+std::vector<std::string> GetTimeTraceFlags(bool pClang,const std::filesystem::path& pTraceFile);
+
+// Takes gcc's timings and include tree out of the compile output, what is left is returned so the diagnostics can still be shown.
+std::string ParseGccTimeReport(const std::string& pOutput,GccTimeReport& rReport);
+
+// Times how long each header takes to compile on it's own with the flags given, less the time to compile an empty file.
+void MeasureHeaderTimes(const std::string& pCompiler,const std::vector<std::string>& pFlags,const std::filesystem::path& pScratchFile,const std::vector<std::string>& pHeaders,std::vector<TraceTiming>& rTimes);
+
+bool WriteGccTimeTrace(const std::filesystem::path& pTraceFile,const std::string& pSourceName,const GccTimeReport& pReport,const std::vector<TraceTiming>& pHeaderTimes);
+
+// Reads all the traces in the temp folder and writes the most expensive scripts, headers, templates and phases to std::cout.
+// If pTraceOut is not empty the traces are also merged into that file, each script as a process, to load into a trace viewer.
+int CompileReport(const std::filesystem::path& pTempFolder,const std::filesystem::path& pTraceOut,int pTop);
+
+#endif //#ifndef __COMPILE_TRACE_H__
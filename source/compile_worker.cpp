@@ -0,0 +1,222 @@
+/**
+ * @file compile_worker.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <sstream>
+#include <future>
+#include <chrono>
+#include <algorithm>
+
+#include "compile_worker.h"
+#include "worker_flags.h"
+#include "http_client.h"
+
+struct WorkerStatus
+{
+	std::string mURL;
+	std::string mCompilerVersion;
+	int mRunning = 0;	// Compiles running and waiting on the worker.
+	int mSlots = 0;		// How many it runs at once.
+};
+
+/**
+ * @brief Flags that only matter to the preprocessor or the linker, both of which are run here.
+ */
+static bool IsLocalOnlyFlag(const std::string& pFlag)
+{
+	for( const char* prefix : {"-l","-L","-I","-D","-U","-Wl,","-static","-shared","-rdynamic","-no-pie","-pie"} )
+	{
+		if( pFlag.rfind(prefix,0) == 0 )
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @brief The first line of --version starts with the name the compiler was run as, c++ and g++ are the same compiler.
+ */
+static std::string StripProgramName(const std::string& pVersion)
+{
+	const size_t space = pVersion.find(' ');
+	return space == std::string::npos ? pVersion : pVersion.substr(space + 1);
+}
+
+static bool GetWorkerStatus(const std::string& pWorker,const std::string& pToken,int pTimeoutMS,WorkerStatus& rStatus)
+{
+	int status;
+	std::string response,error;
+	if( HttpRequest("GET",pWorker + "/status",{},pToken,pTimeoutMS,status,response,error) == false || status != 200 )
+		return false;
+
+	rStatus.mURL = pWorker;
+	std::istringstream lines(response);
+	std::string line;
+	while( std::getline(lines,line) )
+	{
+		const size_t space = line.find(' ');
+		const std::string name = line.substr(0,space);
+		const std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+		if( name == "running" )
+			rStatus.mRunning = atoi(value.c_str());
+		else if( name == "slots" )
+			rStatus.mSlots = atoi(value.c_str());
+		else if( name == "compiler-version" )
+			rStatus.mCompilerVersion = value;
+	}
+	return rStatus.mSlots > 0;
+}
+
+static int GetMillisecondsLeft(const Deadline& pDeadline)
+{
+	const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(pDeadline - std::chrono::steady_clock::now()).count();
+	return left > 0 ? (int)left : 0;
+}
+
+std::vector<std::string> ParseWorkerList(const std::string& pWorkers)
+{
+	std::vector<std::string> workers;
+	std::istringstream list(pWorkers);
+	std::string worker;
+	while( std::getline(list,worker,',') )
+	{
+		while( worker.size() > 0 && worker.back() == '/' )
+			worker.pop_back();
+
+		if( worker.size() == 0 )
+			continue;
+
+		if( worker.rfind("http://",0) != 0 )
+			worker = "http://" + worker;
+		workers.push_back(worker);
+	}
+	return workers;
+}
+
+bool GetWorkerCompileFlags(const std::vector<std::string>& pFlags,std::vector<std::string>& rWorkerFlags)
+{
+	for( const std::string& flag : pFlags )
+	{
+		if( IsLocalOnlyFlag(flag) )
+			continue;
+
+		if( IsWorkerFlag(flag) == false )
+			return false;
+		rWorkerFlags.push_back(flag);
+	}
+	return true;
+}
+
+bool CompileOnWorkers(const std::vector<std::string>& pWorkers,const std::string& pCompilerVersion,const std::vector<std::string>& pFlags,
+					const std::filesystem::path& pPreprocessedFile,const std::filesystem::path& pObjectFile,const std::string& pToken,int pTimeoutMS,
+					std::string& rWorker,std::string& rOutput,std::string& rError)
+{
+	const Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMS);
+
+	// Asked all at once, so a worker that is down costs the status timeout once and not once for each of them.
+	std::vector<WorkerStatus> statuses(pWorkers.size());
+	std::vector<std::future<bool>> answers;
+	for( size_t n = 0 ; n < pWorkers.size() ; n++ )
+	{
+		answers.push_back(std::async(std::launch::async,GetWorkerStatus,std::cref(pWorkers[n]),std::cref(pToken),std::min(pTimeoutMS,COMPILE_WORKER_STATUS_TIMEOUT_MS),std::ref(statuses[n])));
+	}
+
+	std::vector<WorkerStatus> ready;
+	for( size_t n = 0 ; n < pWorkers.size() ; n++ )
+	{
+		if( answers[n].get() && StripProgramName(statuses[n].mCompilerVersion) == StripProgramName(pCompilerVersion) )
+			ready.push_back(statuses[n]);
+	}
+
+	if( ready.size() == 0 )
+	{
+		rError = "no worker with " + pCompilerVersion + " answered";
+		return false;
+	}
+
+	// Least loaded first, by the share of it's slots that would be taken with our compile.
+	std::stable_sort(ready.begin(),ready.end(),[](const WorkerStatus& pA,const WorkerStatus& pB)
+	{
+		return (int64_t)(pA.mRunning + 1) * pB.mSlots < (int64_t)(pB.mRunning + 1) * pA.mSlots;
+	});
+
+	std::string request = "compiler-version " + pCompilerVersion + "\n";
+	for( const std::string& flag : pFlags )
+	{
+		request += "flag " + flag + "\n";
+	}
+	request += "\n";
+
+	std::ifstream source(pPreprocessedFile,std::ios::binary);
+	std::stringstream sourceText;
+	if( !(sourceText << source.rdbuf()) )
+	{
+		rError = "could not read " + pPreprocessedFile.string();
+		return false;
+	}
+	request += sourceText.str();
+
+	for( const WorkerStatus& worker : ready )
+	{
+		const int timeLeft = GetMillisecondsLeft(deadline);
+		if( timeLeft <= 0 )
+		{
+			rError = "timed out";
+			return false;
+		}
+
+		int status;
+		std::string response,error;
+		if( HttpRequest("POST",worker.mURL + "/compile",request,pToken,timeLeft,status,response,error) == false )
+		{
+			rError = worker.mURL + " " + error;
+			continue;
+		}
+
+		// It did not compile, it won't on any other worker either. Left for the compile here to say why.
+		if( status == 422 )
+		{
+			rError = "the compile failed on " + worker.mURL;
+			return false;
+		}
+
+		const size_t outputStart = response.find('\n') + 1;
+		const size_t outputSize = strtoull(response.c_str(),nullptr,10);
+		if( status != 200 || outputStart == 0 || outputSize > response.size() - outputStart )
+		{
+			rError = worker.mURL + " said " + std::to_string(status);
+			continue;
+		}
+
+		std::ofstream object(pObjectFile,std::ios::binary|std::ios::trunc);
+		object.write(response.data() + outputStart + outputSize,response.size() - outputStart - outputSize);
+		object.close();
+		if( !object )
+		{
+			rError = "could not write " + pObjectFile.string();
+			return false;
+		}
+
+		rWorker = worker.mURL;
+		rOutput = response.substr(outputStart,outputSize);
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file compile_worker.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __COMPILE_WORKER_H__
+#define __COMPILE_WORKER_H__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Compile workers are hosts that compile for seabang, tools/seabang-compile-worker.cpp is one. The source is preprocessed here,
+// so the workers do not need the headers, and sent with the flags to the least loaded worker that has the same compiler.
+// The object comes back and is linked here. If no worker can do it in time it is compiled here as it would have been.
+// Workers are reached over http. GET /status says how busy the worker is and which compiler it has, as lines of name value.
+// POST /compile takes lines of compiler-version and flag, a blank line and the preprocessed source. The response is the
+// length of what the compiler said on a line, what it said and then the object.
+// A worker runs the compiler on what it's sent, so they are given a token that seabang sends as the bearer token, from the
+// SEABANG_WORKER_TOKEN environment variable.
+
+const int COMPILE_WORKER_DEFAULT_TIMEOUT_MS = 60000;
+const int COMPILE_WORKER_STATUS_TIMEOUT_MS = 500;
+
+// The workers from a comma separated list of host:port, or http://host:port.
+std::vector<std::string> ParseWorkerList(const std::string& pWorkers);
+
+// Picks out the flags that matter when compiling preprocessed source. Returns false if there is one that means it has to be
+// compiled here, one the worker does not allow or one that writes more than the object, such as --coverage.
+bool GetWorkerCompileFlags(const std::vector<std::string>& pFlags,std::vector<std::string>& rWorkerFlags);
+
+// Compiles the preprocessed source on the least loaded worker with the same compiler version, trying the next if that fails,
+// till the timeout is up. pToken, if not empty, is sent as the bearer token. rWorker is the one that did it and rOutput what
+// the compiler said.
+bool CompileOnWorkers(const std::vector<std::string>& pWorkers,const std::string& pCompilerVersion,const std::vector<std::string>& pFlags,
+					const std::filesystem::path& pPreprocessedFile,const std::filesystem::path& pObjectFile,const std::string& pToken,int pTimeoutMS,
+					std::string& rWorker,std::string& rOutput,std::string& rError);
+
+#endif //#ifndef __COMPILE_WORKER_H__
@@ -15,110 +15,258 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
    
 #include <sys/stat.h>
-#include <fstream>
-#include <iostream>
 #include <assert.h>
+#include <algorithm>
 
 #include "dependencies.h"
+#include "source_scanner.h"
+#include "hash.h"
 
-Dependencies::Dependencies()
+Dependencies::Dependencies():
+	mRebuildTriggerTime{0,0}
 {
 
 }
 
 bool Dependencies::RequiresRebuild(const std::filesystem::path& pSourceFile,const std::filesystem::path& pObjectFile,const PathVec& pIncludePaths)
 {
-	// Add the path of the source file we're checking to the include paths. Has to be done in a way so that we don't pollute the passed in paths. Hence the copy and the passing in of the params as const. Stops bugs!!!!
-	PathVec IncludePaths = pIncludePaths;
-	const std::string srcPath = std::filesystem::path(pSourceFile).remove_filename();
-	if( !srcPath.empty() )
-		IncludePaths.push_back(srcPath);
+	SetSearchPaths(pSourceFile,pIncludePaths);
 
+	mRebuildTrigger.clear();
+	mRebuildTriggerFile = NO_FILE;
+	mRebuildTriggerTime = {0,0};
 
 	// Everything works from the object file's modification date. If any of the dependencies are younger than the object file then the source file needs building.
+	// Get the object files info, if this fails then the file is not there, if it is not a regular file then that is wrong and so will rebuild it too.
 	timespec ObjFileTime;
+	// It's not shared, one built by another seabang a moment ago would look out of date.
+	if( GetFileTime(InternPath(pObjectFile.native()),ObjFileTime,false) == false )
+	{
+		// Obj not there, so build it.
+		return true;
+	}
 
-	// We have to reset this for each source file as it is information respect to the source files object file date.
-	// This map is also what helps to stop us getting into recursive loop. When it is not in this map we parse it too see what headers it has.
-	// After that it is added with the state of being older or newer. This also prevents it being parsed a second time.
-	// File headers found in a file are cached for each file and don't need to be and are not cleared. So the header is only parsed once.
-	mFileDependencyState.clear();
-	mFileCheckedState.clear();// This one is used to stop recursion.
+	// Walk the includes depth first, each file is only looked at once so include loops are not a problem.
+	// The visited marks are the walk's epoch, so they don't have to be cleared for each walk.
+	StartWalk();
+	const FileID source = InternPath(pSourceFile.native());
+	mFiles[source].mVisited = mEpoch;
+	mFiles[source].mIncludedBy = NO_FILE;
+	mToVisit.push_back(source);
+	while( mToVisit.size() > 0 )
+	{
+		const FileID file = mToVisit.back();
+		mToVisit.pop_back();
 
-	// Get the object files info, if this fails then the file is not there, if it is not a regular file then that is wrong and so will rebuild it too.
-	if( GetFileTime(pObjectFile,ObjFileTime) )
+		if( FileYoungerThanObjectFile(file,ObjFileTime) )
+		{
+			// Record what caused it, if the file is missing the time is left as zero.
+			mRebuildTrigger = GetPath(file);
+			mRebuildTriggerFile = file;
+			GetFileTime(file,mRebuildTriggerTime);
+			mToVisit.clear();
+			return true;
+		}
+
+		if( ScanIncludes(file) )
+		{
+			// Pushed in reverse so they are checked in the order they are included.
+			const FileNode& node = mFiles[file];
+			for( size_t n = node.mIncludesStart + node.mIncludesCount ; n > node.mIncludesStart ; n-- )
+			{
+				const FileID include = mIncludes[n - 1];
+				if( mFiles[include].mVisited != mEpoch )
+				{
+					mFiles[include].mVisited = mEpoch;
+					mFiles[include].mIncludedBy = file;
+					mToVisit.push_back(include);
+				}
+			}
+		}
+	}
+
+	// Get here then all is up to date.
+	return false;
+}
+
+void Dependencies::GetRebuildChain(PathVec& rChain)const
+{
+	// The walk that found the trigger left each file it saw with the file it was included by, so follow them back to the source.
+	rChain.clear();
+	for( FileID file = mRebuildTriggerFile ; file != NO_FILE ; file = mFiles[file].mIncludedBy )
 	{
-		return CheckSourceDependencies(pSourceFile,ObjFileTime,IncludePaths);
+		rChain.emplace_back(GetPath(file));
 	}
+	std::reverse(rChain.begin(),rChain.end());
+}
 
-	// Obj not there, so build it.
-	return true;
+void Dependencies::GetDependencies(const std::filesystem::path& pSourceFile,const PathVec& pIncludePaths,PathVec& rDependencies)
+{
+	SetSearchPaths(pSourceFile,pIncludePaths);
+
+	StartWalk();
+	const FileID source = InternPath(pSourceFile.native());
+	mFiles[source].mVisited = mEpoch;
+	mToVisit.push_back(source);
+	rDependencies.clear();
+	while( mToVisit.size() > 0 )
+	{
+		const FileID file = mToVisit.back();
+		mToVisit.pop_back();
+		if( file != source )
+			rDependencies.emplace_back(GetPath(file));
+
+		if( ScanIncludes(file) )
+		{
+			const FileNode& node = mFiles[file];
+			for( size_t n = node.mIncludesStart ; n < node.mIncludesStart + node.mIncludesCount ; n++ )
+			{
+				const FileID include = mIncludes[n];
+				if( mFiles[include].mVisited != mEpoch )
+				{
+					mFiles[include].mVisited = mEpoch;
+					mToVisit.push_back(include);
+				}
+			}
+		}
+	}
+
+	std::sort(rDependencies.begin(),rDependencies.end());
 }
 
-bool Dependencies::CheckSourceDependencies(const std::filesystem::path& pSourceFile,const timespec& pObjFileTime,const PathVec& pIncludePaths)
+void Dependencies::SetSearchPaths(const std::filesystem::path& pSourceFile,const PathVec& pIncludePaths)
 {
-	// Check that we have not already checked this file.
-	auto found = mFileDependencyState.find(pSourceFile);
-	if( found != mFileDependencyState.end() )
-	{// File already been processed so stop and return the outcome.
-		return found->second;
+	// The folder of the source file being checked is searched too. Each path is kept with a trailing slash, ready for the include to be appended.
+	mSearchPaths.clear();
+	for( const std::filesystem::path& path : pIncludePaths )
+	{
+		mSearchPaths.push_back(path.native());
 	}
 
-	// Start the source file for a start then move onto scanning the file.
-	if( FileYoungerThanObjectFile(pSourceFile,pObjFileTime) )
+	const std::string srcPath = std::filesystem::path(pSourceFile).remove_filename();
+	if( !srcPath.empty() )
+		mSearchPaths.push_back(srcPath);
+
+	for( std::string& path : mSearchPaths )
 	{
-		return true;
+		if( path.size() > 0 && path.back() != '/' )
+			path += '/';
 	}
+}
 
-	// Get all the includes from the file.
-	PathSet Includes;
-	if( GetIncludesFromFile(pSourceFile,pIncludePaths,Includes) )
+Dependencies::FileID Dependencies::InternPath(std::string_view pPath)
+{
+	const uint64_t hash = HashBytes(pPath.data(),pPath.size());
+	size_t mask = mPathTable.size() - 1;
+	if( mPathTable.size() > 0 )
 	{
-		// Now check their dependencies.....
-		for( std::string filename : Includes )
+		for( size_t slot = hash & mask ; mPathTable[slot] != 0 ; slot = (slot + 1) & mask )
 		{
-			if( mFileCheckedState[filename] == false )
-			{
-				mFileCheckedState[filename] = true;
-				bool result = CheckSourceDependencies(filename,pObjFileTime,pIncludePaths);
-				mFileDependencyState[filename] = result;
-				if( result )
-					return true;
-			}
+			const FileID found = mPathTable[slot] - 1;
+			if( mFiles[found].mHash == hash && GetPath(found) == pPath )
+				return found;
 		}
 	}
 
-	// Get here then all is up to date.
-	return false;
+	// Not seen it before, kept under half full so the probes stay short.
+	if( (mFiles.size() + 1) * 2 > mPathTable.size() )
+	{
+		GrowPathTable();
+		mask = mPathTable.size() - 1;
+	}
+
+	const FileID file = (FileID)mFiles.size();
+	FileNode node = {};
+	node.mHash = hash;
+	node.mPathStart = mPathChars.size();
+	node.mPathLength = (uint32_t)pPath.size();
+	node.mStatState = STAT_UNKNOWN;
+	mFiles.push_back(node);
+	mPathChars.append(pPath.data(),pPath.size());
+
+	size_t slot = hash & mask;
+	while( mPathTable[slot] != 0 )
+		slot = (slot + 1) & mask;
+	mPathTable[slot] = file + 1;
+
+	return file;
+}
+
+void Dependencies::GrowPathTable()
+{
+	std::vector<uint32_t> table(mPathTable.size() > 0 ? mPathTable.size() * 2 : 1024,0);
+	const size_t mask = table.size() - 1;
+	for( FileID file = 0 ; file < (FileID)mFiles.size() ; file++ )
+	{
+		size_t slot = mFiles[file].mHash & mask;
+		while( table[slot] != 0 )
+			slot = (slot + 1) & mask;
+		table[slot] = file + 1;
+	}
+	mPathTable.swap(table);
 }
 
-bool Dependencies::GetFileTime(const std::filesystem::path& pFilename,timespec& rFileTime)
+void Dependencies::StartWalk()
+{
+	mToVisit.clear();
+	mEpoch++;
+	if( mEpoch == 0 )
+	{// Wrapped, so the old marks could look like this walk's.
+		for( FileNode& node : mFiles )
+			node.mVisited = 0;
+		mEpoch = 1;
+	}
+}
+
+bool Dependencies::GetFileTime(FileID pFile,timespec& rFileTime,bool pShared)
 {// I cache file times and the headers found in a file. Gives a very nice speed up.
-	FileTimeMap::iterator found = mFileTimes.find(pFilename);
-	if( found != mFileTimes.end() )
+	FileNode& node = mFiles[pFile];
+	if( node.mStatState == STAT_UNKNOWN )
 	{
-		rFileTime = found->second;
-		return true;
+		// The path is in the middle of mPathChars so needs it's own terminator for stat.
+		mPathScratch = GetPath(pFile);
+
+		SharedStat fileStat;
+		const bool shared = mSharedCache && pShared;
+		if( shared == false || mSharedCache->GetStat(mPathScratch,fileStat) == false )
+		{
+			struct stat Stats;
+			if( stat(mPathScratch.c_str(), &Stats) == 0 && S_ISREG(Stats.st_mode) )
+			{
+				fileStat.mFound = true;
+				fileStat.mTime = Stats.st_mtim;
+				fileStat.mDevice = Stats.st_dev;
+				fileStat.mInode = Stats.st_ino;
+				fileStat.mSize = Stats.st_size;
+			}
+
+			if( shared )
+				mSharedCache->PutStat(mPathScratch,fileStat);
+		}
+
+		node.mStatState = fileStat.mFound ? STAT_FOUND : STAT_MISSING;
+		node.mTime = fileStat.mTime;
+		node.mDevice = fileStat.mDevice;
+		node.mInode = fileStat.mInode;
+		node.mSize = fileStat.mSize;
 	}
 
-	FileStats Stats;
-	if( stat(pFilename.c_str(), &Stats) == 0 && S_ISREG(Stats.st_mode) )
+	if( node.mStatState == STAT_FOUND )
 	{
-		rFileTime = Stats.st_mtim;
-		mFileTimes[pFilename] = Stats.st_mtim;
+		rFileTime = node.mTime;
 		return true;
 	}
 	// File not found.
 	return false;
 }
 
-bool Dependencies::FileYoungerThanObjectFile(const std::filesystem::path& pFilename,const timespec& pObjFileTime)
+bool Dependencies::FileYoungerThanObjectFile(FileID pFile,const timespec& pObjFileTime)
 {
 	timespec OtherTime;
 	// Get the dependency file's info, if this fails then the file is not there.
 	// Unlike the object file, if not here then that is an error and I need to invoke a rebuild of the source file.
 	// If I do not do this then you could delete a used header and not know that the file does not build till you modify it.
-	if( GetFileTime(pFilename,OtherTime) )
+	if( GetFileTime(pFile,OtherTime) )
 	{
 		return FileYoungerThanObjectFile(OtherTime,pObjFileTime);
 	}
@@ -134,85 +282,80 @@ bool Dependencies::FileYoungerThanObjectFile(const timespec& pOtherTime,const ti
 		return pOtherTime.tv_sec > pObjFileTime.tv_sec;
 }
 
-bool Dependencies::GetIncludesFromFile(const std::filesystem::path& pFilename,const PathVec& pIncludePaths,PathSet& rIncludes)
+bool Dependencies::ScanIncludes(FileID pFile)
 {
-	assert( pFilename.empty() == false );
-	assert( pIncludePaths.size() > 0 );
-	assert( rIncludes.size() < 1000  );
+	assert( mSearchPaths.size() > 0 );
+
+	// Each file is only ever scanned once, after that it's includes are where the scan left them.
+	if( mFiles[pFile].mScanned )
+		return mFiles[pFile].mOpened;
 
-	// First see if we have not already parsed this header, if so send back the stuff we found.
-	// Caches the found headers in a file between each dependency check is a very nice speed up.
-	DependencyMap::const_iterator already_done = mDependencies.find(pFilename);
-	if( already_done != mDependencies.end() )
+	// The file is memory mapped and scanned in place. The includes found are added to the end of mIncludes, as no other file
+	// is scanned while this one is they are all together. The include is looked for with GetFileTime so that the stat is
+	// cached, it'll be needed again when checking it's age.
+	const size_t includesStart = mIncludes.size();
+	auto findInclude = [&](const char* pName,size_t pLength)
 	{
-		rIncludes = already_done->second;
-		return true;
-	}
+		// Now see if we can find it.
+		for( const std::string& path : mSearchPaths )
+		{
+			mPathScratch = path;
+			mPathScratch.append(pName,pLength);
+
+			const FileID include = InternPath(mPathScratch);
+			timespec IncludeTime;
+			if( GetFileTime(include,IncludeTime) )
+			{
+				mIncludes.push_back(include);
+				break;
+			}
+		}
+	};
 
-	assert(mDependencies.size() < 1000 );
+	// If another seabang has scanned the file, as it is now, the names it found are used and the file is not read.
+	// The names are still looked for here, the search paths may not be the same.
+	bool opened;
+	SharedStat signature;
+	timespec fileTime;
+	if( mSharedCache && GetFileTime(pFile,fileTime) )
+	{
+		const FileNode& node = mFiles[pFile];
+		signature.mFound = true;
+		signature.mTime = node.mTime;
+		signature.mDevice = node.mDevice;
+		signature.mInode = node.mInode;
+		signature.mSize = node.mSize;
+	}
 
-	std::ifstream file(pFilename);
-	if( file.is_open() )
+	if( mSharedCache && mSharedCache->GetIncludes(signature,mNamesScratch) )
 	{
-		while( file.eof() == false )
+		for( size_t start = 0, end ; (end = mNamesScratch.find('\0',start)) != std::string::npos ; start = end + 1 )
 		{
-			std::string aLine;
-			std::getline(file,aLine);
-			if( aLine.size() >= 12 )// Has to be >= than 12 for #include <a> the shortest incarnation.
+			findInclude(mNamesScratch.data() + start,end - start);
+		}
+		opened = true;
+	}
+	else
+	{
+		mNamesScratch.clear();
+		opened = ScanIncludesInFile(std::filesystem::path(GetPath(pFile)),[&](const char* pName,size_t pLength)
+		{
+			if( mSharedCache )
 			{
-				std::size_t found = aLine.find("#include");
-				if( found != std::string::npos )
-				{
-					found += 8;// Skip #include
-					// Now scan from here to find a " or a <.
-					// I can not use another find as the line maybe malformed.
-					while( found < aLine.size() )
-					{
-						char terminator = 0;
-						if( aLine[found] == '\"' )
-							terminator = '\"';
-						else if( aLine[found] == '<' )
-							terminator = '>';
-
-						found++;// Next char.
-
-						// Don't include files included with <> as these SHOULD be system headers.
-						// There is a difference between #include "" and #include <>. Changes compiler search priorities.
-						// If we have a terminator then scan to the end and treat that as the filename.
-						if( terminator == '\"' )
-						{
-							std::size_t start = found;
-							for(; found < aLine.size() && aLine[found] != terminator ; found++);
-
-							// Did we find the end?
-							if( aLine[found] == terminator )
-							{
-								std::string includefile = aLine.substr(start,found-start);
-
-								// Now see if we can find it.
-								for(const std::string path : pIncludePaths )
-								{
-									const std::string PathedInclude = path + includefile;
-									if( std::filesystem::exists(PathedInclude) )
-									{
-										rIncludes.insert(PathedInclude);
-										break;
-									}
-								}
-							}
-							// And done. Next line please.
-							found = aLine.size();
-						}
-					}
-				}
+				mNamesScratch.append(pName,pLength);
+				mNamesScratch.push_back('\0');
 			}
-		}
-		// done :)
-		// Record the files found for this file.
-		mDependencies[pFilename] = rIncludes;
-		return true;
+			findInclude(pName,pLength);
+		});
+
+		if( opened && mSharedCache )
+			mSharedCache->PutIncludes(signature,mNamesScratch);
 	}
 
-	// Dependency not found, cause a rebuild of source file.
-	return false;
+	FileNode& node = mFiles[pFile];
+	node.mScanned = true;
+	node.mOpened = opened;
+	node.mIncludesStart = includesStart;
+	node.mIncludesCount = (uint32_t)(mIncludes.size() - includesStart);
+	return opened;
 }
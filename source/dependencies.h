@@ -22,40 +22,98 @@
 
 #include <inttypes.h>
 #include <stdint.h>
-#include <functional>
-#include <map>
+#include <time.h>
 #include <filesystem>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <set>
+
+#include "stat_cache.h"
 
 class Dependencies
 {
 public:
 	typedef std::vector<std::filesystem::path> PathVec;
-	typedef std::set<std::filesystem::path> PathSet;
 
 	Dependencies();
 
+	// Stats and includes are looked for in the cache first, and what is found is put in it for the other seabangs.
+	void SetSharedCache(SharedStatCache* pCache){mSharedCache = pCache;}
+
 	// Returns true if the object file date is older than the source file or any of it's dependencies.
 	bool RequiresRebuild(const std::filesystem::path& pSourceFile,const std::filesystem::path& pObjectFile,const Dependencies::PathVec& pIncludePaths);
 
+	// After RequiresRebuild returns true, the file that was younger than the object file, or missing, and it's modification time.
+	// If the object file was missing the trigger is empty. A missing dependency has a time of zero.
+	const std::filesystem::path& GetRebuildTrigger()const{return mRebuildTrigger;}
+	const timespec& GetRebuildTriggerTime()const{return mRebuildTriggerTime;}
+
+	// After RequiresRebuild returns true, the includes that lead from the source file to the trigger. Starts with the source file and ends with the trigger.
+	void GetRebuildChain(PathVec& rChain)const;
+
+	// Fills rDependencies with every local file the source file includes, directly or via another include. Does not include the source file.
+	// They are sorted so that the order is the same for the same files on any machine.
+	void GetDependencies(const std::filesystem::path& pSourceFile,const Dependencies::PathVec& pIncludePaths,PathVec& rDependencies);
+
 private:
-	bool CheckSourceDependencies(const std::filesystem::path& pSourceFile,const timespec& pObjFileTime,const PathVec& pIncludePaths);
-	bool GetFileTime(const std::filesystem::path& pFilename,timespec& rFileTime);
-	bool FileYoungerThanObjectFile(const std::filesystem::path& pFilename,const timespec& pObjFileTime);
-	bool FileYoungerThanObjectFile(const timespec& pOtherTime,const timespec& pObjFileTime)const;
-	bool GetIncludesFromFile(const std::filesystem::path& pFilename,const PathVec& pIncludePaths,PathSet& rIncludes);
+	friend class DependenciesTest;	// In tests/dependencies_test.cpp, winds the walk epoch on to where it wraps.
 
-	typedef struct stat FileStats;
-	typedef std::map<std::filesystem::path,timespec> FileTimeMap;
-	typedef std::map<std::filesystem::path,Dependencies::PathSet> DependencyMap;
-	typedef std::map<std::filesystem::path,bool> FileState;	// True if it is out of date and thus the source file needs building, false it is not. If not found we have not checked it yet.
+	// Every path we see is interned once and from then on is referred to by it's index in mFiles.
+	// The includes of all the files are held in one array, each file has the range that is it's own.
+	// So once the files have been scanned a check is a walk over flat arrays, nothing is copied or allocated.
+	typedef uint32_t FileID;
+	static const FileID NO_FILE = UINT32_MAX;
 
+	enum FileStatState : uint8_t
+	{
+		STAT_UNKNOWN,
+		STAT_FOUND,
+		STAT_MISSING
+	};
 
-	DependencyMap mDependencies;
-	FileTimeMap mFileTimes;
-	FileState mFileDependencyState;
-	FileState mFileCheckedState;
+	struct FileNode
+	{
+		uint64_t mHash;				// Of the path, saves comparing strings when looking one up.
+		size_t mPathStart;			// Where the path is in mPathChars.
+		uint32_t mPathLength;
+		uint32_t mIncludesCount;
+		size_t mIncludesStart;		// Where it's includes are in mIncludes.
+		timespec mTime;				// The modification time, if mStatState is STAT_FOUND.
+		uint64_t mDevice;			// With the inode, size and time the signature the shared cache keeps it's includes by.
+		uint64_t mInode;
+		uint64_t mSize;
+		uint32_t mVisited;			// Equal to mEpoch if the current walk has already seen it.
+		FileID mIncludedBy;			// The file the current walk found it in, so the path to the trigger can be given.
+		FileStatState mStatState;
+		bool mScanned;				// True once the file has been read for it's includes.
+		bool mOpened;				// If it was scanned, did it open.
+	};
+
+	std::vector<FileNode> mFiles;
+	std::string mPathChars;			// All the interned paths, end to end.
+	std::vector<FileID> mIncludes;
+	std::vector<uint32_t> mPathTable;	// Open addressed, holds the FileID + 1, zero is an empty slot. Always a power of two in size.
+
+	uint32_t mEpoch = 0;
+	std::vector<FileID> mToVisit;	// Kept so the walks do not allocate each time.
+	std::vector<std::string> mSearchPaths;
+	std::string mPathScratch;
+	std::string mNamesScratch;
+	SharedStatCache* mSharedCache = nullptr;
+
+	std::filesystem::path mRebuildTrigger;
+	FileID mRebuildTriggerFile = NO_FILE;
+	timespec mRebuildTriggerTime;
+
+	void SetSearchPaths(const std::filesystem::path& pSourceFile,const PathVec& pIncludePaths);
+	FileID InternPath(std::string_view pPath);
+	std::string_view GetPath(FileID pFile)const{return std::string_view(mPathChars.data() + mFiles[pFile].mPathStart,mFiles[pFile].mPathLength);}
+	void GrowPathTable();
+	void StartWalk();
+	bool GetFileTime(FileID pFile,timespec& rFileTime,bool pShared = true);
+	bool FileYoungerThanObjectFile(FileID pFile,const timespec& pObjFileTime);
+	bool FileYoungerThanObjectFile(const timespec& pOtherTime,const timespec& pObjFileTime)const;
+	bool ScanIncludes(FileID pFile);
 };
 
 
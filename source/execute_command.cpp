@@ -6,6 +6,7 @@
 #include <poll.h>
 #include <sys/wait.h>
 #include <string.h>
+#include <errno.h>
 
 // This is needed because of the prototype of the execvp and no const on the char*.
 // Also, I have seen some odd behaviour if I use the return value from std::string::c_str()
@@ -46,9 +47,13 @@ static void BuildArgArray(char** pTheArgs, const std::vector<std::string>& pArgs
     *pTheArgs = nullptr;
 }
 
-bool ExecuteShellCommand(const std::filesystem::path& pCommand,const std::vector<std::string>& pArgs, std::string& rOutput)
+bool ExecuteShellCommand(const std::filesystem::path& pCommand,const std::vector<std::string>& pArgs, std::string& rOutput,int* rExitCode)
 {
     const bool VERBOSE = false;
+    if( rExitCode )
+    {
+        *rExitCode = -1;
+    }
     if (pCommand.empty() )
     {
         std::cerr << "ExecuteShellCommand Command name for was zero length! No command given!\n";
@@ -161,12 +166,23 @@ bool ExecuteShellCommand(const std::filesystem::path& pCommand,const std::vector
 
     int status;
     bool Worked = false;
-    if( wait(&status) == -1 )
+    // Only our child, seabang can have others running, such as a speculative build, and their status is not ours to take.
+    pid_t waited;
+    do
+    {
+        waited = waitpid(pid,&status,0);
+    }while( waited == -1 && errno == EINTR );
+    if( waited == -1 )
     {
         std::cout << "Failed to wait for child process." << std::endl;
     }
     else
     {
+        if( rExitCode && WIFEXITED(status) )
+        {
+            *rExitCode = WEXITSTATUS(status);
+        }
+
         if(WIFEXITED(status) && WEXITSTATUS(status) != 0)//did the child terminate normally?
         {
             if( VERBOSE )
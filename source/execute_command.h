@@ -6,6 +6,10 @@
 #include <map>
 #include <filesystem>
 
-bool ExecuteShellCommand(const std::filesystem::path& pCommand,const std::vector<std::string>& pArgs, std::string& rOutput);
+/**
+ * @brief Runs the command and waits for it, returns true if it exited with 0.
+ * If rExitCode is given it is set to the exit code when the command exited normally and to -1 when it did not, killed by a signal or never ran.
+ */
+bool ExecuteShellCommand(const std::filesystem::path& pCommand,const std::vector<std::string>& pArgs, std::string& rOutput,int* rExitCode = nullptr);
 
 #endif //#ifndef EXECUTE_COMMAND_H__
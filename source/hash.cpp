@@ -0,0 +1,62 @@
+/**
+ * @file hash.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <fstream>
+
+#include "hash.h"
+
+uint64_t HashBytes(const void* pData,size_t pSize,uint64_t pHash)
+{
+	const uint8_t* bytes = (const uint8_t*)pData;
+	for( size_t n = 0 ; n < pSize ; n++ )
+	{
+		pHash ^= bytes[n];
+		pHash *= 0x100000001b3ULL;
+	}
+	return pHash;
+}
+
+uint64_t HashString(const std::string& pString,uint64_t pHash)
+{
+	return HashBytes(pString.data(),pString.size(),pHash);
+}
+
+bool HashFile(const std::filesystem::path& pFilename,uint64_t& rHash)
+{
+	std::ifstream file(pFilename,std::ios::binary);
+	if( !file )
+		return false;
+
+	char buf[16*1024];
+	while( file )
+	{
+		file.read(buf,sizeof(buf));
+		rHash = HashBytes(buf,(size_t)file.gcount(),rHash);
+	}
+	return file.eof();
+}
+
+std::string HashToString(uint64_t pHash)
+{
+	static const char hex[] = "0123456789abcdef";
+	std::string str(16,'0');
+	for( int n = 15 ; n >= 0 ; n--, pHash >>= 4 )
+		str[n] = hex[pHash&15];
+	return str;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file hash.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stdint.h>
+#include <string>
+#include <filesystem>
+
+// 64 bit FNV-1a, not for security, just for spotting that things have changed.
+const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+
+uint64_t HashBytes(const void* pData,size_t pSize,uint64_t pHash = HASH_SEED);
+uint64_t HashString(const std::string& pString,uint64_t pHash = HASH_SEED);
+
+// Hashes the contents of the file into rHash, rHash is the starting value so several files can be chained.
+// Returns false if the file could not be read.
+bool HashFile(const std::filesystem::path& pFilename,uint64_t& rHash);
+
+// Sixteen hex digits, so it can be used in file names and manifests.
+std::string HashToString(uint64_t pHash);
+
+#endif //#ifndef __HASH_H__
@@ -0,0 +1,304 @@
+/**
+ * @file http_client.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+
+#include "http_client.h"
+
+bool ParseURL(const std::string& pURL,std::string& rHost,std::string& rPort,std::string& rPath,std::string& rError)
+{
+	const std::string scheme = "http://";
+	if( pURL.rfind(scheme,0) != 0 )
+	{
+		rError = "only http:// urls are supported, not " + pURL;
+		return false;
+	}
+
+	const size_t hostStart = scheme.size();
+	const size_t pathStart = std::min(pURL.find('/',hostStart),pURL.size());
+	const std::string hostAndPort = pURL.substr(hostStart,pathStart - hostStart);
+
+	// Could be an IPv6 address in brackets.
+	const size_t colon = hostAndPort.rfind(':');
+	if( colon != std::string::npos && hostAndPort.find(']',colon) == std::string::npos )
+	{
+		rHost = hostAndPort.substr(0,colon);
+		rPort = hostAndPort.substr(colon + 1);
+	}
+	else
+	{
+		rHost = hostAndPort;
+		rPort = "80";
+	}
+	if( rHost.size() > 1 && rHost.front() == '[' && rHost.back() == ']' )
+		rHost = rHost.substr(1,rHost.size() - 2);
+
+	rPath = pURL.substr(pathStart);
+	while( rPath.size() > 0 && rPath.back() == '/' )
+		rPath.pop_back();
+
+	if( rHost.size() == 0 )
+	{
+		rError = "no host in " + pURL;
+		return false;
+	}
+	return true;
+}
+
+static int GetMillisecondsLeft(const Deadline& pDeadline)
+{
+	const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(pDeadline - std::chrono::steady_clock::now()).count();
+	return left > 0 ? (int)left : 0;
+}
+
+/**
+ * @brief Waits for the socket to be ready, returns false if the deadline passes first.
+ */
+static bool WaitForSocket(int pSocket,short pEvents,const Deadline& pDeadline)
+{
+	for(;;)
+	{
+		pollfd poller = {pSocket,pEvents,0};
+		const int ready = poll(&poller,1,GetMillisecondsLeft(pDeadline));
+		if( ready > 0 )
+			return true;
+		if( ready == 0 || errno != EINTR )
+			return false;
+	}
+}
+
+int HttpConnect(const std::string& pHost,const std::string& pPort,const Deadline& pDeadline,std::string& rError)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo* addresses = nullptr;
+	const int lookup = getaddrinfo(pHost.c_str(),pPort.c_str(),&hints,&addresses);
+	if( lookup != 0 )
+	{
+		rError = "could not find " + pHost + ", " + gai_strerror(lookup);
+		return -1;
+	}
+
+	int connected = -1;
+	rError = "could not connect to " + pHost + ":" + pPort;
+	for( addrinfo* address = addresses ; address && connected < 0 ; address = address->ai_next )
+	{
+		const int s = socket(address->ai_family,address->ai_socktype|SOCK_NONBLOCK|SOCK_CLOEXEC,address->ai_protocol);
+		if( s < 0 )
+			continue;
+
+		if( connect(s,address->ai_addr,address->ai_addrlen) == 0 )
+		{
+			connected = s;
+			break;
+		}
+
+		int error = errno;
+		if( error == EINPROGRESS )
+		{
+			socklen_t length = sizeof(error);
+			if( WaitForSocket(s,POLLOUT,pDeadline) == false )
+				error = ETIMEDOUT;
+			else if( getsockopt(s,SOL_SOCKET,SO_ERROR,&error,&length) != 0 )
+				error = errno;
+		}
+
+		if( error == 0 )
+		{
+			connected = s;
+		}
+		else
+		{
+			rError += std::string(", ") + strerror(error);
+			close(s);
+		}
+	}
+	freeaddrinfo(addresses);
+	if( connected >= 0 )
+		rError.clear();
+	return connected;
+}
+
+bool SendAll(int pSocket,const char* pData,size_t pSize,const Deadline& pDeadline)
+{
+	while( pSize > 0 )
+	{
+		const ssize_t sent = send(pSocket,pData,pSize,MSG_NOSIGNAL);
+		if( sent > 0 )
+		{
+			pData += sent;
+			pSize -= sent;
+		}
+		else if( sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+		{
+			return false;
+		}
+		else if( WaitForSocket(pSocket,POLLOUT,pDeadline) == false )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+ssize_t ReceiveSome(int pSocket,char* pBuffer,size_t pSize,const Deadline& pDeadline)
+{
+	for(;;)
+	{
+		const ssize_t got = recv(pSocket,pBuffer,pSize,0);
+		if( got >= 0 )
+			return got;
+		if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+			return -1;
+		if( WaitForSocket(pSocket,POLLIN,pDeadline) == false )
+			return -1;
+	}
+}
+
+bool ReceiveResponseHeader(int pSocket,const Deadline& pDeadline,int& rStatus,int64_t& rContentLength,std::string& rBody,std::string& rError)
+{
+	std::string header;
+	char buf[4096];
+	size_t headerEnd;
+	while( (headerEnd = header.find("\r\n\r\n")) == std::string::npos )
+	{
+		if( header.size() > 64 * 1024 )
+		{
+			rError = "response header too big";
+			return false;
+		}
+
+		const ssize_t got = ReceiveSome(pSocket,buf,sizeof(buf),pDeadline);
+		if( got <= 0 )
+		{
+			rError = got == 0 ? "connection closed before the response" : "timed out waiting for the response";
+			return false;
+		}
+		header.append(buf,got);
+	}
+	rBody = header.substr(headerEnd + 4);
+	header.resize(headerEnd + 2);
+
+	// HTTP/1.1 200 OK
+	if( header.rfind("HTTP/1.",0) != 0 || header.size() < 12 )
+	{
+		rError = "not an http response";
+		return false;
+	}
+	rStatus = atoi(header.c_str() + 9);
+
+	rContentLength = -1;
+	for( size_t lineStart = header.find("\r\n") + 2 ; lineStart < header.size() ; )
+	{
+		const size_t lineEnd = header.find("\r\n",lineStart);
+		const std::string line = header.substr(lineStart,lineEnd - lineStart);
+		lineStart = lineEnd + 2;
+
+		const size_t colon = line.find(':');
+		if( colon == std::string::npos )
+			continue;
+
+		const std::string name = line.substr(0,colon);
+		if( strcasecmp(name.c_str(),"Content-Length") == 0 )
+			rContentLength = atoll(line.c_str() + colon + 1);
+		else if( strcasecmp(name.c_str(),"Transfer-Encoding") == 0 )
+		{
+			rError = "chunked responses are not supported";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool HttpRequest(const std::string& pMethod,const std::string& pURL,const std::string& pBody,const std::string& pToken,int pTimeoutMS,int& rStatus,std::string& rResponse,std::string& rError)
+{
+	rError.clear();
+	const Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMS);
+
+	std::string host,port,path;
+	if( ParseURL(pURL,host,port,path,rError) == false )
+		return false;
+
+	const int s = HttpConnect(host,port,deadline,rError);
+	if( s < 0 )
+		return false;
+
+	std::string request = pMethod + " " + (path.size() > 0 ? path : "/") + " HTTP/1.1\r\n";
+	request += "Host: " + host + ":" + port + "\r\n";
+	request += "User-Agent: seabang\r\n";
+	request += "Connection: close\r\n";
+	if( pToken.empty() == false )
+	{
+		request += "Authorization: Bearer " + pToken + "\r\n";
+	}
+	if( pMethod != "GET" )
+	{
+		request += "Content-Type: application/octet-stream\r\n";
+		request += "Content-Length: " + std::to_string(pBody.size()) + "\r\n";
+	}
+	request += "\r\n";
+
+	int64_t contentLength;
+	if( SendAll(s,request.data(),request.size(),deadline) == false || SendAll(s,pBody.data(),pBody.size(),deadline) == false )
+	{
+		rError = "failed to send the request to " + host + ":" + port;
+		close(s);
+		return false;
+	}
+
+	if( ReceiveResponseHeader(s,deadline,rStatus,contentLength,rResponse,rError) == false )
+	{
+		close(s);
+		return false;
+	}
+
+	if( contentLength < 0 )
+	{
+		close(s);
+		rError = "no Content-Length in the response";
+		return false;
+	}
+
+	char buf[64 * 1024];
+	while( (int64_t)rResponse.size() < contentLength )
+	{
+		const ssize_t read = ReceiveSome(s,buf,sizeof(buf),deadline);
+		if( read <= 0 )
+			break;
+		rResponse.append(buf,read);
+	}
+	close(s);
+
+	if( (int64_t)rResponse.size() != contentLength )
+	{
+		rError = "response cut short, got " + std::to_string(rResponse.size()) + " of " + std::to_string(contentLength) + " bytes";
+		return false;
+	}
+	return true;
+}
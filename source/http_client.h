@@ -0,0 +1,53 @@
+/**
+ * @file http_client.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __HTTP_CLIENT_H__
+#define __HTTP_CLIENT_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+#include <chrono>
+
+// The http client the remote cache and the compile workers are reached with. Everything is done by a deadline, the sockets
+// are non blocking and every read and write waits with poll, so a host that has gone away can not hang seabang.
+// Only responses with a Content-Length are understood, so a cut off response is seen for what it is.
+
+typedef std::chrono::steady_clock::time_point Deadline;
+
+// Splits http://host[:port][/path] up, the path is returned without the trailing slash.
+bool ParseURL(const std::string& pURL,std::string& rHost,std::string& rPort,std::string& rPath,std::string& rError);
+
+// Connects to the first address of the host that answers. Returns the socket, left non blocking, or -1.
+int HttpConnect(const std::string& pHost,const std::string& pPort,const Deadline& pDeadline,std::string& rError);
+
+bool SendAll(int pSocket,const char* pData,size_t pSize,const Deadline& pDeadline);
+
+// Reads what is there, waiting till the deadline for something. Returns zero at the end of the stream and -1 on an error or timeout.
+ssize_t ReceiveSome(int pSocket,char* pBuffer,size_t pSize,const Deadline& pDeadline);
+
+// Reads the status line and headers, anything after them that was read is left in rBody.
+bool ReceiveResponseHeader(int pSocket,const Deadline& pDeadline,int& rStatus,int64_t& rContentLength,std::string& rBody,std::string& rError);
+
+// Sends the request, with the body if it's not a GET, and reads the whole response into rResponse. If pToken is not empty it
+// is sent as the bearer token. Returns false if there was no complete response in time, any status is a response, rStatus is
+// for the caller to check.
+bool HttpRequest(const std::string& pMethod,const std::string& pURL,const std::string& pBody,const std::string& pToken,int pTimeoutMS,int& rStatus,std::string& rResponse,std::string& rError);
+
+#endif //#ifndef __HTTP_CLIENT_H__
@@ -0,0 +1,121 @@
+/**
+ * @file job_slot.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/file.h>
+
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+
+#include "job_slot.h"
+
+/**
+ * @brief Looks through the queue for the oldest waiter that is still alive, removing the ones that are not.
+ * Returns our place in the queue, zero when we are next.
+ */
+static int GetQueuePosition(const std::filesystem::path& pQueueFolder,const std::string& pTicket)
+{
+	int position = 0;
+	std::error_code ec;
+	for( const auto& entry : std::filesystem::directory_iterator(pQueueFolder,ec) )
+	{
+		const std::string name = entry.path().filename().string();
+		if( name >= pTicket )
+			continue;
+
+		const size_t dash = name.rfind('-');
+		const pid_t pid = dash != std::string::npos ? (pid_t)atoi(name.c_str() + dash + 1) : 0;
+		if( pid <= 0 || (kill(pid,0) != 0 && errno == ESRCH) )
+		{
+			std::filesystem::remove(entry.path(),ec);
+			continue;
+		}
+		position++;
+	}
+	return position;
+}
+
+JobSlot::JobSlot(const std::filesystem::path& pTempFolder,int pMaxJobs)
+{
+	if( pMaxJobs <= 0 )
+		return;
+
+	const std::filesystem::path jobsFolder = pTempFolder / ".seabang" / "jobs";
+	const std::filesystem::path queueFolder = jobsFolder / "queue";
+	std::error_code ec;
+	std::filesystem::create_directories(queueFolder,ec);
+
+	// Fixed width so the names sort in the order we arrived, the pid makes it unique and lets others see if we died.
+	timespec now;
+	clock_gettime(CLOCK_REALTIME,&now);
+	char ticket[64];
+	snprintf(ticket,sizeof(ticket),"%012lld%09ld-%010d",(long long)now.tv_sec,now.tv_nsec,(int)getpid());
+	const std::filesystem::path ticketFile = queueFolder / ticket;
+	std::ofstream(ticketFile).close();
+
+	const auto start = std::chrono::steady_clock::now();
+	while( mLock < 0 )
+	{
+		const int position = GetQueuePosition(queueFolder,ticket);
+		if( position == 0 )
+		{
+			for( int n = 0 ; n < pMaxJobs && mLock < 0 ; n++ )
+			{
+				const std::filesystem::path slotFile = jobsFolder / ("slot." + std::to_string(n));
+				const int lock = open(slotFile.c_str(),O_RDWR|O_CREAT|O_CLOEXEC,0644);
+				if( lock >= 0 && flock(lock,LOCK_EX|LOCK_NB) == 0 )
+					mLock = lock;
+				else if( lock >= 0 )
+					close(lock);
+			}
+		}
+
+		if( mLock < 0 )
+		{
+			// The further back we are the less often we look, so a big queue does not spend all it's time reading the folder.
+			usleep(20000 + std::min(position,100) * 5000);
+		}
+	}
+
+	std::filesystem::remove(ticketFile,ec);
+	mWaitTime = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+JobSlot::~JobSlot()
+{
+	if( mLock >= 0 )
+		close(mLock);
+}
+
+int GetDefaultMaxJobs()
+{
+	const char* maxJobs = getenv("SEABANG_MAX_JOBS");
+	if( maxJobs && maxJobs[0] )
+		return atoi(maxJobs);
+
+	const long numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+	return numCPUs > 0 ? (int)numCPUs : 1;
+}
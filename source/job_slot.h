@@ -0,0 +1,50 @@
+/**
+ * @file job_slot.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __JOB_SLOT_H__
+#define __JOB_SLOT_H__
+
+#include <filesystem>
+
+// Limits how many compiles all the seabangs on the host run at once.
+// The slots are files in <temp>/.seabang/jobs that are held with flock, so a slot is freed even if the holder is killed.
+// Waiters queue in <temp>/.seabang/jobs/queue, one file each named by arrival time and pid, only the oldest live waiter
+// may take a free slot so they are served in the order they arrived. Files left by waiters that died are removed.
+class JobSlot
+{
+public:
+	// Blocks until a slot is free. A max jobs of zero, or less, means no limit and returns straight away.
+	JobSlot(const std::filesystem::path& pTempFolder,int pMaxJobs);
+	~JobSlot();
+
+	JobSlot(const JobSlot&) = delete;
+	JobSlot& operator=(const JobSlot&) = delete;
+
+	// How long we were queued for, in milliseconds.
+	int GetWaitTime()const{return mWaitTime;}
+
+private:
+	int mLock = -1;
+	int mWaitTime = 0;
+};
+
+// The limit to use if not given one, the SEABANG_MAX_JOBS environment variable or the number of CPUs.
+int GetDefaultMaxJobs();
+
+#endif //#ifndef __JOB_SLOT_H__
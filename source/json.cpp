@@ -0,0 +1,392 @@
+/**
+ * @file json.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "json.h"
+
+const JsonValue* JsonValue::Find(const std::string& pKey)const
+{
+	for( const auto& member : mObject )
+	{
+		if( member.first == pKey )
+			return &member.second;
+	}
+	return nullptr;
+}
+
+double JsonValue::GetNumber(const std::string& pKey,double pDefault)const
+{
+	const JsonValue* value = Find(pKey);
+	return value && value->mType == JSON_NUMBER ? value->mNumber : pDefault;
+}
+
+std::string JsonValue::GetString(const std::string& pKey,const std::string& pDefault)const
+{
+	const JsonValue* value = Find(pKey);
+	return value && value->mType == JSON_STRING ? value->mString : pDefault;
+}
+
+// Recursive decent, the depth is limited so a bad file can not run us out of stack.
+class JsonParser
+{
+public:
+	JsonParser(const char* pText,size_t pSize) : mPos(pText),mEnd(pText + pSize){}
+
+	bool Parse(JsonValue& rValue)
+	{
+		if( ParseValue(rValue,0) == false )
+			return false;
+		SkipSpace();
+		return mPos == mEnd;
+	}
+
+private:
+	const char* mPos;
+	const char* const mEnd;
+
+	void SkipSpace()
+	{
+		while( mPos < mEnd && (*mPos == ' ' || *mPos == '\t' || *mPos == '\n' || *mPos == '\r') )
+			mPos++;
+	}
+
+	bool Match(const char* pWord)
+	{
+		const size_t length = strlen(pWord);
+		if( (size_t)(mEnd - mPos) < length || memcmp(mPos,pWord,length) != 0 )
+			return false;
+		mPos += length;
+		return true;
+	}
+
+	static void AppendUTF8(std::string& rString,unsigned int pCode)
+	{
+		if( pCode < 0x80 )
+			rString += (char)pCode;
+		else if( pCode < 0x800 )
+		{
+			rString += (char)(0xc0 | (pCode >> 6));
+			rString += (char)(0x80 | (pCode & 0x3f));
+		}
+		else if( pCode < 0x10000 )
+		{
+			rString += (char)(0xe0 | (pCode >> 12));
+			rString += (char)(0x80 | ((pCode >> 6) & 0x3f));
+			rString += (char)(0x80 | (pCode & 0x3f));
+		}
+		else
+		{
+			rString += (char)(0xf0 | (pCode >> 18));
+			rString += (char)(0x80 | ((pCode >> 12) & 0x3f));
+			rString += (char)(0x80 | ((pCode >> 6) & 0x3f));
+			rString += (char)(0x80 | (pCode & 0x3f));
+		}
+	}
+
+	bool ParseHex4(unsigned int& rCode)
+	{
+		if( mEnd - mPos < 4 )
+			return false;
+		rCode = 0;
+		for( int n = 0 ; n < 4 ; n++ )
+		{
+			const char c = *mPos++;
+			rCode <<= 4;
+			if( c >= '0' && c <= '9' )
+				rCode |= c - '0';
+			else if( c >= 'a' && c <= 'f' )
+				rCode |= c - 'a' + 10;
+			else if( c >= 'A' && c <= 'F' )
+				rCode |= c - 'A' + 10;
+			else
+				return false;
+		}
+		return true;
+	}
+
+	bool ParseString(std::string& rString)
+	{
+		// Past the opening quote.
+		mPos++;
+		while( mPos < mEnd && *mPos != '"' )
+		{
+			const char c = *mPos++;
+			if( c != '\\' )
+			{
+				rString += c;
+				continue;
+			}
+
+			if( mPos == mEnd )
+				return false;
+			const char escaped = *mPos++;
+			switch( escaped )
+			{
+			case '"':
+			case '\\':
+			case '/':
+				rString += escaped;
+				break;
+			case 'b':
+				rString += '\b';
+				break;
+			case 'f':
+				rString += '\f';
+				break;
+			case 'n':
+				rString += '\n';
+				break;
+			case 'r':
+				rString += '\r';
+				break;
+			case 't':
+				rString += '\t';
+				break;
+			case 'u':
+				{
+					unsigned int code;
+					if( ParseHex4(code) == false )
+						return false;
+
+					// Surrogate pairs are joined back up.
+					if( code >= 0xd800 && code < 0xdc00 && Match("\\u") )
+					{
+						unsigned int low;
+						if( ParseHex4(low) == false )
+							return false;
+						code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+					}
+					AppendUTF8(rString,code);
+				}
+				break;
+			default:
+				return false;
+			}
+		}
+
+		if( mPos == mEnd )
+			return false;
+		mPos++;
+		return true;
+	}
+
+	bool ParseValue(JsonValue& rValue,int pDepth)
+	{
+		if( pDepth > 256 )
+			return false;
+
+		SkipSpace();
+		if( mPos == mEnd )
+			return false;
+
+		switch( *mPos )
+		{
+		case '{':
+			rValue.mType = JsonValue::JSON_OBJECT;
+			mPos++;
+			SkipSpace();
+			if( mPos < mEnd && *mPos == '}' )
+			{
+				mPos++;
+				return true;
+			}
+			for(;;)
+			{
+				SkipSpace();
+				std::string key;
+				if( mPos == mEnd || *mPos != '"' || ParseString(key) == false )
+					return false;
+				SkipSpace();
+				if( mPos == mEnd || *mPos++ != ':' )
+					return false;
+
+				rValue.mObject.emplace_back(key,JsonValue());
+				if( ParseValue(rValue.mObject.back().second,pDepth + 1) == false )
+					return false;
+
+				SkipSpace();
+				if( mPos == mEnd )
+					return false;
+				const char c = *mPos++;
+				if( c == '}' )
+					return true;
+				if( c != ',' )
+					return false;
+			}
+
+		case '[':
+			rValue.mType = JsonValue::JSON_ARRAY;
+			mPos++;
+			SkipSpace();
+			if( mPos < mEnd && *mPos == ']' )
+			{
+				mPos++;
+				return true;
+			}
+			for(;;)
+			{
+				rValue.mArray.emplace_back();
+				if( ParseValue(rValue.mArray.back(),pDepth + 1) == false )
+					return false;
+
+				SkipSpace();
+				if( mPos == mEnd )
+					return false;
+				const char c = *mPos++;
+				if( c == ']' )
+					return true;
+				if( c != ',' )
+					return false;
+			}
+
+		case '"':
+			rValue.mType = JsonValue::JSON_STRING;
+			return ParseString(rValue.mString);
+
+		case 't':
+			rValue.mType = JsonValue::JSON_BOOL;
+			rValue.mBool = true;
+			return Match("true");
+
+		case 'f':
+			rValue.mType = JsonValue::JSON_BOOL;
+			return Match("false");
+
+		case 'n':
+			return Match("null");
+
+		default:
+			{
+				// strtod wants a terminated string, numbers are short so copy it out.
+				char number[64];
+				size_t length = 0;
+				while( mPos + length < mEnd && length < sizeof(number) - 1 && mPos[length] != 0 && strchr("+-0123456789.eE",mPos[length]) )
+				{
+					number[length] = mPos[length];
+					length++;
+				}
+				number[length] = 0;
+
+				char* numberEnd;
+				rValue.mType = JsonValue::JSON_NUMBER;
+				rValue.mNumber = strtod(number,&numberEnd);
+				if( length == 0 || numberEnd != number + length )
+					return false;
+				mPos += length;
+				return true;
+			}
+		}
+	}
+};
+
+bool ParseJson(const char* pText,size_t pSize,JsonValue& rValue)
+{
+	JsonParser parser(pText,pSize);
+	return parser.Parse(rValue);
+}
+
+std::string JsonQuote(const std::string& pString)
+{
+	std::string quoted = "\"";
+	for( const char c : pString )
+	{
+		switch( c )
+		{
+		case '"':
+			quoted += "\\\"";
+			break;
+		case '\\':
+			quoted += "\\\\";
+			break;
+		case '\n':
+			quoted += "\\n";
+			break;
+		case '\r':
+			quoted += "\\r";
+			break;
+		case '\t':
+			quoted += "\\t";
+			break;
+		default:
+			if( (unsigned char)c < 0x20 )
+			{
+				char escaped[8];
+				snprintf(escaped,sizeof(escaped),"\\u%04x",c);
+				quoted += escaped;
+			}
+			else
+			{
+				quoted += c;
+			}
+		}
+	}
+	return quoted + "\"";
+}
+
+void WriteJson(std::ostream& pStream,const JsonValue& pValue)
+{
+	switch( pValue.mType )
+	{
+	case JsonValue::JSON_NULL:
+		pStream << "null";
+		break;
+
+	case JsonValue::JSON_BOOL:
+		pStream << (pValue.mBool ? "true" : "false");
+		break;
+
+	case JsonValue::JSON_NUMBER:
+		{
+			char number[32];
+			snprintf(number,sizeof(number),"%.15g",pValue.mNumber);
+			pStream << number;
+		}
+		break;
+
+	case JsonValue::JSON_STRING:
+		pStream << JsonQuote(pValue.mString);
+		break;
+
+	case JsonValue::JSON_ARRAY:
+		pStream << "[";
+		for( size_t n = 0 ; n < pValue.mArray.size() ; n++ )
+		{
+			if( n > 0 )
+				pStream << ",";
+			WriteJson(pStream,pValue.mArray[n]);
+		}
+		pStream << "]";
+		break;
+
+	case JsonValue::JSON_OBJECT:
+		pStream << "{";
+		for( size_t n = 0 ; n < pValue.mObject.size() ; n++ )
+		{
+			if( n > 0 )
+				pStream << ",";
+			pStream << JsonQuote(pValue.mObject[n].first) << ":";
+			WriteJson(pStream,pValue.mObject[n].second);
+		}
+		pStream << "}";
+		break;
+	}
+}
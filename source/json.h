@@ -0,0 +1,57 @@
+/**
+ * @file json.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __JSON_H__
+#define __JSON_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <ostream>
+
+// Just enough json to read and write trace files. Objects keep their keys in the order they were read.
+struct JsonValue
+{
+	enum Type {JSON_NULL,JSON_BOOL,JSON_NUMBER,JSON_STRING,JSON_ARRAY,JSON_OBJECT};
+
+	Type mType = JSON_NULL;
+	bool mBool = false;
+	double mNumber = 0.0;
+	std::string mString;
+	std::vector<JsonValue> mArray;
+	std::vector<std::pair<std::string,JsonValue>> mObject;
+
+	// Returns nullptr if this is not an object or it does not have the key.
+	const JsonValue* Find(const std::string& pKey)const;
+
+	// The value of the key if it is there and of the right type, if not the default.
+	double GetNumber(const std::string& pKey,double pDefault = 0.0)const;
+	std::string GetString(const std::string& pKey,const std::string& pDefault = "")const;
+};
+
+// Returns false if the text is not valid json.
+bool ParseJson(const char* pText,size_t pSize,JsonValue& rValue);
+
+void WriteJson(std::ostream& pStream,const JsonValue& pValue);
+
+// Quoted and escaped, ready to write into json.
+std::string JsonQuote(const std::string& pString);
+
+#endif //#ifndef __JSON_H__
@@ -0,0 +1,176 @@
+/**
+ * @file lz_compress.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+
+#include "lz_compress.h"
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_BITS = 16;
+
+static uint32_t Read32(const uint8_t* pData)
+{
+	uint32_t value;
+	memcpy(&value,pData,sizeof(value));
+	return value;
+}
+
+static uint32_t HashSequence(uint32_t pSequence)
+{
+	return (pSequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief Lengths of 15 or more are the 15 in the token then bytes of 255 till the rest is less than 255.
+ */
+static void WriteLengthExtra(std::vector<uint8_t>& rOutput,size_t pLength)
+{
+	if( pLength < 15 )
+		return;
+
+	pLength -= 15;
+	while( pLength >= 255 )
+	{
+		rOutput.push_back(255);
+		pLength -= 255;
+	}
+	rOutput.push_back((uint8_t)pLength);
+}
+
+static void WriteSequence(std::vector<uint8_t>& rOutput,const uint8_t* pLiterals,size_t pLiteralLength,size_t pOffset,size_t pMatchLength)
+{
+	const size_t matchCode = pMatchLength > 0 ? pMatchLength - MIN_MATCH : 0;
+	rOutput.push_back((uint8_t)(((pLiteralLength < 15 ? pLiteralLength : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+	WriteLengthExtra(rOutput,pLiteralLength);
+	rOutput.insert(rOutput.end(),pLiterals,pLiterals + pLiteralLength);
+
+	if( pMatchLength > 0 )
+	{
+		rOutput.push_back((uint8_t)(pOffset & 0xff));
+		rOutput.push_back((uint8_t)(pOffset >> 8));
+		WriteLengthExtra(rOutput,matchCode);
+	}
+}
+
+std::vector<uint8_t> LZCompress(const void* pData,size_t pSize)
+{
+	const uint8_t* data = (const uint8_t*)pData;
+	std::vector<uint8_t> output;
+	output.reserve(pSize / 2 + 16);
+
+	// The last position seen for each hash of four bytes. A stale or clashing entry is caught by comparing the bytes.
+	std::vector<uint32_t> table(1 << HASH_BITS,0);
+
+	size_t pos = 0;
+	size_t literalStart = 0;
+	while( pos + MIN_MATCH <= pSize )
+	{
+		const uint32_t sequence = Read32(data + pos);
+		const uint32_t hash = HashSequence(sequence);
+		const size_t candidate = table[hash];
+		table[hash] = (uint32_t)pos;
+
+		if( candidate < pos && pos - candidate <= MAX_OFFSET && Read32(data + candidate) == sequence )
+		{
+			size_t length = MIN_MATCH;
+			while( pos + length < pSize && data[candidate + length] == data[pos + length] )
+				length++;
+
+			WriteSequence(output,data + literalStart,pos - literalStart,pos - candidate,length);
+			pos += length;
+			literalStart = pos;
+		}
+		else
+		{
+			// The longer it goes without a match the bigger the steps, so data that does not compress is got through quickly.
+			pos += 1 + ((pos - literalStart) >> 6);
+		}
+	}
+
+	WriteSequence(output,data + literalStart,pSize - literalStart,0,0);
+	return output;
+}
+
+/**
+ * @brief Reads the rest of a length that was 15 in the token.
+ */
+static bool ReadLengthExtra(const uint8_t*& rPos,const uint8_t* pEnd,size_t& rLength)
+{
+	if( rLength < 15 )
+		return true;
+
+	uint8_t more;
+	do
+	{
+		if( rPos >= pEnd )
+			return false;
+		more = *rPos++;
+		rLength += more;
+	}while( more == 255 );
+	return true;
+}
+
+bool LZDecompress(const void* pData,size_t pSize,size_t pDecompressedSize,std::vector<uint8_t>& rOutput)
+{
+	rOutput.resize(pDecompressedSize);
+	uint8_t* const output = rOutput.data();
+	size_t outputPos = 0;
+
+	const uint8_t* pos = (const uint8_t*)pData;
+	const uint8_t* const end = pos + pSize;
+	while( pos < end )
+	{
+		const uint8_t token = *pos++;
+
+		size_t literalLength = token >> 4;
+		if( ReadLengthExtra(pos,end,literalLength) == false || literalLength > (size_t)(end - pos) || literalLength > pDecompressedSize - outputPos )
+			return false;
+
+		memcpy(output + outputPos,pos,literalLength);
+		pos += literalLength;
+		outputPos += literalLength;
+
+		// The last sequence has no match.
+		if( pos == end )
+			break;
+
+		if( end - pos < 2 )
+			return false;
+		const size_t offset = pos[0] | (pos[1] << 8);
+		pos += 2;
+
+		size_t matchLength = token & 0x0f;
+		if( ReadLengthExtra(pos,end,matchLength) == false )
+			return false;
+		matchLength += MIN_MATCH;
+
+		if( offset == 0 || offset > outputPos || matchLength > pDecompressedSize - outputPos )
+			return false;
+
+		// The match can overlap what it is writing, a run of one byte is an offset of one, so it is copied a byte at a time.
+		const uint8_t* from = output + outputPos - offset;
+		uint8_t* to = output + outputPos;
+		for( size_t n = 0 ; n < matchLength ; n++ )
+			to[n] = from[n];
+		outputPos += matchLength;
+	}
+
+	return outputPos == pDecompressedSize;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file lz_compress.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __LZ_COMPRESS_H__
+#define __LZ_COMPRESS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// A small LZ77 compressor in the style of LZ4, built for fast decompression rather than the smallest output.
+// The stream is a run of sequences, each a token, literals, a 16 bit offset back into what has been output and a match length.
+// The last sequence is literals only. Execs compress to about half their size.
+
+// Data that does not compress comes out a little larger than it went in.
+std::vector<uint8_t> LZCompress(const void* pData,size_t pSize);
+
+// Returns false if the data is corrupt or does not decompress to exactly pDecompressedSize bytes.
+bool LZDecompress(const void* pData,size_t pSize,size_t pDecompressedSize,std::vector<uint8_t>& rOutput);
+
+#endif //#ifndef __LZ_COMPRESS_H__
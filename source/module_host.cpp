@@ -0,0 +1,586 @@
+/**
+ * @file module_host.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <chrono>
+
+#include "module_host.h"
+#include "zygote.h"
+#include "background_job.h"
+
+typedef int (*ScriptMain)(int argc,char** argv,char** envp);
+
+static const uint32_t MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+static const size_t MAX_PENDING_RUNS = 256;
+static const size_t MAX_INCOMING_RUNS = 64;
+static const int REQUEST_TIMEOUT_MS = 5000;
+
+struct LoadedModule
+{
+	void* mHandle = nullptr;
+	ScriptMain mMain = nullptr;
+	struct stat mStats;
+};
+
+struct PendingRun
+{
+	pid_t mPid;
+	int mClient;
+};
+
+// A client whose request is still being read. It's socket is non blocking and read from the poll loop as the request
+// comes in, so a client that stalls part way through only holds up it's own run.
+struct IncomingRun
+{
+	int mClient;
+	int mFds[3];
+	ZygoteRequest mRequest;
+	size_t mGot;				// How much of the request, and then the blob after it, has been read.
+	std::vector<char> mBlob;
+	std::chrono::steady_clock::time_point mDeadline;
+};
+
+enum ReadState
+{
+	READ_MORE,
+	READ_DONE,
+	READ_FAILED
+};
+
+/**
+ * @brief Sends with MSG_NOSIGNAL, a client that has gone away must not take the host down with a SIGPIPE.
+ */
+static void SendInt(int pSocket,int32_t pValue)
+{
+	const char* p = (const char*)&pValue;
+	size_t size = sizeof(pValue);
+	while( size > 0 )
+	{
+		const ssize_t n = send(pSocket,p,size,MSG_NOSIGNAL);
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return;
+		p += n;
+		size -= (size_t)n;
+	}
+}
+
+static bool IsSameFile(const struct stat& pA,const struct stat& pB)
+{
+	return pA.st_dev == pB.st_dev && pA.st_ino == pB.st_ino &&
+			pA.st_mtim.tv_sec == pB.st_mtim.tv_sec && pA.st_mtim.tv_nsec == pB.st_mtim.tv_nsec;
+}
+
+static ScriptMain OpenModule(const std::string& pModuleName,void*& rHandle)
+{
+	rHandle = dlopen(pModuleName.c_str(),RTLD_NOW|RTLD_LOCAL);
+	if( rHandle == nullptr )
+	{
+		std::cerr << "Failed to load module " << dlerror() << "\n";
+		return nullptr;
+	}
+
+	const ScriptMain scriptMain = (ScriptMain)dlsym(rHandle,ZYGOTE_SCRIPT_MAIN);
+	if( scriptMain == nullptr )
+	{
+		std::cerr << "Module " << pModuleName << " has no " << ZYGOTE_SCRIPT_MAIN << ", it was not built for the module host\n";
+		dlclose(rHandle);
+		rHandle = nullptr;
+	}
+	return scriptMain;
+}
+
+/**
+ * @brief Returns the module's main, opening it if it's not open or has been rebuilt since it was.
+ * Code built from C++ can be marked by the compiler as never to be unloaded, then opening the rebuilt module would give us the old one.
+ * When that happens rRetire is set, a new host is needed to run the new one.
+ */
+static ScriptMain LoadModule(std::map<std::string,LoadedModule>& rModules,const std::string& pModuleName,bool& rRetire)
+{
+	struct stat stats;
+	if( stat(pModuleName.c_str(),&stats) != 0 )
+		return nullptr;
+
+	auto found = rModules.find(pModuleName);
+	if( found != rModules.end() )
+	{
+		if( IsSameFile(found->second.mStats,stats) )
+			return found->second.mMain;
+
+		dlclose(found->second.mHandle);
+		rModules.erase(found);
+
+		void* stuck = dlopen(pModuleName.c_str(),RTLD_NOW|RTLD_NOLOAD);
+		if( stuck )
+		{
+			dlclose(stuck);
+			rRetire = true;
+			return nullptr;
+		}
+	}
+
+	LoadedModule module;
+	module.mMain = OpenModule(pModuleName,module.mHandle);
+	module.mStats = stats;
+	if( module.mMain )
+		rModules[pModuleName] = module;
+	return module.mMain;
+}
+
+class ModuleHost
+{
+public:
+	ModuleHost(const std::filesystem::path& pSocketFile) : mSocketFile(pSocketFile){}
+
+	void Serve(int pIdleSeconds);
+
+private:
+	const std::filesystem::path mSocketFile;
+	struct stat mSocketStats;
+	int mListen = -1;
+	int mSignals = -1;
+	sigset_t mOldMask;
+	std::map<std::string,LoadedModule> mModules;
+	std::vector<PendingRun> mPending;
+	std::vector<IncomingRun> mIncoming;
+
+	bool Listen();
+	void StopListening();
+	void AcceptConnection();
+	ReadState ReadRequest(IncomingRun& rRun);
+	void StartRun(IncomingRun& rRun);
+	void RefuseRun(IncomingRun& rRun);
+	void ReapChildren();
+	void RunScript(ScriptMain pScriptMain,int pClient,const int pFds[3],char* pBlob,const ZygoteRequest& pRequest);
+};
+
+/**
+ * @brief Bound to the side and renamed into place so clients never see a socket that is not listening yet.
+ */
+bool ModuleHost::Listen()
+{
+	const std::string sidePath = mSocketFile.string() + "." + std::to_string(getpid());
+	sockaddr_un address;
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	if( sidePath.size() >= sizeof(address.sun_path) )
+	{
+		std::cerr << "Module host socket path is too long " << sidePath << "\n";
+		return false;
+	}
+	strcpy(address.sun_path,sidePath.c_str());
+
+	mListen = socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+	unlink(sidePath.c_str());
+	if( mListen < 0 || bind(mListen,(sockaddr*)&address,sizeof(address)) != 0 || listen(mListen,64) != 0 || rename(sidePath.c_str(),mSocketFile.c_str()) != 0 )
+	{
+		std::cerr << "Module host failed to listen on " << mSocketFile << " " << strerror(errno) << "\n";
+		unlink(sidePath.c_str());
+		return false;
+	}
+	stat(mSocketFile.c_str(),&mSocketStats);
+	return true;
+}
+
+void ModuleHost::StopListening()
+{
+	if( mListen < 0 )
+		return;
+
+	// Only remove the socket if it is still ours, a newer host may have replaced it.
+	struct stat now;
+	if( stat(mSocketFile.c_str(),&now) == 0 && now.st_dev == mSocketStats.st_dev && now.st_ino == mSocketStats.st_ino )
+		unlink(mSocketFile.c_str());
+	close(mListen);
+	mListen = -1;
+}
+
+/**
+ * @brief In the forked child, takes on the caller's stdio, environment and working folder and runs the module's main.
+ */
+void ModuleHost::RunScript(ScriptMain pScriptMain,int pClient,const int pFds[3],char* pBlob,const ZygoteRequest& pRequest)
+{
+	close(mListen);
+	close(mSignals);
+	close(pClient);
+	for( const PendingRun& run : mPending )
+		close(run.mClient);
+	// Including the one being run, if it had to wait for it's request.
+	for( const IncomingRun& run : mIncoming )
+	{
+		if( run.mClient == pClient )
+			continue;
+		close(run.mClient);
+		for( int n = 0 ; n < 3 ; n++ )
+		{
+			if( run.mFds[n] >= 0 )
+				close(run.mFds[n]);
+		}
+	}
+	sigprocmask(SIG_SETMASK,&mOldMask,nullptr);
+
+	for( int n = 0 ; n < 3 ; n++ )
+		dup2(pFds[n],n);
+	for( int n = 0 ; n < 3 ; n++ )
+	{
+		if( pFds[n] > 2 )
+			close(pFds[n]);
+	}
+
+	char* p = pBlob;
+	const char* cwd = p;
+	p += strlen(p) + 1;
+
+	std::vector<char*> argv;
+	for( uint32_t n = 0 ; n < pRequest.mArgc ; n++ )
+	{
+		argv.push_back(p);
+		p += strlen(p) + 1;
+	}
+	argv.push_back(nullptr);
+
+	clearenv();
+	for( uint32_t n = 0 ; n < pRequest.mEnvc ; n++ )
+	{
+		putenv(p);
+		p += strlen(p) + 1;
+	}
+
+	if( chdir(cwd) != 0 )
+	{
+		std::cerr << "Module host failed to change to " << cwd << " " << strerror(errno) << "\n";
+		_exit(127);
+	}
+	exit(pScriptMain((int)pRequest.mArgc,argv.data(),environ));
+}
+
+void ModuleHost::AcceptConnection()
+{
+	const int client = accept4(mListen,nullptr,nullptr,SOCK_CLOEXEC|SOCK_NONBLOCK);
+	if( client < 0 )
+		return;
+
+	IncomingRun run;
+	run.mClient = client;
+	run.mFds[0] = run.mFds[1] = run.mFds[2] = -1;
+	run.mGot = 0;
+	run.mDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REQUEST_TIMEOUT_MS);
+	if( mIncoming.size() >= MAX_INCOMING_RUNS )
+	{
+		RefuseRun(run);
+		return;
+	}
+
+	// Most of the time the whole request is already there.
+	switch( ReadRequest(run) )
+	{
+	case READ_DONE:
+		StartRun(run);
+		break;
+
+	case READ_FAILED:
+		RefuseRun(run);
+		break;
+
+	case READ_MORE:
+		mIncoming.push_back(std::move(run));
+		break;
+	}
+}
+
+/**
+ * @brief Reads what has arrived of the request, the fixed part with the client's stdio and then the blob after it.
+ */
+ReadState ModuleHost::ReadRequest(IncomingRun& rRun)
+{
+	while( rRun.mGot < sizeof(rRun.mRequest) )
+	{
+		char control[CMSG_SPACE(sizeof(int) * 3)];
+		iovec iov = {(char*)&rRun.mRequest + rRun.mGot,sizeof(rRun.mRequest) - rRun.mGot};
+		msghdr msg;
+		memset(&msg,0,sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		const ssize_t got = recvmsg(rRun.mClient,&msg,MSG_CMSG_CLOEXEC);
+		if( got < 0 && errno == EINTR )
+			continue;
+		if( got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+			return READ_MORE;
+		if( got <= 0 )
+			return READ_FAILED;
+
+		// The stdio comes with the first part of the request.
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		if( cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(int) * 3) )
+		{
+			if( rRun.mFds[0] >= 0 )
+			{
+				int fds[3];
+				memcpy(fds,CMSG_DATA(cmsg),sizeof(fds));
+				for( int fd : fds )
+					close(fd);
+				return READ_FAILED;
+			}
+			memcpy(rRun.mFds,CMSG_DATA(cmsg),sizeof(rRun.mFds));
+		}
+		rRun.mGot += (size_t)got;
+	}
+
+	const ZygoteRequest& request = rRun.mRequest;
+	if( rRun.mBlob.size() == 0 )
+	{
+		if( rRun.mFds[2] < 0 || request.mMagic != ZYGOTE_MAGIC || request.mArgc == 0 || request.mSize > MAX_REQUEST_SIZE )
+			return READ_FAILED;
+		rRun.mBlob.resize(request.mSize + 1,0);
+	}
+
+	while( rRun.mGot < sizeof(request) + request.mSize )
+	{
+		const size_t blobGot = rRun.mGot - sizeof(request);
+		const ssize_t got = read(rRun.mClient,rRun.mBlob.data() + blobGot,request.mSize - blobGot);
+		if( got < 0 && errno == EINTR )
+			continue;
+		if( got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+			return READ_MORE;
+		if( got <= 0 )
+			return READ_FAILED;
+		rRun.mGot += (size_t)got;
+	}
+
+	// The working folder, args and environment are all nul terminated, so running off the end is not possible.
+	if( (size_t)std::count(rRun.mBlob.begin(),rRun.mBlob.end() - 1,0) < 1 + (size_t)request.mArgc + (size_t)request.mEnvc )
+		return READ_FAILED;
+	return READ_DONE;
+}
+
+/**
+ * @brief The request has all been read, loads the module if it's not loaded and forks the run.
+ */
+void ModuleHost::StartRun(IncomingRun& rRun)
+{
+	// The module is argv[0], which comes after the working folder.
+	const char* moduleName = rRun.mBlob.data() + strlen(rRun.mBlob.data()) + 1;
+	bool retire = false;
+	ScriptMain scriptMain = LoadModule(mModules,moduleName,retire);
+	if( retire )
+	{
+		std::clog << "Module " << moduleName << " was rebuilt but the old one can not be unloaded, no longer taking runs\n";
+		StopListening();
+	}
+
+	pid_t pid = -1;
+	if( scriptMain && mPending.size() < MAX_PENDING_RUNS )
+	{
+		std::cout << std::flush;
+		std::clog << std::flush;
+		fflush(nullptr);
+		pid = fork();
+		if( pid == 0 )
+			RunScript(scriptMain,rRun.mClient,rRun.mFds,rRun.mBlob.data(),rRun.mRequest);
+	}
+
+	if( pid <= 0 )
+	{
+		RefuseRun(rRun);
+		return;
+	}
+
+	for( int n = 0 ; n < 3 ; n++ )
+	{
+		close(rRun.mFds[n]);
+	}
+	SendInt(rRun.mClient,(int32_t)pid);
+	mPending.push_back({pid,rRun.mClient});
+}
+
+/**
+ * @brief Tells the client to run the script itself.
+ */
+void ModuleHost::RefuseRun(IncomingRun& rRun)
+{
+	for( int n = 0 ; n < 3 ; n++ )
+	{
+		if( rRun.mFds[n] >= 0 )
+			close(rRun.mFds[n]);
+	}
+	SendInt(rRun.mClient,0);
+	close(rRun.mClient);
+}
+
+void ModuleHost::ReapChildren()
+{
+	int status;
+	pid_t pid;
+	while( (pid = waitpid(-1,&status,WNOHANG)) > 0 )
+	{
+		for( size_t n = 0 ; n < mPending.size() ; n++ )
+		{
+			if( mPending[n].mPid == pid )
+			{
+				SendInt(mPending[n].mClient,(int32_t)status);
+				close(mPending[n].mClient);
+				mPending[n] = mPending.back();
+				mPending.pop_back();
+				break;
+			}
+		}
+	}
+}
+
+void ModuleHost::Serve(int pIdleSeconds)
+{
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask,SIGCHLD);
+	sigaddset(&mask,SIGTERM);
+	sigaddset(&mask,SIGINT);
+	sigaddset(&mask,SIGHUP);
+	sigprocmask(SIG_BLOCK,&mask,&mOldMask);
+	mSignals = signalfd(-1,&mask,SFD_CLOEXEC);
+	if( mSignals < 0 || Listen() == false )
+		return;
+
+	std::clog << "Module host listening on " << mSocketFile << std::endl;
+	std::vector<pollfd> fds;
+	while( mListen >= 0 || mPending.size() > 0 || mIncoming.size() > 0 )
+	{
+		// The clients still sending their request are polled too, woken for the first of their deadlines.
+		fds = {{mSignals,POLLIN,0},{mListen,POLLIN,0}};
+		int timeout = (mPending.size() == 0 && pIdleSeconds > 0) ? pIdleSeconds * 1000 : -1;
+		if( mIncoming.size() > 0 )
+		{
+			const auto now = std::chrono::steady_clock::now();
+			timeout = REQUEST_TIMEOUT_MS;
+			for( const IncomingRun& run : mIncoming )
+			{
+				fds.push_back({run.mClient,POLLIN,0});
+				const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(run.mDeadline - now).count() + 1;
+				timeout = std::max(0,std::min(timeout,(int)left));
+			}
+		}
+
+		const int ready = poll(fds.data(),fds.size(),timeout);
+		if( ready < 0 && errno == EINTR )
+			continue;
+
+		if( ready < 0 || (ready == 0 && mIncoming.size() == 0) )
+		{
+			StopListening();
+			continue;
+		}
+
+		if( fds[0].revents & POLLIN )
+		{
+			signalfd_siginfo info;
+			if( read(mSignals,&info,sizeof(info)) == sizeof(info) )
+			{
+				if( info.ssi_signo == SIGCHLD )
+					ReapChildren();
+				else
+					StopListening();
+			}
+		}
+
+		// Backwards as finished ones are swapped with the last, which has been looked at already.
+		const auto now = std::chrono::steady_clock::now();
+		for( size_t n = mIncoming.size() ; n > 0 ; n-- )
+		{
+			IncomingRun& run = mIncoming[n - 1];
+			ReadState state = READ_MORE;
+			if( fds[n + 1].revents != 0 )
+				state = ReadRequest(run);
+			if( state == READ_MORE && now >= run.mDeadline )
+				state = READ_FAILED;
+
+			if( state == READ_MORE )
+				continue;
+
+			if( state == READ_DONE )
+				StartRun(run);
+			else
+				RefuseRun(run);
+			if( n < mIncoming.size() )
+				run = std::move(mIncoming.back());
+			mIncoming.pop_back();
+		}
+
+		if( mListen >= 0 && (fds[1].revents & POLLIN) )
+			AcceptConnection();
+	}
+	std::clog << "Module host stopped, " << mModules.size() << " modules were loaded" << std::endl;
+}
+
+std::filesystem::path GetModuleHostSocketFilename(const std::filesystem::path& pTempFolder)
+{
+	return pTempFolder / ".seabang" / "module-host.sock";
+}
+
+bool StartModuleHost(const std::filesystem::path& pTempFolder,int pIdleSeconds)
+{
+	const std::filesystem::path socketFile = GetModuleHostSocketFilename(pTempFolder);
+	std::error_code ec;
+	std::filesystem::create_directories(socketFile.parent_path(),ec);
+
+	// The job process is the host, it holds the lock for as long as it runs so there is only ever one.
+	return StartBackgroundJob(socketFile.parent_path() / "module-host.lock",socketFile.parent_path() / "module-host.log",[&]()
+	{
+		ModuleHost host(socketFile);
+		host.Serve(pIdleSeconds);
+	});
+}
+
+bool RunModule(const std::filesystem::path& pModuleName,const std::vector<std::string>& pArgs,int& rExitCode)
+{
+	void* handle;
+	const ScriptMain scriptMain = OpenModule(pModuleName.string(),handle);
+	if( scriptMain == nullptr )
+		return false;
+
+	std::vector<std::string> args = {pModuleName.string()};
+	args.insert(args.end(),pArgs.begin(),pArgs.end());
+
+	std::vector<char*> argv;
+	for( std::string& arg : args )
+		argv.push_back(arg.data());
+	argv.push_back(nullptr);
+
+	std::cout << std::flush;
+	rExitCode = scriptMain((int)args.size(),argv.data(),environ);
+	return true;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file module_host.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __MODULE_HOST_H__
+#define __MODULE_HOST_H__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// A module is a script built as a position independent shared object with its main renamed, see ZYGOTE_SCRIPT_MAIN.
+// The module host is one long lived process per temp folder that dlopens the modules it is asked to run and keeps them open.
+// It takes the same requests as a zygote, the module to run is argv[0]. Each run is forked from the host, so a script that
+// calls exit, crashes or leaves its globals in a mess does not take the host, or the next run, with it. What is saved is the
+// exec, the dynamic link and the static initialisation, which is done once when the module is first loaded.
+// A module that has been rebuilt is opened again, if the old one can not be unloaded the host stops taking requests
+// so the next run starts a new one. It also exits after being idle for a while.
+
+// How long the host waits for a request before exiting, in seconds.
+const int MODULE_HOST_DEFAULT_IDLE_SECONDS = 300;
+
+// The unix socket the host for the temp folder listens on.
+std::filesystem::path GetModuleHostSocketFilename(const std::filesystem::path& pTempFolder);
+
+// Starts the host in the background, does nothing if it is already running.
+bool StartModuleHost(const std::filesystem::path& pTempFolder,int pIdleSeconds);
+
+// Loads the module into this process and runs it, for when there is no host to take the run.
+bool RunModule(const std::filesystem::path& pModuleName,const std::vector<std::string>& pArgs,int& rExitCode);
+
+#endif //#ifndef __MODULE_HOST_H__
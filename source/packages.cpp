@@ -0,0 +1,249 @@
+/**
+ * @file packages.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <algorithm>
+
+#include "packages.h"
+#include "source_scanner.h"
+#include "execute_command.h"
+#include "hash.h"
+
+static const char* SkipSpace(const char* pPos,const char* pEnd)
+{
+	while( pPos < pEnd && (*pPos == ' ' || *pPos == '\t') )
+		pPos++;
+	return pPos;
+}
+
+/**
+ * @brief If the text at pPos is pWord, followed by space or the end, returns the position after it. If not returns nullptr.
+ */
+static const char* MatchWord(const char* pPos,const char* pEnd,const char* pWord)
+{
+	const size_t length = strlen(pWord);
+	if( (size_t)(pEnd - pPos) < length || memcmp(pPos,pWord,length) != 0 )
+		return nullptr;
+	pPos += length;
+	if( pPos < pEnd && *pPos != ' ' && *pPos != '\t' )
+		return nullptr;
+	return pPos;
+}
+
+/**
+ * @brief Returns the position after "# pragma seabang" at the start of the line, or nullptr if the line is not one.
+ */
+static const char* MatchSeabangPragma(const char* pLine,const char* pEnd)
+{
+	const char* pos = SkipSpace(pLine,pEnd);
+	if( pos == pEnd || *pos != '#' )
+		return nullptr;
+	pos = MatchWord(SkipSpace(pos + 1,pEnd),pEnd,"pragma");
+	if( pos == nullptr )
+		return nullptr;
+	return MatchWord(SkipSpace(pos,pEnd),pEnd,"seabang");
+}
+
+bool IsSeabangPragma(const char* pLine,size_t pLength)
+{
+	return MatchSeabangPragma(pLine,pLine + pLength) != nullptr;
+}
+
+bool GetPackagesFromSource(const std::filesystem::path& pSourceFile,std::vector<std::string>& rPackages)
+{
+	MappedFile source(pSourceFile);
+	if( source.IsOpen() == false )
+		return false;
+
+	const char* pos = source.Data();
+	const char* const end = pos + source.Size();
+	while( pos < end )
+	{
+		const char* lineEnd = (const char*)memchr(pos,'\n',end - pos);
+		if( lineEnd == nullptr )
+			lineEnd = end;
+
+		const char* args = MatchSeabangPragma(pos,lineEnd);
+		if( args )
+			args = MatchWord(SkipSpace(args,lineEnd),lineEnd,"pkg");
+
+		while( args && args < lineEnd )
+		{
+			args = SkipSpace(args,lineEnd);
+			const char* nameEnd = args;
+			while( nameEnd < lineEnd && *nameEnd != ' ' && *nameEnd != '\t' && *nameEnd != '\r' )
+				nameEnd++;
+			if( nameEnd > args )
+				rPackages.emplace_back(args,nameEnd - args);
+			args = nameEnd < lineEnd && *nameEnd == '\r' ? lineEnd : nameEnd;
+		}
+		pos = lineEnd + 1;
+	}
+	return true;
+}
+
+/**
+ * @brief The file's signature, if the .pc file is edited or replaced this changes.
+ */
+static std::string GetFileSignature(const std::filesystem::path& pFile)
+{
+	struct stat Stats;
+	if( stat(pFile.c_str(),&Stats) != 0 )
+		return "missing";
+
+	return std::to_string(Stats.st_ino) + " " +
+			std::to_string((int64_t)Stats.st_mtim.tv_sec * 1000000000LL + Stats.st_mtim.tv_nsec) + " " +
+			std::to_string(Stats.st_size);
+}
+
+static std::vector<std::string> SplitWords(const std::string& pString)
+{
+	std::vector<std::string> words;
+	std::stringstream stream(pString);
+	std::string word;
+	while( stream >> word )
+		words.push_back(word);
+	return words;
+}
+
+static std::string GetEnvironment(const char* pName)
+{
+	const char* value = getenv(pName);
+	return value ? value : "";
+}
+
+/**
+ * @brief Checks the cached flags are still good, they are if all the .pc files they came from are the same.
+ */
+static bool ReadCachedPackages(const std::filesystem::path& pCacheFile,std::vector<std::string>& rFlags)
+{
+	std::ifstream file(pCacheFile);
+	std::string line;
+	bool gotFlags = false;
+	while( std::getline(file,line) )
+	{
+		if( line.rfind("flags=",0) == 0 )
+		{
+			rFlags = SplitWords(line.substr(6));
+			gotFlags = true;
+		}
+		else if( line.rfind("pc=",0) == 0 )
+		{
+			// pc=<signature>|<path>
+			const size_t bar = line.find('|');
+			if( bar == std::string::npos || GetFileSignature(line.substr(bar + 1)) != line.substr(3,bar - 3) )
+				return false;
+		}
+	}
+	return gotFlags;
+}
+
+/**
+ * @brief Finds the .pc files for the packages and the packages they require, so the cache can tell when they change.
+ */
+static bool FindPackageFiles(const std::vector<std::string>& pPackages,std::vector<std::filesystem::path>& rFiles,std::string& rError)
+{
+	std::vector<std::string> toFind = pPackages;
+	std::set<std::string> found;
+	while( toFind.size() > 0 )
+	{
+		const std::string package = toFind.back();
+		toFind.pop_back();
+		if( found.insert(package).second == false )
+			continue;
+
+		std::string folder;
+		if( ExecuteShellCommand("pkg-config",{"--variable=pcfiledir",package},folder) == false )
+		{
+			rError = folder;
+			return false;
+		}
+		rFiles.push_back(std::filesystem::path(SplitWords(folder).size() ? SplitWords(folder)[0] : ".") / (package + ".pc"));
+
+		// One per line, the name may be followed by a version check.
+		std::string required;
+		if( ExecuteShellCommand("pkg-config",{"--print-requires","--print-requires-private",package},required) )
+		{
+			std::stringstream lines(required);
+			std::string line;
+			while( std::getline(lines,line) )
+			{
+				const std::vector<std::string> words = SplitWords(line);
+				if( words.size() > 0 )
+					toFind.push_back(words[0]);
+			}
+		}
+	}
+	return true;
+}
+
+bool ResolvePackages(const std::vector<std::string>& pPackages,const std::filesystem::path& pTempFolder,std::vector<std::string>& rFlags,std::string& rError)
+{
+	std::vector<std::string> packages = pPackages;
+	std::sort(packages.begin(),packages.end());
+	packages.erase(std::unique(packages.begin(),packages.end()),packages.end());
+
+	// What pkg-config answers depends on where it looks as well as the names.
+	std::string key;
+	for( const std::string& package : packages )
+		key += package + " ";
+	key += "\n" + GetEnvironment("PKG_CONFIG_PATH") + "\n" + GetEnvironment("PKG_CONFIG_LIBDIR") + "\n" + GetEnvironment("PKG_CONFIG_SYSROOT_DIR");
+
+	const std::filesystem::path cacheFile = pTempFolder / ".seabang" / "pkg" / HashToString(HashString(key));
+	if( ReadCachedPackages(cacheFile,rFlags) )
+		return true;
+
+	std::vector<std::string> args = {"--cflags","--libs"};
+	args.insert(args.end(),packages.begin(),packages.end());
+	std::string flags;
+	if( ExecuteShellCommand("pkg-config",args,flags) == false )
+	{
+		rError = flags;
+		return false;
+	}
+	rFlags = SplitWords(flags);
+
+	std::vector<std::filesystem::path> pcFiles;
+	if( FindPackageFiles(packages,pcFiles,rError) == false )
+		return false;
+
+	std::error_code ec;
+	std::filesystem::create_directories(cacheFile.parent_path(),ec);
+
+	// Written to the side and renamed so a seabang running at the same time never sees half of it.
+	const std::filesystem::path tempFile = (std::filesystem::path(cacheFile) += "." + std::to_string(getpid()));
+	{
+		std::ofstream file(tempFile,std::ios::trunc);
+		file << "flags=";
+		for( const std::string& flag : rFlags )
+			file << flag << " ";
+		file << "\n";
+		for( const std::filesystem::path& pcFile : pcFiles )
+			file << "pc=" << GetFileSignature(pcFile) << "|" << pcFile.string() << "\n";
+	}
+	std::filesystem::rename(tempFile,cacheFile,ec);
+	return true;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file packages.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __PACKAGES_H__
+#define __PACKAGES_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Packages are libraries known to pkg-config. They can be named in the shebang, --seabang-pkg=zlib,libpng
+// or in the source with a line like this, the line is commented out in the copy that is compiled.
+// #pragma seabang pkg zlib libpng
+
+// Returns true if the line is a #pragma seabang line. pLength is the length of the line without the line ending.
+bool IsSeabangPragma(const char* pLine,size_t pLength);
+
+// Adds the packages named by #pragma seabang pkg lines in the source to rPackages.
+bool GetPackagesFromSource(const std::filesystem::path& pSourceFile,std::vector<std::string>& rPackages);
+
+// Gets the compile and link flags for the packages from pkg-config. The answer is cached in <temp>/.seabang/pkg,
+// and is used until one of the .pc files it came from changes, so pkg-config is only run the first time.
+// On failure rError has what pkg-config said.
+bool ResolvePackages(const std::vector<std::string>& pPackages,const std::filesystem::path& pTempFolder,std::vector<std::string>& rFlags,std::string& rError);
+
+#endif //#ifndef __PACKAGES_H__
@@ -0,0 +1,181 @@
+/**
+ * @file remote_cache.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+
+#include <fstream>
+#include <vector>
+
+#include "remote_cache.h"
+#include "http_client.h"
+#include "hash.h"
+
+std::string GetRemoteCacheKey(const BundleManifest& pManifest)
+{
+	uint64_t hash = HASH_SEED;
+	for( const std::string field : {"source-hash","variant","compiler-version","flags","cpu-target"} )
+	{
+		const auto value = pManifest.find(field);
+		if( value == pManifest.end() || value->second.size() == 0 )
+			return "";
+
+		// The name goes in too, and the new line, so values can not run into each other.
+		hash = HashString(field + "=" + value->second + "\n",hash);
+	}
+	return HashToString(hash);
+}
+
+/**
+ * @brief Sends the request, and the body from pBodyFile if there is one, and reads the response header.
+ * Returns the socket, ready to read the rest of the response from, or -1 if it failed.
+ */
+static int SendRequest(const std::string& pMethod,const std::string& pURL,const std::string& pKey,const std::filesystem::path& pBodyFile,const std::string& pToken,const Deadline& pDeadline,int& rStatus,int64_t& rContentLength,std::string& rBody,std::string& rError)
+{
+	std::string host,port,path;
+	if( ParseURL(pURL,host,port,path,rError) == false )
+		return -1;
+
+	std::ifstream body;
+	uint64_t bodySize = 0;
+	if( pBodyFile.empty() == false )
+	{
+		body.open(pBodyFile,std::ios::binary);
+		std::error_code ec;
+		bodySize = std::filesystem::file_size(pBodyFile,ec);
+		if( !body || ec )
+		{
+			rError = "could not read " + pBodyFile.string();
+			return -1;
+		}
+	}
+
+	const int s = HttpConnect(host,port,pDeadline,rError);
+	if( s < 0 )
+		return -1;
+
+	std::string request = pMethod + " " + path + "/" + pKey + " HTTP/1.1\r\n";
+	request += "Host: " + host + ":" + port + "\r\n";
+	request += "User-Agent: seabang\r\n";
+	request += "Connection: close\r\n";
+	if( pToken.empty() == false )
+	{
+		request += "Authorization: Bearer " + pToken + "\r\n";
+	}
+	if( pBodyFile.empty() == false )
+	{
+		request += "Content-Type: application/octet-stream\r\n";
+		request += "Content-Length: " + std::to_string(bodySize) + "\r\n";
+	}
+	request += "\r\n";
+
+	bool sent = SendAll(s,request.data(),request.size(),pDeadline);
+	std::vector<char> buf(64 * 1024);
+	while( sent && body.is_open() && body )
+	{
+		body.read(buf.data(),buf.size());
+		sent = SendAll(s,buf.data(),(size_t)body.gcount(),pDeadline);
+	}
+
+	if( sent == false )
+	{
+		rError = "failed to send the request to " + host + ":" + port;
+		close(s);
+		return -1;
+	}
+
+	if( ReceiveResponseHeader(s,pDeadline,rStatus,rContentLength,rBody,rError) == false )
+	{
+		close(s);
+		return -1;
+	}
+	return s;
+}
+
+bool RemoteCacheGet(const std::string& pURL,const std::string& pKey,const std::filesystem::path& pFile,int pTimeoutMS,std::string& rError)
+{
+	rError.clear();
+	const Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMS);
+
+	int status;
+	int64_t contentLength;
+	std::string received;
+	const int s = SendRequest("GET",pURL,pKey,"","",deadline,status,contentLength,received,rError);
+	if( s < 0 )
+		return false;
+
+	if( status != 200 )
+	{
+		close(s);
+		if( status != 404 )
+			rError = "server said " + std::to_string(status);
+		return false;
+	}
+
+	if( contentLength < 0 )
+	{
+		close(s);
+		rError = "no Content-Length in the response";
+		return false;
+	}
+
+	std::ofstream file(pFile,std::ios::binary|std::ios::trunc);
+	int64_t got = (int64_t)received.size();
+	file.write(received.data(),received.size());
+
+	std::vector<char> buf(64 * 1024);
+	while( got < contentLength && file )
+	{
+		const ssize_t read = ReceiveSome(s,buf.data(),buf.size(),deadline);
+		if( read <= 0 )
+			break;
+		file.write(buf.data(),read);
+		got += read;
+	}
+	close(s);
+	file.close();
+
+	if( got != contentLength || !file )
+	{
+		rError = "download cut short, got " + std::to_string(got) + " of " + std::to_string(contentLength) + " bytes";
+		std::filesystem::remove(pFile);
+		return false;
+	}
+	return true;
+}
+
+bool RemoteCachePut(const std::string& pURL,const std::string& pKey,const std::filesystem::path& pFile,const std::string& pToken,int pTimeoutMS,std::string& rError)
+{
+	rError.clear();
+	const Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(pTimeoutMS);
+
+	int status;
+	int64_t contentLength;
+	std::string received;
+	const int s = SendRequest("PUT",pURL,pKey,pFile,pToken,deadline,status,contentLength,received,rError);
+	if( s < 0 )
+		return false;
+	close(s);
+
+	if( status < 200 || status > 299 )
+	{
+		rError = "server said " + std::to_string(status);
+		return false;
+	}
+	return true;
+}
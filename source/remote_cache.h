@@ -0,0 +1,48 @@
+/**
+ * @file remote_cache.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __REMOTE_CACHE_H__
+#define __REMOTE_CACHE_H__
+
+#include <string>
+#include <filesystem>
+
+#include "bundle.h"
+
+// A remote cache is a plain http server that execs are shared through, as bundles, between hosts.
+// The bundle for a key is at <url>/<key>, it is fetched with GET and stored with PUT.
+// tools/seabang-cache-server.cpp is a small server that does this.
+// A fetched bundle is only checked against the manifest that came with it, nothing says who built it. So anyone who can
+// upload to the server can have every host that uses it run their code, the server has to only take uploads from hosts
+// that are trusted. The server can be run read only or made to want an upload token, sent as a bearer token.
+
+const int REMOTE_CACHE_DEFAULT_TIMEOUT_MS = 3000;
+
+// The key is made from what the exec was built from and for, but not where the source is, so the same script anywhere shares the exec.
+// Returns an empty string if the manifest does not have all that is needed, such as when there is no compiler to get the version of.
+std::string GetRemoteCacheKey(const BundleManifest& pManifest);
+
+// Downloads the bundle for the key into pFile. Returns false if it is not there, rError is empty, or if it could not be got, rError says why.
+// The whole request has to be done within the timeout.
+bool RemoteCacheGet(const std::string& pURL,const std::string& pKey,const std::filesystem::path& pFile,int pTimeoutMS,std::string& rError);
+
+// Uploads the bundle in pFile for the key. If pToken is not empty it is sent as the bearer token, for a server that wants one.
+bool RemoteCachePut(const std::string& pURL,const std::string& pKey,const std::filesystem::path& pFile,const std::string& pToken,int pTimeoutMS,std::string& rError);
+
+#endif //#ifndef __REMOTE_CACHE_H__
@@ -18,6 +18,24 @@
  */
 #include "execute_command.h"
 #include "dependencies.h"
+#include "benchmark.h"
+#include "build_variant.h"
+#include "bundle.h"
+#include "hash.h"
+#include "toolchain.h"
+#include "build_key.h"
+#include "background_job.h"
+#include "zygote.h"
+#include "module_host.h"
+#include "token_hash.h"
+#include "job_slot.h"
+#include "packages.h"
+#include "compile_trace.h"
+#include "remote_cache.h"
+#include "cache_tier.h"
+#include "snippet.h"
+#include "compile_worker.h"
+#include "stat_cache.h"
 
 #include <limits.h>
 #include <string.h>
@@ -25,14 +43,21 @@
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <signal.h>
 
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <memory>
 #include <filesystem>
 #include <algorithm>
+#include <future>
+#include <chrono>
 
 #define STRINGIFY(x) #x
 #define TOSTRING(x) STRINGIFY(x)
@@ -41,6 +66,34 @@ static bool gVerboseLogging = false;
 
 #define VLOG(__THING_TO_LOG) {if( gVerboseLogging ){std::clog << __THING_TO_LOG << "\n";}}
 
+// Set by --seabang-explain, says why the exec is being rebuilt, or that it is not.
+static bool gExplainRebuild = false;
+
+#define EXPLAIN(__THING_TO_LOG) {if( gExplainRebuild ){std::clog << __THING_TO_LOG << "\n";}}
+
+// For --seabang-speculate, how long the dependency check can take before the build is started anyway.
+static const int SPECULATE_DEFAULT_MS = 50;
+
+/**
+ * @brief Everything about how the source file is built, worked out once in main and passed to the functions that build it.
+ */
+struct BuildSettings
+{
+    std::string mCompiler;
+    std::string mToolchain;     // The compiler's fingerprint, empty if the compiler could not be found.
+    std::filesystem::path mCWD;
+    std::filesystem::path mPathedSourceFile;
+    std::filesystem::path mTempSourcefile;
+    std::filesystem::path mTempFolder;
+    std::vector<std::string> mCompilerExtraArguments;
+    int mMaxJobs = 0;           // How many compiles can run on the host at once, zero for no limit.
+    bool mTimeTrace = false;    // Time the compile and keep the trace next to the exec.
+    bool mIgnoreCosmetic = false;// Keep the token hashes of what the exec is built from, so edits to comments and white space can be ignored.
+    bool mRememberFailures = false;// Record a failed compile so the same inputs are not built again, see KnownBrokenBuild.
+    std::vector<std::string> mWorkers;// Compile workers to send the compile to, the object comes back to be linked here.
+    int mWorkerTimeout = 0;     // How long the workers have to get the object back before it's compiled here.
+};
+
 static std::vector<std::string> SplitString(const std::string& pString, const char* pSeperator)
 {
     std::vector<std::string> res;
@@ -60,6 +113,18 @@ inline bool SearchString(const std::vector<std::string>& pVec,const std::string&
    return std::find(pVec.begin(),pVec.end(),pLost) != pVec.end();
 }
 
+static std::string JoinStrings(const std::vector<std::string>& pStrings,const char* pSeperator)
+{
+    std::string joined;
+    for( const std::string& s : pStrings )
+    {
+        if( joined.size() > 0 )
+            joined += pSeperator;
+        joined += s;
+    }
+    return joined;
+}
+
 static bool CompareNoCase(const std::string& a, const std::string& b)
 {
     // Early out, if not same length, not the same.
@@ -117,20 +182,51 @@ static std::string GetArgumentValue(const std::vector<std::string>& args, const
 {
     for( auto s : args )
     {
-        if( CompareNoCase(s,theArg) )
+        // Does the arg contain an = sign? If so the name is everything before it.
+        const size_t equality = s.find('=');
+        if( equality != std::string::npos && CompareNoCase(s.substr(0,equality),theArg) )
         {
-            // Does the arg contain an = sign?
-            const size_t equality = s.find('=');
-            if( equality != std::string::npos )
-            {
-                // Grab the rest of the string as the value.
-                return s.substr(equality+1);
-            }
+            // Grab the rest of the string as the value.
+            return s.substr(equality+1);
         }
     }
     return "";
 }
 
+/**
+ * @brief Get the value that an argument is set to as a number.
+ * If the argument is not there, or is not a number, pDefault is returned.
+ */
+static int GetArgumentValueAsInt(const std::vector<std::string>& args, const std::string theArg,int pDefault)
+{
+    const std::string value = GetArgumentValue(args,theArg);
+    if( value.size() > 0 )
+    {
+        try
+        {
+            return std::stoi(value);
+        }
+        catch(...)
+        {
+            std::cerr << "The value for " << theArg << " is not a number, " << value << "\n";
+        }
+    }
+    return pDefault;
+}
+
+/**
+ * @brief The value of the argument, or if it was not given the environment variable, or empty if neither are set.
+ */
+static std::string GetArgumentOrEnvironment(const std::vector<std::string>& args,const std::string theArg,const char* pEnvironmentName)
+{
+    const std::string value = GetArgumentValue(args,theArg);
+    if( value.size() == 0 && getenv(pEnvironmentName) != nullptr )
+    {
+        return getenv(pEnvironmentName);
+    }
+    return value;
+}
+
 /**
  * @brief Get the Arguments passed to the file that is being executed
  * These arguments are then passed to the compiled exec.
@@ -278,6 +374,105 @@ static const std::string SelectComplier(const std::vector<std::string>& seaBangE
     return SEABANG_CXX_COMPILER;
 }
 
+/**
+ * @brief Selects the build variant, --seabang-variant=NAME, with --debug kept as a short cut for the debug variant.
+ */
+static const BuildVariant* SelectBuildVariant(const std::vector<std::string>& seaBangExtraArguments)
+{
+    std::string variantName = GetArgumentValue(seaBangExtraArguments,"--seabang-variant");
+    if( variantName.empty() )
+    {
+        variantName = SearchString(seaBangExtraArguments,"--debug") ? "debug" : "release";
+    }
+
+    const BuildVariant* variant = FindBuildVariant(variantName);
+    if( variant == nullptr )
+    {
+        std::cerr << "Unknown build variant " << variantName << ", expected one of " << GetBuildVariantNames() << "\n";
+        return nullptr;
+    }
+
+    VLOG("Using build variant " << variant->mName);
+    return variant;
+}
+
+/**
+ * @brief Copy all lines of the file over excluding the first line that has the shebang.
+ * It's written to the side and renamed into place as a background build maybe compiling the old one.
+ */
+static bool CopySourceWithoutShebang(const std::filesystem::path& pPathedSourceFile,const std::filesystem::path& pTempSourcefile)
+{
+    std::string line;
+    const std::filesystem::path newSourcefile = (std::filesystem::path(pTempSourcefile) += "." + std::to_string(getpid()));
+    std::ifstream oldSource(pPathedSourceFile);
+    std::ofstream newSource(newSourcefile);
+    if( newSource )
+    {
+        bool foundShebang = false;
+
+        while( std::getline(oldSource,line) )
+        {
+            VLOG(line);
+
+            if( line[0] == '#' && line[1] == '!' ) // Is it the shebang? If so remove it.
+            {
+                foundShebang = true;
+            }
+            else if( IsSeabangPragma(line.data(),line.size()) ) // Our pragmas are commented out, the compiler would warn about them.
+            {
+                newSource << "// " << line << std::endl;
+            }
+            else
+            {
+                newSource << line << std::endl;
+            }
+        }
+
+        newSource.close();
+        if( !foundShebang )
+        {
+            std::filesystem::remove(newSourcefile);
+            std::cerr << "Failed to parse the source file..." << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        std::cerr << "Failed to parse the source file into new temp file..." << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(newSourcefile,pTempSourcefile,ec);
+    if( ec )
+    {
+        std::cerr << "Failed to write temp file " << pTempSourcefile << " " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the arguments for seabang from the shebang line of the source file.
+ * When the script is run the OS passes these in as argv[1], but when seabang is run from the
+ * command line, for example to export the exec, we have to read them ourselves.
+ */
+static std::vector<std::string> GetArgumentsFromShebang(const std::filesystem::path& pPathedSourceFile)
+{
+    std::string line;
+    std::ifstream source(pPathedSourceFile);
+    if( std::getline(source,line) && line.size() > 2 && line[0] == '#' && line[1] == '!' )
+    {
+        // Skip the path to seabang, the rest is the arguments.
+        const size_t space = line.find_first_of(" \t");
+        if( space != std::string::npos )
+        {
+            return SplitString(line.substr(space+1)," ");
+        }
+    }
+    return std::vector<std::string>();
+}
+
 static std::filesystem::path ChooseTempSourceFilename(const std::filesystem::path &tempFolderPath,bool compactTempPath,const std::filesystem::path &pathedSourceFile)
 {
     std::filesystem::path pathedFilename = tempFolderPath;
@@ -302,168 +497,1769 @@ static std::filesystem::path ChooseTempSourceFilename(const std::filesystem::pat
 }
 
 /**
- * @brief Displays the help text.
+ * @brief The flags that decide what the exec is built like, everything but the input, output and search path.
  */
-static void DisplayHelp()
+static std::vector<std::string> GetCompilerFlags(const BuildVariant& pVariant,const std::vector<std::string>& pCompilerExtraArguments)
 {
-const std::string_view helpText =
-R"(
-Usage: #!/usr/bin/seabang [OPTION]
-This command is not to be executed directly but to be placed at the top of a c/c++ source file.
-The options specified here are ones that either affect the operation of seabang or are passed to the compiler.
-Options from the code file being run are passed in as usual, for example hello_world.cpp --help
-seabang does not have any short options so that they do not clash with options for the compiler.
-seabang was built to use the Compiler )" TOSTRING(SEABANG_CXX_COMPILER) R"(
-seaband was built to use the temporay folder )" TOSTRING(SEABANG_TEMPORARY_FOLDER) R"(
-Please note, due to the way shebang options work, any argument for seabang and that takes an value
-   must not contain a space. For example '--seabang-compiler=compiler' is ok,
-   '--seabang-compiler = compiler' will fail.
-
-The environment varible SEABANG_CXX_COMPILER can be used to change the compiler used by default.
-    eg. SEABANG_CXX_COMPILER=gcc ./my-code.cpp
-
-The environment varible SEABANG_TEMPORARY_FOLDER can be used to change the tempoary folder used by default.
-    eg. SEABANG_TEMPORARY_FOLDER=~/tmp ./my-code.cpp
-
-Mandatory arguments to long options are mandatory for short options too.
-    --seabang-compiler=compiler Allows a specific source file to use a compiler that is not the norm.
-              This overides the compiler set with SEABANG_CXX_COMPILER and the default one.
-              Example, --seabang-compiler=gcc
-
-    --seabang-temp-path=PATH Allows a specific source file to use a particular temporay folder.
-              This overides the compiler set with SEABANG_TEMPORARY_FOLDER and the default one.
-              Example, --seabang-temp-path=./bin
-
-    --verbose Enables logging so you can see what seabang is doing.
-              Also enables verbose logging for the compiler.
-
-    --rebuild Forces a rebuild of the code. Normally seabang will only
-              build the code if the source file, or a dependency, has changed.
-
-    --debug   By default the code is built with optimisations set to 2 and not symbol files created.
-              This options turns of all optimisations and generates the symbols needed for debbugging.
-              Turn on verbose output to discover the out location of the exec if you need to debug it.
+    std::vector<std::string> flags;
 
-    --compact-path By default the temporay folder used for the intermidiary files includes the path of the source file.
-                   This is done to avoid file clashes. If there is a reason that this can not work for you
-                   then this option removes this. The intermediary files will use the temporay path
-                   plus the sources filename.
+    // The flags for the variant being built, release, debug, asan and so on.
+    for( auto arg : pVariant.mCompilerArgs )
+    {
+        flags.push_back(arg);
+    }
 
-All single dash options (eg -lncurses) are passed to the compiler. This allows you to have some more
-control over the build settings. Such as specifying an optimisation option or a machine option.
+    // For now we'll assume c++17, later add option to allow them to define this. Will always default to c++17
+    flags.push_back("-std=c++17");
+    flags.push_back("-Wall"); // Lots of warnings please.
+    
+    flags.push_back("-lm");  // Maths libs
+    flags.push_back("-lstdc++");  // C++ stuff
+    flags.push_back("-lpthread");  // For threading
 
-Seabang is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-seabang is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-You should have received a copy of the GNU General Public License
-along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+    // Add stuff passed in for the compiler
+    for( auto arg : pCompilerExtraArguments )
+    {
+        flags.push_back(arg);
+    }
+    return flags;
+}
 
-)";
+/**
+ * @brief Hashes the contents of the source file and every local file it includes.
+ */
+static std::string GetSourceHash(const std::filesystem::path& pPathedSourceFile,const std::filesystem::path& pCWD)
+{
+    Dependencies::PathVec includePaths;
+    includePaths.push_back(pCWD);
+    Dependencies::PathVec dependencies;
+    Dependencies sourceFileDependencies;
+    sourceFileDependencies.GetDependencies(pPathedSourceFile,includePaths,dependencies);
+
+    uint64_t hash = HASH_SEED;
+    HashFile(pPathedSourceFile,hash);
+    for( const std::filesystem::path& file : dependencies )
+    {
+        HashFile(file,hash);
+    }
+    return HashToString(hash);
+}
 
-    std::cout << helpText << "\n";
+/**
+ * @brief What a failed build is recorded against, the source hash and the paths of the local files the source includes.
+ * The paths are in it so that creating a local header that was missing, even an empty one, counts as a change.
+ */
+static std::string GetFailedBuildHash(const std::filesystem::path& pPathedSourceFile,const std::filesystem::path& pCWD,const std::string& pSourceHash)
+{
+    Dependencies::PathVec includePaths;
+    includePaths.push_back(pCWD);
+    Dependencies::PathVec dependencies;
+    Dependencies sourceFileDependencies;
+    sourceFileDependencies.GetDependencies(pPathedSourceFile,includePaths,dependencies);
+
+    uint64_t hash = HASH_SEED;
+    hash = HashString(pSourceHash,hash);
+    for( const std::filesystem::path& file : dependencies )
+    {
+        hash = HashString(file.string(),hash);
+    }
+    return HashToString(hash);
 }
 
 /**
- * @brief Our entrypoint called by the OS
+ * @brief The token hash of the source file and every local file it includes, see HashSourceTokens.
  */
-int main(int argc,char *argv[])
+static bool GetTokenHashes(const BuildSettings& pSettings,TokenHashes& rHashes)
 {
-    // See if they are looking for seabang help.
-    if( argc == 2 )
+    Dependencies::PathVec includePaths;
+    includePaths.push_back(pSettings.mCWD);
+    Dependencies::PathVec dependencies;
+    Dependencies sourceFileDependencies;
+    sourceFileDependencies.GetDependencies(pSettings.mPathedSourceFile,includePaths,dependencies);
+    dependencies.insert(dependencies.begin(),pSettings.mPathedSourceFile);
+
+    TokenHashCache cache(pSettings.mTempFolder);
+    for( const std::filesystem::path& file : dependencies )
     {
-        if( CompareNoCase(argv[1],"--help") )
+        uint64_t hash;
+        if( cache.GetHash(file,hash) == false )
         {
-            DisplayHelp();
-            return EXIT_SUCCESS;
+            return false;
         }
+        rHashes.emplace_back(file.string(),hash);
     }
+    cache.Save();
+    return true;
+}
 
-    // Got to be at least two args.
-    if( argc < 2 )
+/**
+ * @brief The flags for linking the variant, the compiler flags and then the variant's link args, or it's fallback ones.
+ */
+static std::vector<std::string> GetLinkFlags(const BuildVariant& pVariant,const std::vector<std::string>& pCompilerExtraArguments,bool pFallback)
+{
+    std::vector<std::string> flags = GetCompilerFlags(pVariant,pCompilerExtraArguments);
+    for( auto arg : (pFallback ? pVariant.mFallbackLinkArgs : pVariant.mLinkArgs) )
     {
-        std::cerr << "Seabang not run from a source file, expects at least two command line arguments.\n";
-        DisplayHelp();
-        return EXIT_FAILURE;
+        flags.push_back(arg);
     }
+    return flags;
+}
 
-    // The way the commandline works with a shebang is...
-    // argv[0] is the shebang exec name, so in our case will be seabang
-    // then comes the arguments passed to the seabang, in the source file, all as one argument, [1]
-    // If no arguments given then argv[1] will be the source file.
-    // If arguments were given then the source file will be in argv[2]
-    // Then the rest of the arguments are as we expect, one argv[n] per argument.
-    // And so we need to look if argv[1] is a file or not. If it is assume no args passed to the shebang, if it is not assume it's args for the seabang exec.
-    const std::string originalSourceFile = GetSourceFileFromArguments(argc,argv);
-    const std::vector<std::string> seaBangExtraArguments = GetArgumentsForSeabang(argc,argv);
-    const std::vector<std::string> applicationArguments = GetArgumentsForApplication(argc,argv);
-    const std::vector<std::string> compilerExtraArguments = GetArgumentsForCompiler(seaBangExtraArguments);
+/**
+ * @brief The build key is what the exec is built with, other than the source. If it changes the exec has to be rebuilt.
+ */
+static BuildKey MakeBuildKey(const BuildSettings& pSettings,const BuildVariant& pVariant)
+{
+    BuildKey key;
+    key.mToolchain = pSettings.mToolchain;
+    key.mFlags = JoinStrings(GetLinkFlags(pVariant,pSettings.mCompilerExtraArguments,false)," ");
+    return key;
+}
 
-    // Lets see if they want verbose logging.
-    // All seabang arguments are in long form so not to get mixed up with arguments for the compiler.
-    gVerboseLogging = SearchString(seaBangExtraArguments,"--verbose");
-    bool rebuildNeeded = SearchString(seaBangExtraArguments,"--rebuild");
-    const bool debugBuild = SearchString(seaBangExtraArguments,"--debug");
-    const bool compactTempPath = SearchString(seaBangExtraArguments,"--compact-path");
+/**
+ * @brief Checks the exec was built with the same compiler and flags that we would build it with now.
+ */
+static bool BuildKeyMatches(const std::filesystem::path& pExeName,const BuildKey& pCurrentKey)
+{
+    BuildKey builtKey;
+    if( ReadBuildKey(pExeName,builtKey) == false )
+    {
+        VLOG("No build key for " << pExeName);
+        return false;
+    }
 
-    if( gVerboseLogging )
+    const std::string difference = CompareBuildKey(builtKey,pCurrentKey);
+    if( difference.size() > 0 )
     {
-        LogArguments(seaBangExtraArguments,"seabang");
-        LogArguments(applicationArguments,"application");
-        LogArguments(compilerExtraArguments,"compiler");
+        VLOG("Build key for " << pExeName << " differs, " << difference);
+        return false;
     }
+    return true;
+}
 
-    const std::filesystem::path CWD = std::filesystem::current_path();
-    const std::filesystem::path pathedSourceFile = CWD / originalSourceFile;
+/**
+ * @brief Asks the compiler for its version, returns the first line or an empty string if it could not be run.
+ */
+static std::string GetCompilerVersion(const std::string& pCompiler)
+{
+    std::string output;
+    if( ExecuteShellCommand(pCompiler,{"--version"},output) == false )
+    {
+        return "";
+    }
+    return output.substr(0,output.find('\n'));
+}
 
-    // Sanity check, is file there? This is done to check for errors in the logic of the code above. 
-    if( std::filesystem::exists(pathedSourceFile) == false )
+static void LogCompilerCommand(const std::string& pCompiler,const std::vector<std::string>& pArgs)
+{
+    if( gVerboseLogging )
     {
-        VLOG("The source file we are trying to run is not found at: " << pathedSourceFile);
-        return EXIT_FAILURE;
+        std::cout << pCompiler << " ";
+        for(auto s : pArgs )
+        {
+            std::cout << s << " ";
+        }
+        std::cout << "\n\n";
     }
+}
 
-    // Get the path to the source file, need this as we need to insert the project configuration name so we can find it.
-    const std::filesystem::path sourceFilePath = std::filesystem::path(pathedSourceFile).remove_filename();
+/**
+ * @brief Preprocesses the source here and has one of the compile workers build the object from it.
+ * Returns false if it has to be compiled here, because there are no workers, the flags can't be used on one or none got it done in time.
+ */
+static bool CompileOnWorker(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pObjectFile,std::string& rOutput)
+{
+    if( pSettings.mWorkers.size() == 0 || pSettings.mTimeTrace )
+    {
+        return false;
+    }
 
-    // This is the temp folder path we use to cache build results.
-    const std::filesystem::path tempFolderPath(FindTemporayFolder(seaBangExtraArguments));
+    const std::vector<std::string> flags = GetCompilerFlags(pVariant,pSettings.mCompilerExtraArguments);
+    std::vector<std::string> workerFlags;
+    if( GetWorkerCompileFlags(flags,workerFlags) == false )
+    {
+        VLOG("The compiler flags can not be used on a compile worker, compiling here");
+        return false;
+    }
 
-    // We need the source file without the shebang too.
-    const std::filesystem::path tempSourcefile = ChooseTempSourceFilename(tempFolderPath,compactTempPath,pathedSourceFile);
+    const std::filesystem::path preprocessedFile = std::filesystem::path(pObjectFile).replace_extension(".ii");
+    std::vector<std::string> args = {pSettings.mTempSourcefile,"-I" + pSettings.mCWD.string()};
+    args.insert(args.end(),flags.begin(),flags.end());
+    args.push_back("-E");
+    args.push_back("-o");
+    args.push_back(preprocessedFile);
 
-    // Now we need to create the path to the compiled exec.
-    // This is done so we only have to build when something changes.
-    // To ensure no clashes I take the fully pathed temporay source file name and add .exe at the end.
-    const std::filesystem::path pathedExeName = (std::filesystem::path(tempSourcefile) += ".exe");
+    std::string output;
+    LogCompilerCommand(pSettings.mCompiler,args);
+    if( ExecuteShellCommand(pSettings.mCompiler,args,output) == false )
+    {
+        std::filesystem::remove(preprocessedFile);
+        VLOG("Failed to preprocess the source, compiling here\n" << output);
+        return false;
+    }
 
+    std::string worker,error;
+    output.clear();
+    const char* token = getenv("SEABANG_WORKER_TOKEN");
+    const bool compiledOK = CompileOnWorkers(pSettings.mWorkers,GetCompilerVersion(pSettings.mCompiler),workerFlags,preprocessedFile,pObjectFile,token ? token : "",pSettings.mWorkerTimeout,worker,output,error);
+    std::filesystem::remove(preprocessedFile);
+    if( compiledOK == false )
+    {
+        VLOG("No compile worker built it, " << error << ", compiling here");
+        return false;
+    }
 
-    // The temp folder that it's all done in.
-    const std::filesystem::path projectTempFolder = std::filesystem::path(tempSourcefile).remove_filename();
+    VLOG("Compiled on " << worker);
+    rOutput += output;
+    return true;
+}
 
-    // Pick the compiler that the user wants or was selected when the tool was built.
-    const std::string CompilerToUse = SelectComplier(seaBangExtraArguments);
+/**
+ * @brief Compiles the source to an object and then links it, for variants that need something done between the two or special link args.
+ * With compile workers it is always done this way, the object is compiled by a worker if it can be.
+ * For the zygote the object's main is renamed and it's linked with the zygote runtime that provides the real main.
+ * For a module the main is renamed too, so the module host can find it, and it's linked as a shared object.
+ * If the link fails and the variant has fallback link args it is linked again with them, the object does not need building again.
+ * rExitCode is the exit code of the compile or link that failed, -1 if a step failed some other way.
+ */
+static bool CompileAndLinkExecutable(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName,std::vector<std::string> pCompileArgs,std::string& rOutput,int& rExitCode)
+{
+    rExitCode = -1;
+    const std::filesystem::path objectFile = (std::filesystem::path(pExeName) += ".o");
+    pCompileArgs.push_back("-c");
+    pCompileArgs.push_back("-o");
+    pCompileArgs.push_back(objectFile);
+
+    // The output of each step is kept, so warnings from the compile are not lost when the link works.
+    std::string stepOutput;
+    auto keepOutput = [&](bool pWorked)
+    {
+        rOutput += stepOutput;
+        stepOutput.clear();
+        return pWorked;
+    };
 
-    // Make sure the new temp source file is not pointing to original source file.
-    if( std::filesystem::equivalent(pathedSourceFile,tempSourcefile) )
+    if( CompileOnWorker(pSettings,pVariant,objectFile,stepOutput) )
     {
-        VLOG("Error in temporay path. Original source file is same as temporay source file.\n    " << originalSourceFile << "\n    " << tempSourcefile);
-        return EXIT_FAILURE;
+        keepOutput(true);
+    }
+    else
+    {
+        LogCompilerCommand(pSettings.mCompiler,pCompileArgs);
+        if( keepOutput(ExecuteShellCommand(pSettings.mCompiler,pCompileArgs,stepOutput,&rExitCode)) == false )
+        {
+            return false;
+        }
+    }
+
+    std::vector<std::string> objects = {objectFile};
+    rExitCode = -1;
+    if( pVariant.mModule && keepOutput(RenameMainForZygote(objectFile,stepOutput)) == false )
+    {
+        std::filesystem::remove(objectFile);
+        return false;
+    }
+
+    if( pVariant.mZygote )
+    {
+        std::filesystem::path runtimeObject;
+        if( keepOutput(RenameMainForZygote(objectFile,stepOutput)) == false || keepOutput(BuildZygoteRuntime(pSettings.mCompiler,pSettings.mTempFolder,runtimeObject,stepOutput)) == false )
+        {
+            std::filesystem::remove(objectFile);
+            return false;
+        }
+        objects.push_back(runtimeObject);
+    }
+
+    auto link = [&](bool pFallback)
+    {
+        std::vector<std::string> linkArgs = objects;
+        for( auto arg : GetLinkFlags(pVariant,pSettings.mCompilerExtraArguments,pFallback) )
+        {
+            linkArgs.push_back(arg);
+        }
+        linkArgs.push_back("-o");
+        linkArgs.push_back(pExeName);
+
+        LogCompilerCommand(pSettings.mCompiler,linkArgs);
+        return ExecuteShellCommand(pSettings.mCompiler,linkArgs,stepOutput,&rExitCode);
+    };
+
+    bool linkedOK = link(false);
+    if( linkedOK == false && pVariant.mFallbackLinkArgs.size() > 0 )
+    {
+        VLOG("Link failed, trying again with the fallback link args\n" << stepOutput);
+        stepOutput.clear();
+        linkedOK = link(true);
+    }
+    keepOutput(linkedOK);
+
+    std::filesystem::remove(objectFile);
+    return linkedOK;
+}
+
+/**
+ * @brief Compiles the temporay source file, the one with the shebang removed, into the executable.
+ * When it works the build key is written next to the exec.
+ */
+static bool BuildExecutable(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    // Make source output is deleted so can run if there was a build error.
+    std::filesystem::remove(pExeName);
+    std::filesystem::remove(GetBuildKeyFilename(pExeName));
+    std::filesystem::remove(GetFailedBuildFilename(pExeName));
+    std::filesystem::remove(GetTimeTraceFilename(pExeName));
+    std::filesystem::remove(GetTokenHashFilename(pExeName));
+    if( pVariant.mZygote )
+    {
+        StopZygote(pExeName);
+    }
+
+    // Hashed before the compile, if the source is edited while we build the failure is not recorded against the new version.
+    const std::string sourceHash = GetSourceHash(pSettings.mPathedSourceFile,pSettings.mCWD);
+    TokenHashes tokenHashes;
+    const bool gotTokenHashes = pSettings.mIgnoreCosmetic && GetTokenHashes(pSettings,tokenHashes);
+
+    // Wait for our turn, so a lot of seabangs building at once do not run more compilers than the host can take.
+    JobSlot jobSlot(pSettings.mTempFolder,pSettings.mMaxJobs);
+    if( jobSlot.GetWaitTime() > 0 )
+    {
+        VLOG("Waited " << jobSlot.GetWaitTime() << "ms for a compile slot");
+    }
+
+    // First compile the new source file that is in the temp folder, this has the she bang removed, so it'll compile.
+    std::vector<std::string> args;
+
+    args.push_back(pSettings.mTempSourcefile);
+
+    // Need to add the current working dir as a search path.
+    // This is because the file maybe including a a file from a local path and not the system include folder.
+    // E.g #include "../somecode.cpp"
+    args.push_back("-I" + pSettings.mCWD.string());
+
+    for( auto arg : GetCompilerFlags(pVariant,pSettings.mCompilerExtraArguments) )
+    {
+        args.push_back(arg);
+    }
+
+    if( gVerboseLogging )
+    {
+        args.push_back("-v");
+    }
+
+    const bool clang = IsClangCompiler(pSettings.mCompiler,pSettings.mToolchain);
+    if( pSettings.mTimeTrace )
+    {
+        for( auto arg : GetTimeTraceFlags(clang,GetTimeTraceFilename(pExeName)) )
+        {
+            args.push_back(arg);
+        }
+    }
+
+    std::string compileOutput;
+    bool compliedOK;
+    int exitCode = -1;
+    if( pVariant.mZygote || pVariant.mLinkArgs.size() > 0 || (pSettings.mWorkers.size() > 0 && pSettings.mTimeTrace == false) )
+    {
+        compliedOK = CompileAndLinkExecutable(pSettings,pVariant,pExeName,args,compileOutput,exitCode);
+    }
+    else
+    {
+        // And set the output file.
+        args.push_back("-o");
+        args.push_back(pExeName);
+
+        LogCompilerCommand(pSettings.mCompiler,args);
+        compliedOK = ExecuteShellCommand(pSettings.mCompiler,args,compileOutput,&exitCode);
+    }
+    // Clang writes it's own trace, for gcc we make one from what it printed.
+    if( pSettings.mTimeTrace && clang == false )
+    {
+        GccTimeReport timeReport;
+        compileOutput = ParseGccTimeReport(compileOutput,timeReport);
+        if( compliedOK )
+        {
+            std::vector<std::string> headerFlags = {"-I" + pSettings.mCWD.string()};
+            for( auto arg : GetCompilerFlags(pVariant,pSettings.mCompilerExtraArguments) )
+            {
+                headerFlags.push_back(arg);
+            }
+
+            std::vector<TraceTiming> headerTimes;
+            MeasureHeaderTimes(pSettings.mCompiler,headerFlags,(std::filesystem::path(pExeName) += ".header.cpp"),timeReport.mHeaders,headerTimes);
+            WriteGccTimeTrace(GetTimeTraceFilename(pExeName),pSettings.mPathedSourceFile.string(),timeReport,headerTimes);
+        }
+    }
+
+    if( compileOutput.size() > 0 && (compliedOK == false || gVerboseLogging ) )
+    {
+        std::clog << compileOutput << "\n";
+    }
+
+    if( compliedOK )
+    {
+        BuildKey builtKey = MakeBuildKey(pSettings,pVariant);
+        builtKey.mSourceHash = sourceHash;
+        WriteBuildKey(pExeName,builtKey);
+        if( gotTokenHashes )
+        {
+            WriteTokenHashes(pExeName,tokenHashes);
+        }
+    }
+    else if( pSettings.mRememberFailures && exitCode > 0 )
+    {// Only when the compiler said the code is wrong, not when it was killed, ran out of memory or the disk was full.
+        WriteFailedBuild(pExeName,MakeBuildKey(pSettings,pVariant),GetFailedBuildHash(pSettings.mPathedSourceFile,pSettings.mCWD,sourceHash),compileOutput);
+    }
+    return compliedOK;
+}
+
+/**
+ * @brief Checks if the exec for the variant needs building, because the compiler or flags differ or the source or a dependency is younger.
+ */
+static bool ExecutableOutOfDate(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    if( BuildKeyMatches(pExeName,MakeBuildKey(pSettings,pVariant)) == false )
+    {
+        return true;
+    }
+
+    Dependencies::PathVec includePaths;
+    includePaths.push_back(pSettings.mCWD);
+    Dependencies exeDependencies;
+    return exeDependencies.RequiresRebuild(pSettings.mPathedSourceFile,pExeName,includePaths);
+}
+
+/**
+ * @brief Renames a freshly built exec, and its build key, over the cached one.
+ * The exec goes first, a run that sees the new exec with the old key will rebuild, which is a waste but never runs the wrong thing.
+ */
+static void PublishExecutable(const std::filesystem::path& pBuiltExeName,const std::filesystem::path& pExeName)
+{
+    std::error_code ec;
+    std::filesystem::rename(pBuiltExeName,pExeName,ec);
+    if( ec )
+    {
+        std::cerr << "Failed to publish " << pBuiltExeName << " to " << pExeName << " " << ec.message() << "\n";
+        return;
+    }
+    std::filesystem::rename(GetBuildKeyFilename(pBuiltExeName),GetBuildKeyFilename(pExeName),ec);
+    std::filesystem::remove(GetFailedBuildFilename(pExeName),ec);
+    std::filesystem::rename(GetTimeTraceFilename(pBuiltExeName),GetTimeTraceFilename(pExeName),ec);
+    std::filesystem::remove(GetTokenHashFilename(pExeName),ec);
+    std::filesystem::rename(GetTokenHashFilename(pBuiltExeName),GetTokenHashFilename(pExeName),ec);
+    StopZygote(pExeName);
+}
+
+/**
+ * @brief The local date and time with the nanoseconds, builds often happen within the same second as an edit.
+ */
+static std::string FormatFileTime(const timespec& pTime)
+{
+    if( pTime.tv_sec == 0 && pTime.tv_nsec == 0 )
+    {
+        return "missing";
+    }
+
+    char text[64];
+    struct tm local;
+    localtime_r(&pTime.tv_sec,&local);
+    const size_t length = strftime(text,sizeof(text),"%Y-%m-%d %H:%M:%S",&local);
+    snprintf(text + length,sizeof(text) - length,".%09ld",(long)pTime.tv_nsec);
+    return text;
+}
+
+static timespec GetModifiedTime(const std::filesystem::path& pFile)
+{
+    struct stat Stats;
+    if( stat(pFile.c_str(),&Stats) == 0 )
+    {
+        return Stats.st_mtim;
+    }
+    return {0,0};
+}
+
+/**
+ * @brief For --seabang-explain, says if the source and it's includes still hash to what the exec was built from.
+ * If they do the rebuild is only down to time stamps, a touch or a checkout, and is the kind worth tracking down.
+ */
+static void ExplainSourceHash(const BuildSettings& pSettings,const std::filesystem::path& pExeName)
+{
+    BuildKey builtKey;
+    if( ReadBuildKey(pExeName,builtKey) == false || builtKey.mSourceHash.size() == 0 )
+    {
+        EXPLAIN("    the build of the exec did not record a hash of the source, can not tell if the contents changed");
+        return;
+    }
+
+    const std::string sourceHash = GetSourceHash(pSettings.mPathedSourceFile,pSettings.mCWD);
+    if( sourceHash == builtKey.mSourceHash )
+    {
+        EXPLAIN("    the source and it's includes hash to " << sourceHash << ", the same as when the exec was built, only the time stamps changed");
+    }
+    else
+    {
+        EXPLAIN("    the source and it's includes hash to " << sourceHash << ", the exec was built from " << builtKey.mSourceHash);
+    }
+}
+
+/**
+ * @brief For --seabang-explain, what is different about the compiler or flags, or that there is no key.
+ */
+static void ExplainBuildKey(const std::filesystem::path& pExeName,const BuildKey& pCurrentKey)
+{
+    BuildKey builtKey;
+    if( ReadBuildKey(pExeName,builtKey) == false )
+    {
+        EXPLAIN("seabang: rebuilding, there is no build key for " << pExeName << ", the last build did not finish or was by an older seabang");
+        return;
+    }
+    EXPLAIN("seabang: rebuilding, " << CompareBuildKey(builtKey,pCurrentKey));
+}
+
+/**
+ * @brief For --seabang-explain, the file that made the dependency check fail, it's time against the exec's and how it is included.
+ */
+static void ExplainDependencyRebuild(const BuildSettings& pSettings,const std::filesystem::path& pExeName,const Dependencies& pDependencies)
+{
+    if( pDependencies.GetRebuildTrigger().empty() )
+    {
+        EXPLAIN("seabang: rebuilding, there is no exec " << pExeName);
+        return;
+    }
+
+    const bool missing = pDependencies.GetRebuildTriggerTime().tv_sec == 0 && pDependencies.GetRebuildTriggerTime().tv_nsec == 0;
+    EXPLAIN("seabang: rebuilding, " << pDependencies.GetRebuildTrigger() << (missing ? " is missing" : " is newer than the exec"));
+    EXPLAIN("    modified " << FormatFileTime(pDependencies.GetRebuildTriggerTime()));
+    EXPLAIN("    exec     " << FormatFileTime(GetModifiedTime(pExeName)));
+
+    Dependencies::PathVec chain;
+    pDependencies.GetRebuildChain(chain);
+    if( chain.size() > 1 )
+    {
+        EXPLAIN("    included by way of");
+        for( const auto& file : chain )
+        {
+            EXPLAIN("        " << file);
+        }
+    }
+    ExplainSourceHash(pSettings,pExeName);
+}
+
+/**
+ * @brief For --seabang-ignore-cosmetic, true if the exec is out of date only because of edits to comments or white space.
+ * When it is the copy of the source, the build key's source hash and the exec's date are brought up to date,
+ * so the next run finds it up to date from the file dates alone and does not hash anything.
+ */
+static bool OnlyCosmeticChanges(const BuildSettings& pSettings,const BuildKey& pBuildKey,const std::filesystem::path& pExeName)
+{
+    TokenHashes builtHashes;
+    TokenHashes currentHashes;
+    if( std::filesystem::exists(pExeName) == false || BuildKeyMatches(pExeName,pBuildKey) == false ||
+        ReadTokenHashes(pExeName,builtHashes) == false || GetTokenHashes(pSettings,currentHashes) == false )
+    {
+        return false;
+    }
+
+    if( builtHashes != currentHashes )
+    {
+        VLOG("The tokens differ from those " << pExeName << " was built from");
+        return false;
+    }
+
+    if( CopySourceWithoutShebang(pSettings.mPathedSourceFile,pSettings.mTempSourcefile) == false )
+    {
+        return false;
+    }
+
+    BuildKey builtKey;
+    ReadBuildKey(pExeName,builtKey);
+    builtKey.mSourceHash = GetSourceHash(pSettings.mPathedSourceFile,pSettings.mCWD);
+    WriteBuildKey(pExeName,builtKey);
+
+    std::error_code ec;
+    std::filesystem::last_write_time(pExeName,std::filesystem::file_time_type::clock::now(),ec);
+    return !ec;
+}
+
+/**
+ * @brief Checks for a failed build of the exec from the same source, dependencies, compiler and flags as now.
+ * If there is one building again would fail the same way, so the diagnostics from that build are returned instead.
+ */
+static bool KnownBrokenBuild(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName,std::string& rDiagnostics)
+{
+    BuildKey failedKey;
+    std::string failedSourceHash;
+    if( ReadFailedBuild(pExeName,failedKey,failedSourceHash,rDiagnostics) == false )
+    {
+        return false;
+    }
+
+    const std::string difference = CompareBuildKey(failedKey,MakeBuildKey(pSettings,pVariant));
+    if( difference.size() > 0 )
+    {
+        VLOG("Failed build of " << pExeName << " was with a different build key, " << difference);
+        return false;
+    }
+
+    if( failedSourceHash != GetFailedBuildHash(pSettings.mPathedSourceFile,pSettings.mCWD,GetSourceHash(pSettings.mPathedSourceFile,pSettings.mCWD)) )
+    {
+        VLOG("Source has changed since the failed build of " << pExeName);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the exec in a detached process, into a scratch file that is renamed over the cached exec when it's done.
+ * Only one background build per exec runs at once, the output of it goes to <exec>.build.log.
+ */
+static void BuildExecutableInBackground(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    const std::filesystem::path lockFile = (std::filesystem::path(pExeName) += ".build.lock");
+    const std::filesystem::path logFile = (std::filesystem::path(pExeName) += ".build.log");
+
+    VLOG("Starting background build of " << pExeName << ", output in " << logFile);
+    StartBackgroundJob(lockFile,logFile,[&]()
+    {
+        const std::filesystem::path scratchExeName = (std::filesystem::path(pExeName) += ".scratch." + std::to_string(getpid()));
+
+        // If the temporay source is replaced while we build then a newer run has copied a newer version.
+        // So build again, or we would publish an exec that is younger than the source but built from the old one.
+        std::error_code ec;
+        std::filesystem::file_time_type sourceTime;
+        do
+        {
+            sourceTime = std::filesystem::last_write_time(pSettings.mTempSourcefile,ec);
+            if( BuildExecutable(pSettings,pVariant,scratchExeName) == false )
+            {
+                std::filesystem::remove(scratchExeName,ec);
+                std::filesystem::rename(GetFailedBuildFilename(scratchExeName),GetFailedBuildFilename(pExeName),ec);
+                return;
+            }
+        }while( std::filesystem::last_write_time(pSettings.mTempSourcefile,ec) != sourceTime );
+
+        PublishExecutable(scratchExeName,pExeName);
+    });
+}
+
+/**
+ * @brief A build of the exec into a scratch file, started while the dependency check is still working out if it is needed.
+ * If it is, Finish waits for it and publishes it, if not Cancel kills the compiler. Cancelled when it goes out of scope.
+ * The process it builds in is forked by Prepare, before the check's thread is started, and only builds once Start is called.
+ */
+class SpeculativeBuild
+{
+public:
+    ~SpeculativeBuild(){Cancel();}
+
+    void Prepare(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName);
+    void Start();
+    bool IsRunning()const{return mPid > 0 && mStarted;}
+
+    // Returns false if the build failed, the failure is recorded against the exec as if it had been built in place.
+    bool Finish();
+    void Cancel();
+
+private:
+    pid_t mPid = -1;
+    int mStartSocket = -1;  // Our end of the socket the child waits on, a byte to build, closed to not.
+    bool mStarted = false;
+    std::filesystem::path mExeName;
+    std::filesystem::path mScratchExeName;
+
+    void RemoveScratchFiles();
+};
+
+/**
+ * @brief Forks the child the build runs in, in its own process group so cancelling it takes the compiler with it.
+ * This has to be called before the dependency check's thread is started. A fork copies only the thread that called it,
+ * so a child forked while the check runs could be left with a malloc, locale or stdio lock that thread held, held for ever.
+ * Forked now the child is a copy of a process with one thread, it waits until Start tells it to build.
+ */
+void SpeculativeBuild::Prepare(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    mExeName = pExeName;
+    mScratchExeName = (std::filesystem::path(pExeName) += ".speculative." + std::to_string(getpid()));
+
+    // A socket and not a pipe, so if the child has gone telling it to start does not raise SIGPIPE.
+    int startSockets[2];
+    if( socketpair(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0,startSockets) != 0 )
+    {
+        std::cerr << "Failed to create the socket for the speculative build " << strerror(errno) << "\n";
+        return;
+    }
+
+    std::cout << std::flush;
+    std::clog << std::flush;
+    mPid = fork();
+    if( mPid == 0 )
+    {
+        setpgid(0,0);
+        close(startSockets[0]);
+
+        char start = 0;
+        ssize_t bytesRead;
+        do
+        {
+            bytesRead = read(startSockets[1],&start,1);
+        }while( bytesRead < 0 && errno == EINTR );
+        if( bytesRead != 1 )
+        {// Not needed.
+            _exit(EXIT_FAILURE);
+        }
+
+        const bool builtOK = BuildExecutable(pSettings,pVariant,mScratchExeName);
+        std::cout << std::flush;
+        std::clog << std::flush;
+        _exit(builtOK ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(startSockets[1]);
+    if( mPid < 0 )
+    {
+        close(startSockets[0]);
+        std::cerr << "Failed to fork speculative build " << strerror(errno) << "\n";
+        return;
+    }
+    mStartSocket = startSockets[0];
+    // Set from both sides, so it is in place whichever of us runs first.
+    setpgid(mPid,mPid);
+}
+
+/**
+ * @brief Tells the child from Prepare to build. Only a byte is written, so this is safe with the dependency check's thread running.
+ */
+void SpeculativeBuild::Start()
+{
+    if( mPid <= 0 || mStartSocket < 0 )
+    {
+        return;
+    }
+
+    const char start = 1;
+    mStarted = send(mStartSocket,&start,1,MSG_NOSIGNAL) == 1;
+    close(mStartSocket);
+    mStartSocket = -1;
+}
+
+bool SpeculativeBuild::Finish()
+{
+    int status = 0;
+    const bool builtOK = waitpid(mPid,&status,0) == mPid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    mPid = -1;
+    mStarted = false;
+
+    if( builtOK )
+    {
+        PublishExecutable(mScratchExeName,mExeName);
+    }
+    else
+    {// Left as a failed build in place would, with no exec.
+        std::error_code ec;
+        for( const std::filesystem::path& file : {mExeName,GetBuildKeyFilename(mExeName),GetTimeTraceFilename(mExeName),GetTokenHashFilename(mExeName)} )
+        {
+            std::filesystem::remove(file,ec);
+        }
+        std::filesystem::rename(GetFailedBuildFilename(mScratchExeName),GetFailedBuildFilename(mExeName),ec);
+    }
+    RemoveScratchFiles();
+    return builtOK;
+}
+
+void SpeculativeBuild::Cancel()
+{
+    if( mStartSocket >= 0 )
+    {
+        close(mStartSocket);
+        mStartSocket = -1;
+    }
+
+    if( mPid <= 0 )
+    {
+        return;
+    }
+
+    kill(-mPid,SIGTERM);
+    int status;
+    waitpid(mPid,&status,0);
+    mPid = -1;
+    if( mStarted )
+    {
+        mStarted = false;
+        RemoveScratchFiles();
+        VLOG("Speculative build of " << mExeName << " was not needed, cancelled");
+    }
+}
+
+void SpeculativeBuild::RemoveScratchFiles()
+{
+    std::error_code ec;
+    for( const std::filesystem::path& file : {mScratchExeName,GetBuildKeyFilename(mScratchExeName),GetFailedBuildFilename(mScratchExeName),
+                                            GetTimeTraceFilename(mScratchExeName),GetTokenHashFilename(mScratchExeName),(std::filesystem::path(mScratchExeName) += ".o")} )
+    {
+        std::filesystem::remove(file,ec);
+    }
+}
+
+/**
+ * @brief Tiered build, the exec is needed now so a quick unoptimised one is built and run while the real one is built in the background.
+ * Later runs use the quick exec until the real one has been published.
+ */
+static bool BuildTiered(const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName,bool pForceRebuild,std::filesystem::path& rExeToRun)
+{
+    const BuildVariant quickVariant = GetQuickBuildVariant(pVariant);
+    const std::filesystem::path quickExeName = GetBuildVariantExeName(pSettings.mTempSourcefile,quickVariant);
+
+    // Started first so the two builds run at the same time.
+    BuildExecutableInBackground(pSettings,pVariant,pExeName);
+
+    if( pForceRebuild || ExecutableOutOfDate(pSettings,quickVariant,quickExeName) )
+    {
+        VLOG("Building quick exec " << quickExeName);
+        if( BuildExecutable(pSettings,quickVariant,quickExeName) == false )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        VLOG("Quick exec " << quickExeName << " is up to date");
+    }
+
+    rExeToRun = quickExeName;
+    return true;
+}
+
+/**
+ * @brief Runs the cached exec lots of times, directly and not via the shell, and reports the timings.
+ * If --seabang-bench-compare is used that build variant is built, into it's own cached exec, and run side by side.
+ */
+static int BenchmarkExecutable(const std::vector<std::string>& seaBangExtraArguments,int pRuns,const BuildSettings& pSettings,const BuildVariant& pVariant,
+                                const std::filesystem::path& pExeName,const std::vector<std::string>& pApplicationArguments)
+{
+    BenchmarkOptions options;
+    options.mRuns = pRuns;
+    options.mWarmupRuns = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-bench-warmup",0);
+    options.mCPU = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-bench-cpu",-1);
+
+    std::vector<BenchmarkTarget> targets(1);
+    targets[0].mName = pVariant.mName;
+    targets[0].mExeName = pExeName;
+
+    const std::string compareProfile = GetArgumentValue(seaBangExtraArguments,"--seabang-bench-compare");
+    if( compareProfile.size() > 0 )
+    {
+        const BuildVariant* compareVariant = FindBuildVariant(compareProfile);
+        if( compareVariant == nullptr )
+        {
+            std::cerr << "Unknown build variant to compare against, " << compareProfile << ", expected one of " << GetBuildVariantNames() << "\n";
+            return EXIT_FAILURE;
+        }
+
+        if( compareProfile == targets[0].mName )
+        {
+            std::cerr << "Can not compare the " << compareProfile << " build variant with its self\n";
+            return EXIT_FAILURE;
+        }
+
+        BenchmarkTarget compare;
+        compare.mName = compareVariant->mName;
+        compare.mExeName = GetBuildVariantExeName(pSettings.mTempSourcefile,*compareVariant);
+
+        if( SearchString(seaBangExtraArguments,"--rebuild") || ExecutableOutOfDate(pSettings,*compareVariant,compare.mExeName) )
+        {
+            VLOG("Building " << compareProfile << " variant for benchmark comparison");
+            if( BuildExecutable(pSettings,*compareVariant,compare.mExeName) == false )
+            {
+                std::cerr << "Failed to build the " << compareProfile << " variant to compare against\n";
+                return EXIT_FAILURE;
+            }
+        }
+        targets.push_back(compare);
+    }
+
+    VLOG("Benchmarking exec: " << pExeName);
+    if( RunBenchmark(targets,pApplicationArguments,options) == false )
+    {
+        return EXIT_FAILURE;
+    }
+
+    ReportBenchmark(targets,options);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief The machine the exec is built for, plus any CPU options passed to the compiler.
+ * If the compiler is told to build for the native CPU then the CPU model is added, as the exec will only be good for that.
+ */
+static std::string GetCPUTarget(const std::vector<std::string>& pCompilerFlags)
+{
+    utsname name;
+    std::string target = uname(&name) == 0 ? name.machine : "unknown";
+    for( const std::string& flag : pCompilerFlags )
+    {
+        if( flag.rfind("-march=",0) == 0 || flag.rfind("-mcpu=",0) == 0 || flag.rfind("-mtune=",0) == 0 )
+        {
+            target += " " + flag;
+            if( flag.find("=native") != std::string::npos )
+            {
+                std::ifstream cpuInfo("/proc/cpuinfo");
+                std::string line;
+                while( std::getline(cpuInfo,line) )
+                {
+                    if( line.rfind("model name",0) == 0 )
+                    {
+                        target += " (" + line.substr(line.find(':') + 2) + ")";
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return target;
+}
+
+/**
+ * @brief Makes the manifest that describes what the exec for the source file was built from, and with.
+ * The compiler version is left out if the compiler can not be run, as is the case on hosts that only import bundles.
+ */
+static BundleManifest MakeBundleManifest(const BuildSettings& pSettings,const BuildVariant& pVariant)
+{
+    const std::vector<std::string> flags = GetCompilerFlags(pVariant,pSettings.mCompilerExtraArguments);
+
+    BundleManifest manifest;
+    manifest["source"] = pSettings.mPathedSourceFile.string();
+    manifest["source-hash"] = GetSourceHash(pSettings.mPathedSourceFile,pSettings.mCWD);
+    manifest["variant"] = pVariant.mName;
+    manifest["compiler"] = pSettings.mCompiler;
+    manifest["flags"] = JoinStrings(flags," ");
+    manifest["cpu-target"] = GetCPUTarget(flags);
+
+    const std::string compilerVersion = GetCompilerVersion(pSettings.mCompiler);
+    if( compilerVersion.size() > 0 )
+    {
+        manifest["compiler-version"] = compilerVersion;
+    }
+    return manifest;
+}
+
+/**
+ * @brief Writes the cached exec and a manifest of how it was built into one file that can be imported on another host.
+ */
+static int ExportBundle(const std::vector<std::string>& seaBangExtraArguments,const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    std::filesystem::path bundleFile = GetArgumentValue(seaBangExtraArguments,"--seabang-bundle");
+    if( bundleFile.empty() )
+    {
+        bundleFile = pSettings.mCWD / (pSettings.mPathedSourceFile.filename().string() + "." + pVariant.mName + ".bundle");
+    }
+
+    const BundleManifest manifest = MakeBundleManifest(pSettings,pVariant);
+    if( manifest.count("compiler-version") == 0 )
+    {
+        std::cerr << "Failed to get the version of the compiler " << pSettings.mCompiler << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if( WriteBundle(bundleFile,manifest,pExeName) == false )
+    {
+        return EXIT_FAILURE;
+    }
+
+    VLOG("Exported " << pExeName << " to " << bundleFile);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Checks the fields of the bundle's manifest against this host's, listing the ones that differ.
+ */
+static bool BundleMatchesHost(const std::filesystem::path& pBundleFile,const BundleManifest& pBundleManifest,const BundleManifest& pLocalManifest,const std::vector<std::string>& pFields)
+{
+    bool match = true;
+    for( const std::string& field : pFields )
+    {
+        const auto bundleValue = pBundleManifest.find(field);
+        const auto localValue = pLocalManifest.find(field);
+
+        // No compiler on this host, so there is no version to check.
+        if( field == "compiler-version" && localValue == pLocalManifest.end() )
+        {
+            VLOG("No compiler on this host, not checking the version the bundle was built with");
+            continue;
+        }
+
+        if( bundleValue == pBundleManifest.end() || localValue == pLocalManifest.end() || bundleValue->second != localValue->second )
+        {
+            std::cerr << "Bundle " << pBundleFile << " does not match this host, " << field << " differs\n";
+            std::cerr << "    bundle: " << (bundleValue == pBundleManifest.end() ? "" : bundleValue->second) << "\n";
+            std::cerr << "    local:  " << (localValue == pLocalManifest.end() ? "" : localValue->second) << "\n";
+            match = false;
+        }
+    }
+
+    return match;
+}
+
+/**
+ * @brief Puts the exec from a bundle into the local cache, so the next run of the script is a cache hit.
+ * Refuses if the bundle was not built from the same source, flags, compiler and CPU target as this host would build.
+ */
+static int ImportBundle(const std::filesystem::path& pBundleFile,const BundleManifest& pBundleManifest,const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    const BundleManifest localManifest = MakeBundleManifest(pSettings,pVariant);
+    if( BundleMatchesHost(pBundleFile,pBundleManifest,localManifest,{"source","source-hash","variant","compiler","flags","cpu-target","compiler-version"}) == false )
+    {
+        return EXIT_FAILURE;
+    }
+
+    // The temporay source file has to be written first so that the exec is younger than it.
+    if( CopySourceWithoutShebang(pSettings.mPathedSourceFile,pSettings.mTempSourcefile) == false || ExtractBundlePayload(pBundleFile,pExeName) == false )
+    {
+        return EXIT_FAILURE;
+    }
+
+    // The key is for this host's compiler, if it has one, as the version has been checked to be the same.
+    WriteBuildKey(pExeName,MakeBuildKey(pSettings,pVariant));
+    std::filesystem::remove(GetTokenHashFilename(pExeName));
+
+    using std::filesystem::perms;
+    std::filesystem::permissions(pExeName,perms::owner_all|perms::group_read|perms::group_exec|perms::others_read|perms::others_exec);
+
+    VLOG("Imported " << pBundleFile << " to " << pExeName);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Looks for the exec in the remote cache, if it is there and matches what this host would build it is put in the local cache.
+ * The temporay source file must already have been written, so that the exec is younger than it.
+ * Returns false if it is not there or could not be got, the caller then builds it.
+ */
+static bool FetchFromRemoteCache(const std::string& pRemoteCache,int pTimeoutMS,const BundleManifest& pLocalManifest,const BuildSettings& pSettings,const BuildVariant& pVariant,const std::filesystem::path& pExeName)
+{
+    const std::string key = GetRemoteCacheKey(pLocalManifest);
+    if( key.size() == 0 )
+    {
+        VLOG("No compiler version, can not make a key for the remote cache");
+        return false;
+    }
+
+    const std::filesystem::path bundleFile = (std::filesystem::path(pExeName) += ".remote." + std::to_string(getpid()));
+    std::string error;
+    if( RemoteCacheGet(pRemoteCache,key,bundleFile,pTimeoutMS,error) == false )
+    {
+        VLOG("Remote cache " << pRemoteCache << " does not have " << key << (error.size() > 0 ? ", " + error : ""));
+        return false;
+    }
+
+    // Where the source is does not matter, the rest must be the same, so a bad server or a clash of keys can not give us the wrong exec.
+    BundleManifest remoteManifest;
+    const bool fetched = ReadBundleManifest(bundleFile,remoteManifest) &&
+                         BundleMatchesHost(bundleFile,remoteManifest,pLocalManifest,{"source-hash","variant","compiler","flags","cpu-target","compiler-version"}) &&
+                         ExtractBundlePayload(bundleFile,pExeName);
+    std::filesystem::remove(bundleFile);
+    if( fetched == false )
+    {
+        return false;
+    }
+
+    BuildKey builtKey = MakeBuildKey(pSettings,pVariant);
+    builtKey.mSourceHash = pLocalManifest.at("source-hash");
+    WriteBuildKey(pExeName,builtKey);
+
+    std::error_code ec;
+    std::filesystem::remove(GetFailedBuildFilename(pExeName),ec);
+    std::filesystem::remove(GetTokenHashFilename(pExeName),ec);
+    StopZygote(pExeName);
+
+    using std::filesystem::perms;
+    std::filesystem::permissions(pExeName,perms::owner_all|perms::group_read|perms::group_exec|perms::others_read|perms::others_exec);
+
+    VLOG("Fetched " << pExeName << " from the remote cache " << pRemoteCache << " as " << key);
+    return true;
+}
+
+/**
+ * @brief Shares a freshly built exec through the remote cache. A failure only costs the other hosts a build, so is not an error.
+ */
+static void UploadToRemoteCache(const std::string& pRemoteCache,int pTimeoutMS,const BundleManifest& pLocalManifest,const std::filesystem::path& pExeName)
+{
+    const std::string key = GetRemoteCacheKey(pLocalManifest);
+    if( key.size() == 0 )
+    {
+        return;
+    }
+
+    const std::filesystem::path bundleFile = (std::filesystem::path(pExeName) += ".upload." + std::to_string(getpid()));
+    std::string error;
+    const char* token = getenv("SEABANG_REMOTE_CACHE_TOKEN");
+    if( WriteBundle(bundleFile,pLocalManifest,pExeName) && RemoteCachePut(pRemoteCache,key,bundleFile,token ? token : "",pTimeoutMS,error) )
+    {
+        VLOG("Uploaded " << pExeName << " to the remote cache " << pRemoteCache << " as " << key);
+    }
+    else
+    {
+        VLOG("Failed to upload " << pExeName << " to the remote cache " << pRemoteCache << ", " << error);
+    }
+    std::filesystem::remove(bundleFile);
+}
+
+
+/**
+ * @brief Writes the exec to the cold tier as a compressed bundle, with what is needed to check it is still good and to put it back.
+ */
+static bool StoreInColdTier(const std::filesystem::path& pColdFolder,const BuildSettings& pSettings,const std::filesystem::path& pExeName)
+{
+    BuildKey builtKey;
+    if( ReadBuildKey(pExeName,builtKey) == false || builtKey.mSourceHash.size() == 0 )
+    {
+        return false;
+    }
+
+    BundleManifest manifest;
+    manifest["exe"] = pExeName.string();
+    manifest["temp-source"] = pSettings.mTempSourcefile.string();
+    manifest["source"] = pSettings.mPathedSourceFile.string();
+    manifest["cwd"] = pSettings.mCWD.string();
+    manifest["toolchain"] = builtKey.mToolchain;
+    manifest["flags"] = builtKey.mFlags;
+    manifest["source-hash"] = builtKey.mSourceHash;
+
+    const std::filesystem::path coldFile = GetColdFilename(pColdFolder,pExeName);
+    const std::filesystem::path tempFile = (std::filesystem::path(coldFile) += "." + std::to_string(getpid()));
+    std::error_code ec;
+    std::filesystem::create_directories(pColdFolder,ec);
+    if( WriteBundle(tempFile,manifest,pExeName,true) == false )
+    {
+        std::filesystem::remove(tempFile,ec);
+        return false;
+    }
+    std::filesystem::rename(tempFile,coldFile,ec);
+    return !ec;
+}
+
+/**
+ * @brief Puts an exec back from the cold tier, if the source and it's includes are the same as it was built from.
+ * When pCurrentKey is given the compiler and flags must be the same as it too, when restoring after a boot it is not known so the next run checks.
+ */
+static bool RestoreFromColdTier(const std::filesystem::path& pColdFile,const BuildKey* pCurrentKey)
+{
+    BundleManifest manifest;
+    if( std::filesystem::exists(pColdFile) == false || ReadBundleManifest(pColdFile,manifest) == false )
+    {
+        return false;
+    }
+
+    BuildKey coldKey;
+    coldKey.mToolchain = manifest["toolchain"];
+    coldKey.mFlags = manifest["flags"];
+    coldKey.mSourceHash = manifest["source-hash"];
+    if( pCurrentKey && CompareBuildKey(coldKey,*pCurrentKey).size() > 0 )
+    {
+        VLOG("Cold tier copy of " << manifest["exe"] << " was built differently, " << CompareBuildKey(coldKey,*pCurrentKey));
+        return false;
+    }
+
+    if( GetSourceHash(manifest["source"],manifest["cwd"]) != coldKey.mSourceHash )
+    {
+        VLOG("Cold tier copy of " << manifest["exe"] << " is out of date, the source has changed");
+        return false;
+    }
+
+    // The temporay source file has to be written first so that the exec is younger than it.
+    const std::filesystem::path exeName = manifest["exe"];
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(manifest["temp-source"]).parent_path(),ec);
+    if( CopySourceWithoutShebang(manifest["source"],manifest["temp-source"]) == false || ExtractBundlePayload(pColdFile,exeName) == false )
+    {
+        return false;
+    }
+    WriteBuildKey(exeName,coldKey);
+    std::filesystem::remove(GetTokenHashFilename(exeName),ec);
+
+    using std::filesystem::perms;
+    std::filesystem::permissions(exeName,perms::owner_all|perms::group_read|perms::group_exec|perms::others_read|perms::others_exec,ec);
+
+    // For the cold tier's least recently used order.
+    std::filesystem::last_write_time(pColdFile,std::filesystem::file_time_type::clock::now(),ec);
+    VLOG("Restored " << exeName << " from the cold tier");
+    return true;
+}
+
+/**
+ * @brief After a boot the hot tier may be empty, so the execs used most recently are put back in the background, as many as fit.
+ */
+static void RestoreHotTierInBackground(const std::filesystem::path& pColdFolder,uint64_t pHotSize)
+{
+    VLOG("First run since boot, restoring the hot tier from " << pColdFolder << " in the background");
+    StartBackgroundJob(pColdFolder / ".restore.lock",pColdFolder / ".restore.log",[&]()
+    {
+        uint64_t restored = 0;
+        for( const std::filesystem::path& coldFile : GetColdEntries(pColdFolder) )
+        {
+            BundleManifest manifest;
+            if( ReadBundleManifest(coldFile,manifest) == false || std::filesystem::exists(manifest["exe"]) )
+            {
+                continue;
+            }
+
+            const uint64_t size = strtoull(manifest["payload-size"].c_str(),nullptr,10);
+            if( pHotSize > 0 && restored + size > pHotSize )
+            {
+                break;
+            }
+
+            if( RestoreFromColdTier(coldFile,nullptr) )
+            {
+                restored += size;
+            }
+        }
+    });
+}
+
+/**
+ * @brief Writes a new exec through to the cold tier and trims both tiers to size, in the background as none of it is needed for this run.
+ */
+static void UpdateCacheTiersInBackground(const std::filesystem::path& pColdFolder,uint64_t pHotSize,uint64_t pColdSize,const BuildSettings& pSettings,const std::filesystem::path& pExeName)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(pColdFolder,ec);
+    StartBackgroundJob((GetColdFilename(pColdFolder,pExeName) += ".lock"),pColdFolder / ".tier.log",[&]()
+    {
+        if( ColdCopyIsCurrent(pColdFolder,pExeName) == false && StoreInColdTier(pColdFolder,pSettings,pExeName) == false )
+        {
+            std::cerr << "Failed to write " << pExeName << " to the cold tier " << pColdFolder << "\n";
+        }
+        TrimCacheTiers(pSettings.mTempFolder,pColdFolder,pHotSize,pColdSize);
+    });
+}
+
+/**
+ * @brief Displays the help text.
+ */
+static void DisplayHelp()
+{
+const std::string_view helpText =
+R"(
+Usage: #!/usr/bin/seabang [OPTION]
+This command is not to be executed directly but to be placed at the top of a c/c++ source file.
+The options specified here are ones that either affect the operation of seabang or are passed to the compiler.
+Options from the code file being run are passed in as usual, for example hello_world.cpp --help
+seabang does not have any short options so that they do not clash with options for the compiler.
+seabang was built to use the Compiler )" TOSTRING(SEABANG_CXX_COMPILER) R"(
+seaband was built to use the temporay folder )" TOSTRING(SEABANG_TEMPORARY_FOLDER) R"(
+Please note, due to the way shebang options work, any argument for seabang and that takes an value
+   must not contain a space. For example '--seabang-compiler=compiler' is ok,
+   '--seabang-compiler = compiler' will fail.
+
+The environment varible SEABANG_CXX_COMPILER can be used to change the compiler used by default.
+    eg. SEABANG_CXX_COMPILER=gcc ./my-code.cpp
+
+The environment varible SEABANG_TEMPORARY_FOLDER can be used to change the tempoary folder used by default.
+    eg. SEABANG_TEMPORARY_FOLDER=~/tmp ./my-code.cpp
+
+Snippets of code can be run from the command line with -e, or from stdin with -, and no source file.
+    The code is put in a main, after the common std headers and a using namespace std, unless it has it's own main.
+    It is built once and the exec found again by a hash of the code, so a shell loop running it only builds it once.
+    Options for seabang go before the -e, all as one argument, arguments after the code are passed to it.
+    eg. seabang -e 'cout << "Hello " << argv[1] << "\n";' world
+    eg. echo 'cout << 6 * 7 << "\n";' | seabang "--seabang-variant=release" -
+
+Mandatory arguments to long options are mandatory for short options too.
+    --seabang-compiler=compiler Allows a specific source file to use a compiler that is not the norm.
+              This overides the compiler set with SEABANG_CXX_COMPILER and the default one.
+              Example, --seabang-compiler=gcc
+
+    --seabang-temp-path=PATH Allows a specific source file to use a particular temporay folder.
+              This overides the compiler set with SEABANG_TEMPORARY_FOLDER and the default one.
+              Example, --seabang-temp-path=./bin
+
+    --verbose Enables logging so you can see what seabang is doing.
+              Also enables verbose logging for the compiler.
+
+    --rebuild Forces a rebuild of the code. Normally seabang will only
+              build the code if the source file, or a dependency, has changed.
+              The code is also rebuilt if the flags or the compiler change. The compiler is
+              fingerprinted by its real path, inode, modification time and --version output.
+
+    --debug   By default the code is built with optimisations set to 2 and not symbol files created.
+              This options turns of all optimisations and generates the symbols needed for debbugging.
+              Turn on verbose output to discover the out location of the exec if you need to debug it.
+              Same as --seabang-variant=debug.
+
+    --seabang-tiered When the code needs building, a quick build with no optimisation is done and run straight away
+              while the optimised exec is built in a background process. Later runs use the quick exec
+              until the optimised one is ready. The background build's output goes to the exec's .build.log file.
+
+    --seabang-stale-ok[=SECONDS] When the code needs rebuilding, run the last good exec straight away and rebuild it
+              in a background process that replaces the exec when done. If SECONDS is given and the change
+              the exec is missing is older than that, seabang waits for the build as normal.
+              Not used with --rebuild, or if the compiler or flags have changed.
+              Example, --seabang-stale-ok=600
+
+    --seabang-zygote[=SECONDS] For scripts that are run very often. The exec is built with a small runtime and kept
+              loaded, and initialised, in a background process that forks it for each run, passing on the args,
+              environment, working folder and stdio. The first run starts it, later runs only pay for a fork.
+              It exits when the exec is rebuilt or after SECONDS without a run, 300 by default.
+              Static data set up before main is shared by every run, so must not depend on the environment.
+              Example, --seabang-zygote=60
+
+    --seabang-module-host[=SECONDS] For pipelines that run a lot of different small scripts. The script is built as a
+              shared object and run by a module host, one background process per temp folder that loads each
+              script once and keeps it loaded. Each run is forked from the host, with the args, environment,
+              working folder and stdio passed on, so does not pay for starting an exec or the dynamic link.
+              The host exits after SECONDS without a run, 300 by default. As with the zygote, static data set
+              up before main is shared by every run.
+              Example, --seabang-module-host=600
+
+    --seabang-ignore-cosmetic Edits that only change comments or white space, in the source or the local files it
+              includes, do not cause a rebuild. Each file is hashed as a stream of tokens, the hashes are cached
+              by the file's stat so a file is only read again when it changes. The line each token is on is part
+              of the hash, so adding or removing lines, even blank or comment ones, rebuilds if code comes after
+              them. That keeps __LINE__, assert messages, std::source_location and the debug info's lines right.
+              Edits within a line, such as indenting, are still skipped, the debug info can then have old columns.
+
+    --seabang-remember-failures When the compiler fails on the code, the errors are kept and while the source, the local
+              files it includes, the compiler and the flags are all unchanged they are shown again without building.
+              Only a compiler that exits with an error is remembered, not one that is killed or fails to run.
+              Creating a missing local header is seen, installing a system header or a library is not, use
+              --rebuild after doing that to build it anyway.
+
+    --seabang-speculate[=MS] When the source has not changed the local files it includes are checked before deciding
+              to build, on a network file system that can take longer than the build. With this the check runs
+              on a thread and if it has not finished after MS milliseconds, 50 by default, the build is started
+              at the same time into a scratch file. If the check says to build the scratch exec is used, if not
+              the compiler is killed. Either way the wait is the longer of the two and not both.
+              Example, --seabang-speculate=20
+
+    --seabang-stat-cache[=MS] Shares the stats and includes found while checking if a rebuild is needed with the other
+              seabangs on the host, through a file in the temporay folder that they all map. When many start at
+              once the shared headers are only looked at by the first, which saves a storm of stats on a network
+              file system. The includes of a file are kept till it changes, a stat is used for MS milliseconds,
+              200 by default, so a header edited less than that before the run may not be seen to have changed.
+              Example, --seabang-stat-cache=100
+
+    --seabang-jobs=N Limits how many compiles all the seabangs on the host run at once, the rest queue and
+              are built in the order they arrived. Defaults to the SEABANG_MAX_JOBS environment variable,
+              or the number of CPUs if that is not set. Zero means no limit.
+              Example, --seabang-jobs=4
+
+    --seabang-pkg=PACKAGES Comma separated list of pkg-config packages the code uses, their compile and link flags
+              are added to the compiler's. Packages can also be named in the source with a line like,
+              #pragma seabang pkg zlib libpng
+              pkg-config is only run the first time, the flags are cached until one of the packages .pc files changes.
+              Example, --seabang-pkg=zlib,libpng
+
+    --seabang-time-trace Times the compile, by phase and by header, and keeps the trace with the exec.
+              Clang writes it's own trace, with gcc the time report is used and each header the source
+              includes is timed on it's own. Used with --compile-report to find what makes scripts slow to build.
+              Example, --seabang-time-trace
+
+    --compile-report Run from the command line, reads the traces of all the scripts built with --seabang-time-trace
+              and lists the scripts, headers, templates and compiler phases that took the most time.
+              --seabang-report-top=N sets how many of each are listed, 20 by default.
+              --seabang-trace-out=FILE also writes all the traces to FILE, one process per script,
+              in the chrome trace format to load into chrome://tracing or perfetto.
+              Example, seabang --compile-report --seabang-trace-out=builds.json
+
+    --seabang-explain Says why the exec is being rebuilt, or that it is up to date. For a changed dependency it gives
+              the file, it's time and the exec's, the chain of includes that lead to it and if the contents of
+              the source and it's includes really changed or only their time stamps. For a changed compiler or
+              flags it gives what they were and what they are now.
+              Example, --seabang-explain
+
+    --seabang-remote-cache=URL A cache shared between hosts, an http server that holds execs as bundles.
+              When the exec is not in the local cache it is looked for there first, and after a build it is
+              uploaded, so each version of a script is only built once by all the hosts using the server.
+              The key is the hash of the source and it's includes, the variant, flags, compiler version and CPU.
+              What is downloaded is checked against all of those before it is used. If the server can not be
+              reached, or does not have it, the exec is built as normal. Defaults to the SEABANG_REMOTE_CACHE
+              environment variable. tools/seabang-cache-server.cpp is a small server for it.
+              Nothing checks who built what is downloaded, anyone who can upload to the server can have every host
+              that uses it run their code. Only use a server that trusted hosts alone can upload to, run it with
+              --read-only and fill it from a build host, or give it an upload token. The token for uploads is taken
+              from the SEABANG_REMOTE_CACHE_TOKEN environment variable. System headers and libraries are not in
+              the key, the hosts sharing a cache need the same ones installed.
+              Example, --seabang-remote-cache=http://buildcache:8470/seabang/
+
+    --seabang-remote-timeout=MS How long a request to the remote cache can take, 3000 milliseconds by default.
+              Example, --seabang-remote-timeout=1000
+
+    --seabang-workers=HOST:PORT,... Compile workers to build on, such as the machines of a build farm. The source is
+              preprocessed here and sent with the flags to the least loaded worker with the same compiler version,
+              the object comes back and is linked here. If none answer, or the compile is not back in time, it is
+              compiled here. Flags that name files, are for this CPU or write more than the object, such as the
+              coverage variant, are always compiled here. Defaults to the SEABANG_WORKERS environment variable.
+              tools/seabang-compile-worker.cpp is the worker. A worker compiles what it is sent, and the source can
+              put any file the worker can read in the object, so only let trusted hosts reach one. The worker only
+              listens on the loopback address unless told to, give it a token before it listens on others. The token
+              is taken from the SEABANG_WORKER_TOKEN environment variable and sent with each request.
+              Example, --seabang-workers=buildfarm1:8471,buildfarm2:8471
+
+    --seabang-worker-timeout=MS How long the workers have to get the object back, 60000 milliseconds by default.
+              Example, --seabang-worker-timeout=20000
+
+    --seabang-cold-path=FOLDER Adds a cold tier to the cache, for when the temporay folder is on tmpfs. Each exec built is
+              also written, compressed, to FOLDER. When the execs in the temporay folder, the hot tier, add up to
+              more than --seabang-hot-size the least recently used are removed from it. When next run they are
+              put back from the cold tier, if the source has not changed, which is far quicker than building them.
+              On the first run after a boot the most recently used are put back in the background.
+              Defaults to the SEABANG_COLD_FOLDER environment variable.
+              Example, --seabang-cold-path=~/.cache/seabang
+
+    --seabang-hot-size=SIZE The most the execs in the hot tier can add up to, 256M by default. K, M and G can be used.
+              Defaults to the SEABANG_HOT_SIZE environment variable. Zero is no limit.
+              Example, --seabang-hot-size=64M
+
+    --seabang-cold-size=SIZE The most the cold tier can hold, 4G by default. Defaults to the SEABANG_COLD_SIZE
+              environment variable. Zero is no limit.
+              Example, --seabang-cold-size=1G
+
+    --seabang-variant=NAME Selects the set of flags the code is built with. Each variant is cached in its own
+              exec in the temporay folder so switching between them does not force a rebuild.
+              release   The default, optimisations set to 2 and no symbols.
+              debug     No optimisations and symbols for debugging.
+              asan      Built with the address sanitizer.
+              ubsan     Built with the undefined behaviour sanitizer.
+              tsan      Built with the thread sanitizer.
+              coverage  Built with gcov coverage instrumentation.
+              startup   Optimised like release and linked statically so there is no loader work at startup,
+                        for small scripts that are run often. If the static libs are missing it is linked
+                        dynamically with libstdc++ static, no pie and gnu hashed symbols.
+              Example, --seabang-variant=asan
+
+    --compact-path By default the temporay folder used for the intermidiary files includes the path of the source file.
+                   This is done to avoid file clashes. If there is a reason that this can not work for you
+                   then this option removes this. The intermediary files will use the temporay path
+                   plus the sources filename.
+
+    --export  Builds the code, if needed, and writes the cached exec plus a manifest of the source hash, compiler,
+              flags and CPU target into one bundle file, so it can be deployed to hosts without a compiler.
+              The arguments in the source file's shebang are used. Example, seabang --export ./my-code.cpp
+
+    --import  Puts the exec from a bundle into the local cache so the next run of the script is a cache hit.
+              The script must be at the same path, and the bundle is refused if the source, flags, compiler
+              or CPU target does not match what this host would build. Example, seabang --import ./my-code.cpp.release.bundle
+
+    --seabang-bundle=FILE The bundle file --export writes to. Defaults to the source file name plus the variant
+              and .bundle, in the current folder.
+
+    --seabang-bench=N Builds the code once and then runs the cached exec N times, directly and not via the shell,
+              reporting the min, median, p90, p99 and stddev of the wall and CPU times.
+              Example, --seabang-bench=100
+
+    --seabang-bench-warmup=N Runs the exec N times before the timed runs start, the results are thrown away.
+
+    --seabang-bench-cpu=N Pins the benchmark runs to CPU N.
+
+    --seabang-bench-compare=VARIANT Also builds another build variant, see --seabang-variant, into its own exec
+              and benchmarks the two side by side. Example, --seabang-bench-compare=debug
+
+All single dash options (eg -lncurses) are passed to the compiler. This allows you to have some more
+control over the build settings. Such as specifying an optimisation option or a machine option.
+
+Seabang is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+seabang is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+
+)";
+
+    std::cout << helpText << "\n";
+}
+
+/**
+ * @brief Our entrypoint called by the OS
+ */
+int main(int argc,char *argv[])
+{
+    // See if they are looking for seabang help.
+    if( argc == 2 )
+    {
+        if( CompareNoCase(argv[1],"--help") )
+        {
+            DisplayHelp();
+            return EXIT_SUCCESS;
+        }
+    }
+
+    // The compile report reads the traces kept in the temp folder, it is run from the command line and has no source file.
+    if( argc >= 2 && std::string(argv[1]).rfind("--compile-report",0) == 0 )
+    {
+        std::vector<std::string> args = SplitString(argv[1]," ");
+        for( int n = 2 ; n < argc ; n++ )
+        {
+            args.push_back(argv[n]);
+        }
+        gVerboseLogging = SearchString(args,"--verbose");
+        return CompileReport(FindTemporayFolder(args),GetArgumentValue(args,"--seabang-trace-out"),GetArgumentValueAsInt(args,"--seabang-report-top",20));
     }
 
-    VLOG("Source file " << pathedSourceFile);
-    VLOG("Temp Source file " << tempSourcefile);
-    VLOG("exe file name " << pathedExeName);
-
+    // A snippet, given with -e or on stdin with -, is written to a script in the temp folder and then run like any other.
+    // The args are put back together as if that script had been run, with --compact-path as it's path is of no use to anyone.
+    std::vector<std::string> snippetArguments;
+    std::vector<char*> snippetArgv;
+    // The -e can only come after seabang's options, if argv[1] is a script then a -e or - after it is for the script.
+    const bool optionsFirst = argc >= 3 && strncmp(argv[1],"--",2) == 0 && std::filesystem::exists(argv[1]) == false;
+    const int snippetAt = argc >= 2 && IsSnippetArgument(argv[1]) ? 1 : (optionsFirst && IsSnippetArgument(argv[2]) ? 2 : 0);
+    const bool snippet = snippetAt > 0;
+    if( snippet )
+    {
+        std::string options = snippetAt == 2 ? argv[1] : "";
+        int nextArg = snippetAt + 1;
+        std::string code;
+        if( strcmp(argv[snippetAt],"-e") == 0 )
+        {
+            if( nextArg >= argc )
+            {
+                std::cerr << "seabang: -e needs the code to run\n";
+                return EXIT_FAILURE;
+            }
+            code = argv[nextArg++];
+        }
+        else
+        {
+            std::stringstream input;
+            input << std::cin.rdbuf();
+            code = input.str();
+        }
+
+        std::filesystem::path snippetFile;
+        if( WriteSnippetSource(FindTemporayFolder(SplitString(options," ")),code,snippetFile) == false )
+        {
+            std::cerr << "seabang: failed to write the snippet to " << snippetFile << "\n";
+            return EXIT_FAILURE;
+        }
+
+        snippetArguments = {argv[0],options.size() > 0 ? options + " --compact-path" : "--compact-path",snippetFile.string()};
+        for( ; nextArg < argc ; nextArg++ )
+        {
+            snippetArguments.push_back(argv[nextArg]);
+        }
+        for( std::string& arg : snippetArguments )
+        {
+            snippetArgv.push_back(arg.data());
+        }
+        snippetArgv.push_back(nullptr);
+        argc = (int)snippetArguments.size();
+        argv = snippetArgv.data();
+    }
+
+    // Got to be at least two args.
+    if( argc < 2 )
+    {
+        std::cerr << "Seabang not run from a source file, expects at least two command line arguments.\n";
+        DisplayHelp();
+        return EXIT_FAILURE;
+    }
+
+    // The way the commandline works with a shebang is...
+    // argv[0] is the shebang exec name, so in our case will be seabang
+    // then comes the arguments passed to the seabang, in the source file, all as one argument, [1]
+    // If no arguments given then argv[1] will be the source file.
+    // If arguments were given then the source file will be in argv[2]
+    // Then the rest of the arguments are as we expect, one argv[n] per argument.
+    // And so we need to look if argv[1] is a file or not. If it is assume no args passed to the shebang, if it is not assume it's args for the seabang exec.
+    std::string originalSourceFile = GetSourceFileFromArguments(argc,argv);
+    std::vector<std::string> seaBangExtraArguments = GetArgumentsForSeabang(argc,argv);
+    const std::vector<std::string> applicationArguments = GetArgumentsForApplication(argc,argv);
+
+    // Lets see if they want verbose logging.
+    // All seabang arguments are in long form so not to get mixed up with arguments for the compiler.
+    gVerboseLogging = SearchString(seaBangExtraArguments,"--verbose");
+    gExplainRebuild = SearchString(seaBangExtraArguments,"--seabang-explain");
+
+    // Exporting and importing bundles is done from the command line and not the shebang, for import the file passed is the bundle.
+    // As the OS is not reading the shebang for us we have to pick up it's arguments so the exec is built, or checked, with the same flags as when the script is run.
+    const bool exportBundle = SearchString(seaBangExtraArguments,"--export");
+    const bool importBundle = SearchString(seaBangExtraArguments,"--import");
+    const std::filesystem::path bundleFile = importBundle ? originalSourceFile : "";
+    BundleManifest bundleManifest;
+    if( importBundle )
+    {
+        if( ReadBundleManifest(bundleFile,bundleManifest) == false )
+        {
+            return EXIT_FAILURE;
+        }
+        originalSourceFile = bundleManifest["source"];
+    }
+
+    if( exportBundle || importBundle )
+    {
+        for( auto arg : GetArgumentsFromShebang(originalSourceFile) )
+        {
+            seaBangExtraArguments.push_back(arg);
+        }
+        gVerboseLogging = SearchString(seaBangExtraArguments,"--verbose");
+        gExplainRebuild = SearchString(seaBangExtraArguments,"--seabang-explain");
+    }
+
+    std::vector<std::string> compilerExtraArguments = GetArgumentsForCompiler(seaBangExtraArguments);
+    const bool forceRebuild = SearchString(seaBangExtraArguments,"--rebuild");
+    bool rebuildNeeded = forceRebuild;
+    const bool compactTempPath = SearchString(seaBangExtraArguments,"--compact-path");
+    const int benchRuns = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-bench",0);
+
+    // Exporting and benchmarking need the real exec, so can not be tiered or stale.
+    const bool tieredBuild = SearchString(seaBangExtraArguments,"--seabang-tiered") && exportBundle == false && benchRuns == 0;
+    const bool staleAllowed = (SearchString(seaBangExtraArguments,"--seabang-stale-ok") || GetArgumentValue(seaBangExtraArguments,"--seabang-stale-ok").size() > 0) && exportBundle == false && benchRuns == 0;
+    const int maxStaleness = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-stale-ok",-1);
+
+    // How long the dependency check can run before the build is started anyway, -1 to never do that.
+    const bool speculate = SearchString(seaBangExtraArguments,"--seabang-speculate") || GetArgumentValue(seaBangExtraArguments,"--seabang-speculate").size() > 0;
+    const int speculateAfterMS = speculate ? GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-speculate",SPECULATE_DEFAULT_MS) : -1;
+
+    // The module host keeps many scripts loaded in one process, so takes the place of a zygote.
+    const bool moduleHost = (SearchString(seaBangExtraArguments,"--seabang-module-host") || GetArgumentValue(seaBangExtraArguments,"--seabang-module-host").size() > 0) && exportBundle == false && importBundle == false && benchRuns == 0;
+    const int moduleHostIdleSeconds = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-module-host",MODULE_HOST_DEFAULT_IDLE_SECONDS);
+
+    // The zygote keeps a loaded exec waiting to be forked, only worth it when we are going to run the exec.
+    const bool zygote = (SearchString(seaBangExtraArguments,"--seabang-zygote") || GetArgumentValue(seaBangExtraArguments,"--seabang-zygote").size() > 0) && exportBundle == false && importBundle == false && benchRuns == 0 && moduleHost == false;
+    const int zygoteIdleSeconds = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-zygote",ZYGOTE_DEFAULT_IDLE_SECONDS);
+
+    // A cache shared by all the hosts, looked in before building and given the exec after a build.
+    const std::string remoteCache = GetArgumentOrEnvironment(seaBangExtraArguments,"--seabang-remote-cache","SEABANG_REMOTE_CACHE");
+    const int remoteCacheTimeout = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-remote-timeout",REMOTE_CACHE_DEFAULT_TIMEOUT_MS);
+
+    // With a cold tier the temp folder only holds the execs used lately, the rest are compressed in the cold tier.
+    const std::filesystem::path coldFolder = GetArgumentOrEnvironment(seaBangExtraArguments,"--seabang-cold-path","SEABANG_COLD_FOLDER");
+    const uint64_t hotTierSize = ParseByteSize(GetArgumentOrEnvironment(seaBangExtraArguments,"--seabang-hot-size","SEABANG_HOT_SIZE"),DEFAULT_HOT_TIER_SIZE);
+    const uint64_t coldTierSize = ParseByteSize(GetArgumentOrEnvironment(seaBangExtraArguments,"--seabang-cold-size","SEABANG_COLD_SIZE"),DEFAULT_COLD_TIER_SIZE);
+
+    // Which set of flags to build with. Each variant has it's own cached exec.
+    const BuildVariant* buildVariant = SelectBuildVariant(seaBangExtraArguments);
+    if( buildVariant == nullptr )
+    {
+        return EXIT_FAILURE;
+    }
+
+    BuildVariant zygoteVariant;
+    if( zygote )
+    {
+        zygoteVariant = GetZygoteBuildVariant(*buildVariant);
+        buildVariant = &zygoteVariant;
+    }
+
+    BuildVariant moduleVariant;
+    if( moduleHost )
+    {
+        moduleVariant = GetModuleBuildVariant(*buildVariant);
+        buildVariant = &moduleVariant;
+    }
+
+    if( gVerboseLogging )
+    {
+        LogArguments(seaBangExtraArguments,"seabang");
+        LogArguments(applicationArguments,"application");
+        LogArguments(compilerExtraArguments,"compiler");
+    }
+
+    const std::filesystem::path CWD = std::filesystem::current_path();
+    const std::filesystem::path pathedSourceFile = CWD / originalSourceFile;
+
+    // Sanity check, is file there? This is done to check for errors in the logic of the code above. 
+    if( std::filesystem::exists(pathedSourceFile) == false )
+    {
+        VLOG("The source file we are trying to run is not found at: " << pathedSourceFile);
+        return EXIT_FAILURE;
+    }
+
+    // Get the path to the source file, need this as we need to insert the project configuration name so we can find it.
+    const std::filesystem::path sourceFilePath = std::filesystem::path(pathedSourceFile).remove_filename();
+
+    // This is the temp folder path we use to cache build results.
+    const std::filesystem::path tempFolderPath(FindTemporayFolder(seaBangExtraArguments));
+
+    // Libraries named by package, from the shebang or a pragma in the source, have their flags added to the compiler's.
+    std::vector<std::string> packages = SplitString(GetArgumentValue(seaBangExtraArguments,"--seabang-pkg"),",");
+    GetPackagesFromSource(pathedSourceFile,packages);
+    if( packages.size() > 0 )
+    {
+        std::vector<std::string> packageFlags;
+        std::string packageError;
+        if( ResolvePackages(packages,tempFolderPath,packageFlags,packageError) == false )
+        {
+            std::cerr << "Failed to find the packages " << JoinStrings(packages," ") << " with pkg-config\n" << packageError << "\n";
+            return EXIT_FAILURE;
+        }
+        if( gVerboseLogging )
+        {
+            LogArguments(packageFlags,"package");
+        }
+        compilerExtraArguments.insert(compilerExtraArguments.end(),packageFlags.begin(),packageFlags.end());
+    }
+
+    // We need the source file without the shebang too.
+    const std::filesystem::path tempSourcefile = ChooseTempSourceFilename(tempFolderPath,compactTempPath,pathedSourceFile);
+
+    // Now we need to create the path to the compiled exec.
+    // This is done so we only have to build when something changes.
+    // To ensure no clashes I take the fully pathed temporay source file name and add the variant name and .exe at the end.
+    const std::filesystem::path pathedExeName = GetBuildVariantExeName(tempSourcefile,*buildVariant);
+
+
+    // The temp folder that it's all done in.
+    const std::filesystem::path projectTempFolder = std::filesystem::path(tempSourcefile).remove_filename();
+
+    // Pick the compiler that the user wants or was selected when the tool was built.
+    const std::string CompilerToUse = SelectComplier(seaBangExtraArguments);
+
+    // Make sure the new temp source file is not pointing to original source file.
+    if( std::filesystem::equivalent(pathedSourceFile,tempSourcefile) )
+    {
+        VLOG("Error in temporay path. Original source file is same as temporay source file.\n    " << originalSourceFile << "\n    " << tempSourcefile);
+        return EXIT_FAILURE;
+    }
+
+    // The compiler's fingerprint and the flags make up the build key, if they change the exec has to be rebuilt.
+    BuildSettings buildSettings;
+    buildSettings.mCompiler = CompilerToUse;
+    buildSettings.mCWD = CWD;
+    buildSettings.mPathedSourceFile = pathedSourceFile;
+    buildSettings.mTempSourcefile = tempSourcefile;
+    buildSettings.mTempFolder = tempFolderPath;
+    buildSettings.mMaxJobs = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-jobs",GetDefaultMaxJobs());
+    buildSettings.mCompilerExtraArguments = compilerExtraArguments;
+    buildSettings.mTimeTrace = SearchString(seaBangExtraArguments,"--seabang-time-trace");
+    buildSettings.mIgnoreCosmetic = SearchString(seaBangExtraArguments,"--seabang-ignore-cosmetic");
+    buildSettings.mRememberFailures = SearchString(seaBangExtraArguments,"--seabang-remember-failures");
+    buildSettings.mWorkers = ParseWorkerList(GetArgumentOrEnvironment(seaBangExtraArguments,"--seabang-workers","SEABANG_WORKERS"));
+    buildSettings.mWorkerTimeout = GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-worker-timeout",COMPILE_WORKER_DEFAULT_TIMEOUT_MS);
+
+    ToolchainFingerprint toolchain;
+    if( GetToolchainFingerprint(CompilerToUse,tempFolderPath,toolchain) )
+    {
+        buildSettings.mToolchain = toolchain.ToString();
+        VLOG("Compiler fingerprint " << buildSettings.mToolchain);
+    }
+    else
+    {
+        VLOG("Could not find the compiler " << CompilerToUse << ", can not check it has not changed");
+    }
+    const BuildKey buildKey = MakeBuildKey(buildSettings,*buildVariant);
+
+    VLOG("Source file " << pathedSourceFile);
+    VLOG("Temp Source file " << tempSourcefile);
+    VLOG("exe file name " << pathedExeName);
+
     // Make sure our temp folder is there.
     std::filesystem::create_directories(projectTempFolder);
 
     std::vector<std::string> libraryFiles;
 
+    if( importBundle )
+    {
+        return ImportBundle(bundleFile,bundleManifest,buildSettings,*buildVariant,pathedExeName);
+    }
+
+    // When the change that makes the exec out of date was made, used to see how stale the exec is. Zero if we don't know.
+    time_t outOfDateSince = 0;
+
     // Check the temp source that is compiled is there and that it's date is not older than the one we're executing.
     // Will also 
     // May have been forced on.
@@ -473,13 +2269,50 @@ int main(int argc,char *argv[])
         {
             rebuildNeeded = true;
             VLOG("File times differ, need to rebuild");
+
+            struct stat Stats;
+            if( stat(pathedSourceFile.c_str(),&Stats) == 0 )
+            {
+                outOfDateSince = Stats.st_mtim.tv_sec;
+            }
+
+            if( std::filesystem::exists(tempSourcefile) == false )
+            {
+                EXPLAIN("seabang: rebuilding, there is no copy of the source in " << projectTempFolder << ", it has not been built before or the cache was cleared");
+            }
+            else
+            {
+                EXPLAIN("seabang: rebuilding, " << pathedSourceFile << " is newer than the copy the exec was built from");
+                EXPLAIN("    modified " << FormatFileTime(GetModifiedTime(pathedSourceFile)));
+                EXPLAIN("    copy     " << FormatFileTime(GetModifiedTime(tempSourcefile)));
+                ExplainSourceHash(buildSettings,pathedExeName);
+            }
+        }
+        else if( BuildKeyMatches(pathedExeName,buildKey) == false )
+        {
+            rebuildNeeded = true;
+            VLOG("Compiler or flags differ, need to rebuild");
+            if( gExplainRebuild )
+            {
+                ExplainBuildKey(pathedExeName,buildKey);
+            }
+        }
+        else if( buildSettings.mTimeTrace && std::filesystem::exists(GetTimeTraceFilename(pathedExeName)) == false )
+        {
+            rebuildNeeded = true;
+            VLOG("Compile time trace asked for and the exec does not have one, need to rebuild");
+            EXPLAIN("seabang: rebuilding, --seabang-time-trace given and there is no trace for " << pathedExeName);
         }
     }
     else
     {
         VLOG("Comandline forcing build");
+        EXPLAIN("seabang: rebuilding, --rebuild given");
     }
 
+    // Started while the dependency check runs, used if it says to build and nothing else has got the exec by then.
+    SpeculativeBuild speculativeBuild;
+
     // Ok, so the source file may not have changed but has any of it's dependencies?
     // We do this as the exec maybe including a header in the same folder or from else where that maybe changing.
     // This will also check the age of the source file against the age of the executable file.
@@ -491,145 +2324,237 @@ int main(int argc,char *argv[])
         Dependencies::PathVec includePaths;
         includePaths.push_back(CWD);
         Dependencies sourceFileDependencies;
-        rebuildNeeded = sourceFileDependencies.RequiresRebuild(pathedSourceFile,pathedExeName,includePaths);
+
+        // Shared with the other seabangs on the host, so when many start at once the headers are only looked at by the first.
+        std::unique_ptr<SharedStatCache> sharedStatCache;
+        if( SearchString(seaBangExtraArguments,"--seabang-stat-cache") || GetArgumentValue(seaBangExtraArguments,"--seabang-stat-cache").size() > 0 )
+        {
+            sharedStatCache = std::make_unique<SharedStatCache>(tempFolderPath,GetArgumentValueAsInt(seaBangExtraArguments,"--seabang-stat-cache",STAT_CACHE_DEFAULT_VALID_MS));
+            sourceFileDependencies.SetSharedCache(sharedStatCache.get());
+        }
+
+        if( speculateAfterMS >= 0 )
+        {
+            // On a slow file system the check can take longer than the build, so past a point it is started in case it's needed.
+            // The build's process is forked now, while we still only have the one thread.
+            speculativeBuild.Prepare(buildSettings,*buildVariant,pathedExeName);
+            std::future<bool> dependencyCheck = std::async(std::launch::async,[&]()
+            {
+                return sourceFileDependencies.RequiresRebuild(pathedSourceFile,pathedExeName,includePaths);
+            });
+
+            if( dependencyCheck.wait_for(std::chrono::milliseconds(speculateAfterMS)) == std::future_status::timeout )
+            {
+                VLOG("Dependency check still going after " << speculateAfterMS << "ms, starting a speculative build");
+                speculativeBuild.Start();
+            }
+            rebuildNeeded = dependencyCheck.get();
+            if( rebuildNeeded == false || speculativeBuild.IsRunning() == false )
+            {
+                speculativeBuild.Cancel();
+            }
+        }
+        else
+        {
+            rebuildNeeded = sourceFileDependencies.RequiresRebuild(pathedSourceFile,pathedExeName,includePaths);
+        }
+
         if( rebuildNeeded )
-            VLOG("Dependency check says we need a rebuild")
+        {
+            VLOG("Dependency check says we need a rebuild, " << sourceFileDependencies.GetRebuildTrigger() << " changed");
+            outOfDateSince = sourceFileDependencies.GetRebuildTriggerTime().tv_sec;
+            if( gExplainRebuild )
+            {
+                ExplainDependencyRebuild(buildSettings,pathedExeName,sourceFileDependencies);
+            }
+        }
         else
+        {
             VLOG("Dependency check says, NO rebuild needed")
+            EXPLAIN("seabang: no rebuild needed, " << pathedExeName << " is up to date");
+        }
     }
     else
     {
         VLOG("We already know we need a rebuild, skipping dependency check");
     }
 
+    // The checks above go by file dates, an edit to a comment is as good as any other to them.
+    if( rebuildNeeded && buildSettings.mIgnoreCosmetic && forceRebuild == false && buildSettings.mTimeTrace == false &&
+        OnlyCosmeticChanges(buildSettings,buildKey,pathedExeName) )
+    {
+        rebuildNeeded = false;
+        VLOG("Only comments or white space have changed, no rebuild needed");
+        EXPLAIN("seabang: no rebuild needed after all, only comments or white space have changed since " << pathedExeName << " was built");
+    }
+
+    // Putting it back from the cold tier is much quicker than building it, if the source has not changed since.
+    // If this is the first miss since the host booted the rest of the hot tier is put back too.
+    if( rebuildNeeded && forceRebuild == false && coldFolder.empty() == false && buildSettings.mTimeTrace == false )
+    {
+        if( HotTierNeedsRestore(tempFolderPath) )
+        {
+            RestoreHotTierInBackground(coldFolder,hotTierSize);
+        }
+
+        if( RestoreFromColdTier(GetColdFilename(coldFolder,pathedExeName),&buildKey) )
+        {
+            rebuildNeeded = false;
+            EXPLAIN("seabang: restored " << pathedExeName << " from the cold tier, no build needed");
+        }
+    }
+    else if( rebuildNeeded == false && coldFolder.empty() == false )
+    {
+        MarkExecutableUsed(pathedExeName);
+    }
+
+    // If the last build from these exact inputs failed then so will this one, show why it failed and stop.
+    if( rebuildNeeded && buildSettings.mRememberFailures && forceRebuild == false )
+    {
+        std::string diagnostics;
+        if( KnownBrokenBuild(buildSettings,*buildVariant,pathedExeName,diagnostics) )
+        {
+            std::clog << diagnostics << "\n";
+            std::cerr << "seabang: " << pathedSourceFile << " failed to build and has not changed since, use --rebuild to build it anyway\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     if( rebuildNeeded )
     {
         VLOG("Source file rebuild needed!");
 
         // Ok, we better build it.
-        // Copy all lines of the file over excluding the first line that has the shebang.
-        std::string line;
-        std::ifstream oldSource(pathedSourceFile);
-        std::ofstream newSource(tempSourcefile);
-        if( newSource )
+        if( CopySourceWithoutShebang(pathedSourceFile,tempSourcefile) == false )
         {
-            bool foundShebang = false;
-
-            while( std::getline(oldSource,line) )
-            {
-                VLOG(line);
-
-                if( line[0] == '#' && line[1] == '!' ) // Is it the shebang? If so remove it.
-                {
-                    foundShebang = true;
-                }
-                else
-                {
-                    newSource << line << std::endl;
-                }
-            }
+            return EXIT_FAILURE;
+        }
 
-            if( !foundShebang )
+        // Every snippet starts with the same preamble, it is precompiled the first time it's needed for the compiler and flags.
+        if( snippet && IsClangCompiler(CompilerToUse,buildSettings.mToolchain) == false )
+        {
+            std::string preambleOutput;
+            if( BuildSnippetPreamble(CompilerToUse,tempFolderPath,GetCompilerFlags(*buildVariant,compilerExtraArguments),preambleOutput) == false )
             {
-                std::cerr << "Failed to parse the source file..." << std::endl;
-                return EXIT_FAILURE;
+                VLOG("Failed to precompile the snippet preamble, building without it\n" << preambleOutput);
             }
         }
-        else
-        {
-            std::cerr << "Failed to parse the source file into new temp file..." << std::endl;
-            return EXIT_FAILURE;
-        }
     }
     else
     {
         VLOG("Skipping rebuild, executable is not out of date.");
     }
 
+    // Stale while revalidate, if allowed the last good exec is run now and rebuilt in the background.
+    // Not done when forced, or when the compiler or flags changed, or a dependency went missing as then we don't know when it changed.
+    bool runStale = false;
+    if( staleAllowed && rebuildNeeded && forceRebuild == false && outOfDateSince > 0 && std::filesystem::exists(pathedExeName) )
+    {
+        const time_t staleness = time(nullptr) - outOfDateSince;
+        runStale = maxStaleness < 0 || staleness <= maxStaleness;
+        VLOG("Exec is " << staleness << " seconds stale, " << (runStale ? "running it and rebuilding in the background" : "too stale to run"));
+    }
+
     // No point doing the link stage is the source file has not changed!
     bool compliedOK = true;
+    std::filesystem::path exeToRun = pathedExeName;
     if( rebuildNeeded )
     {
-        // Make source output is deleted so can run if there was a build error.
-        std::filesystem::remove(pathedExeName);
-
-        // First compile the new source file that is in the temp folder, this has the she bang removed, so it'll compile.
-        std::vector<std::string> args;
-
-        args.push_back(tempSourcefile);
-
-        // For now, we'll build a release build. Later I'll add an option for a debug or release to be selected in the comand line options to seabang.
-        if( debugBuild )
+        if( runStale )
         {
-            args.push_back("-g2");
-            args.push_back("-DDEBUG_BUILD");
+            BuildExecutableInBackground(buildSettings,*buildVariant,pathedExeName);
         }
         else
         {
-            args.push_back("-o2");
-            args.push_back("-g0");
-            args.push_back("-DRELEASE_BUILD");
-            args.push_back("-DNDEBUG");
+            // The remote cache is not looked in when forced, as then they want it built, or when tracing, as the trace is not shared.
+            const BundleManifest remoteManifest = remoteCache.size() > 0 ? MakeBundleManifest(buildSettings,*buildVariant) : BundleManifest();
+            bool fetchedFromRemoteCache = false;
+            if( remoteCache.size() > 0 && forceRebuild == false && buildSettings.mTimeTrace == false && FetchFromRemoteCache(remoteCache,remoteCacheTimeout,remoteManifest,buildSettings,*buildVariant,pathedExeName) )
+            {
+                EXPLAIN("seabang: fetched " << pathedExeName << " from the remote cache, no build needed");
+                fetchedFromRemoteCache = true;
+            }
+            else if( speculativeBuild.IsRunning() && tieredBuild == false )
+            {
+                VLOG("Using the speculative build of " << pathedExeName);
+                compliedOK = speculativeBuild.Finish();
+            }
+            else if( tieredBuild )
+            {
+                compliedOK = BuildTiered(buildSettings,*buildVariant,pathedExeName,forceRebuild,exeToRun);
+            }
+            else
+            {
+                compliedOK = BuildExecutable(buildSettings,*buildVariant,pathedExeName);
+            }
+
+            // However it was built. Not the quick exec of a tiered build, that is not what the key is for.
+            if( compliedOK && remoteCache.size() > 0 && fetchedFromRemoteCache == false && exeToRun == pathedExeName && std::filesystem::exists(pathedExeName) )
+            {
+                UploadToRemoteCache(remoteCache,remoteCacheTimeout,remoteManifest,pathedExeName);
+            }
+
+            if( compliedOK && coldFolder.empty() == false && std::filesystem::exists(pathedExeName) )
+            {
+                UpdateCacheTiersInBackground(coldFolder,hotTierSize,coldTierSize,buildSettings,pathedExeName);
+            }
         }
+    }
 
-        // Need to add the current working dir as a search path.
-        // This is because the file maybe including a a file from a local path and not the system include folder.
-        // E.g #include "../somecode.cpp"
-        args.push_back("-I" + CWD.string());
+    // Not used, the exec was fetched, restored or is being built some other way.
+    speculativeBuild.Cancel();
 
-        // For now we'll assume c++17, later add option to allow them to define this. Will always default to c++17
-        args.push_back("-std=c++17");
-        args.push_back("-Wall"); // Lots of warnings please.
-        
-        args.push_back("-lm");  // Maths libs
-        args.push_back("-lstdc++");  // C++ stuff
-        args.push_back("-lpthread");  // For threading
+    // See if we have the output file, if so run it!
+    if( compliedOK && std::filesystem::exists(exeToRun) )
+    {// I will not be using ExecuteShellCommand as I need to replace this exec to allow the input and output to be taken over.
 
-        if( gVerboseLogging )
+        if( chdir(CWD.c_str()) != 0 )
         {
-            args.push_back("-v");
+            std::cerr << "Failed to return to the original run folder " << CWD << std::endl;
+            return EXIT_FAILURE;
         }
-
-        // Add stuff passed in for the compiler
-        for( auto arg : compilerExtraArguments )
+        if( exportBundle )
         {
-            args.push_back(arg);
+            return ExportBundle(seaBangExtraArguments,buildSettings,*buildVariant,pathedExeName);
         }
 
-        // And set the output file.
-        args.push_back("-o");
-        args.push_back(pathedExeName);
+        if( benchRuns > 0 )
+        {
+            return BenchmarkExecutable(seaBangExtraArguments,benchRuns,buildSettings,*buildVariant,pathedExeName,applicationArguments);
+        }
 
-        if( gVerboseLogging )
+        if( zygote )
         {
-            std::cout << CompilerToUse << " ";
-            for(auto s : args )
+            const std::filesystem::path socketFile = GetZygoteSocketFilename(tempFolderPath,exeToRun);
+            int exitCode;
+            if( RunInZygote(socketFile,exeToRun,applicationArguments,exitCode) )
             {
-                std::cout << s << " ";
+                return exitCode;
             }
-            std::cout << "\n\n";
-        }
 
-        std::string compileOutput;
-        compliedOK = ExecuteShellCommand(CompilerToUse,args,compileOutput);
-        if( compileOutput.size() > 0 && (compliedOK == false || gVerboseLogging ) )
-        {
-            std::clog << compileOutput << "\n";
+            // This run does not wait for it, the next one will use it.
+            VLOG("No zygote for " << exeToRun << ", starting one on " << socketFile);
+            StartZygote(socketFile,exeToRun,zygoteIdleSeconds);
         }
-    }
-
-    // See if we have the output file, if so run it!
-    if( compliedOK && std::filesystem::exists(pathedExeName) )
-    {// I will not be using ExecuteShellCommand as I need to replace this exec to allow the input and output to be taken over.
 
-        if( chdir(CWD.c_str()) != 0 )
+        if( moduleHost )
         {
-            std::cerr << "Failed to return to the original run folder " << CWD << std::endl;
-            return EXIT_FAILURE;
+            const std::filesystem::path socketFile = GetModuleHostSocketFilename(tempFolderPath);
+            int exitCode;
+            if( RunInZygote(socketFile,exeToRun,applicationArguments,exitCode) )
+            {
+                return exitCode;
+            }
+
+            // Like the zygote, this run does not wait for the host. A module is not an exec so it is run in our process.
+            VLOG("No module host for " << exeToRun << ", starting one on " << socketFile);
+            StartModuleHost(tempFolderPath,moduleHostIdleSeconds);
+            return RunModule(exeToRun,applicationArguments,exitCode) ? exitCode : EXIT_FAILURE;
         }
-        VLOG("Running exec: " << pathedExeName);
 
-        std::string cmd = pathedExeName.string();
+        VLOG("Running exec: " << exeToRun);
+
+        std::string cmd = exeToRun.string();
         for( auto arg : applicationArguments )
         {
             cmd += " ";
@@ -642,7 +2567,7 @@ int main(int argc,char *argv[])
     }
     else
     {
-        std::cerr << "Failed to find executable " << pathedExeName << std::endl;
+        std::cerr << "Failed to find executable " << exeToRun << std::endl;
         return EXIT_FAILURE;
     }
 
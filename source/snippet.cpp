@@ -0,0 +1,173 @@
+/**
+ * @file snippet.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <fstream>
+
+#include "snippet.h"
+#include "execute_command.h"
+#include "hash.h"
+
+static const char* SNIPPET_PREAMBLE = R"PREAMBLE(#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+using namespace std;
+)PREAMBLE";
+
+static std::filesystem::path GetSnippetFolder(const std::filesystem::path& pTempFolder)
+{
+	return pTempFolder / ".seabang" / "snippets";
+}
+
+/**
+ * @brief Writes the file to a unique name then moves it into place, so a seabang running at the same time never sees half of it.
+ */
+static bool WriteFileOnce(const std::filesystem::path& pFile,const std::string& pContent)
+{
+	if( std::filesystem::exists(pFile) )
+		return true;
+
+	const std::filesystem::path newFile = (std::filesystem::path(pFile) += "." + std::to_string(getpid()));
+	{
+		std::ofstream file(newFile,std::ios::trunc);
+		if( !(file << pContent) )
+			return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(newFile,pFile,ec);
+	if( ec )
+	{
+		std::filesystem::remove(newFile,ec);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Looks for main followed by an open bracket. Can be fooled by a comment or string, then the code is just not put in a main.
+ */
+static bool HasMain(const std::string& pCode)
+{
+	for( size_t pos = pCode.find("main") ; pos != std::string::npos ; pos = pCode.find("main",pos + 4) )
+	{
+		if( pos > 0 && (isalnum((unsigned char)pCode[pos-1]) || pCode[pos-1] == '_') )
+			continue;
+
+		size_t next = pos + 4;
+		while( next < pCode.size() && isspace((unsigned char)pCode[next]) )
+			next++;
+
+		if( next < pCode.size() && pCode[next] == '(' )
+			return true;
+	}
+	return false;
+}
+
+bool IsSnippetArgument(const char* pArg)
+{
+	return strcmp(pArg,"-e") == 0 || strcmp(pArg,"-") == 0;
+}
+
+bool WriteSnippetSource(const std::filesystem::path& pTempFolder,const std::string& pCode,std::filesystem::path& rSourceFile)
+{
+	const std::filesystem::path folder = GetSnippetFolder(pTempFolder);
+	const std::filesystem::path preamble = folder / "preamble.h";
+
+	std::error_code ec;
+	std::filesystem::create_directories(folder,ec);
+	if( WriteFileOnce(preamble,SNIPPET_PREAMBLE) == false )
+		return false;
+
+	// The preamble has to be the first thing included for the precompiled one to be used. The shebang is removed before the build.
+	// The #line is so errors in the code are reported against the snippet and not the file made for it.
+	std::string source = "#!/usr/bin/env seabang\n#include \"" + preamble.string() + "\"\n";
+	if( HasMain(pCode) )
+	{
+		source += "#line 1 \"snippet\"\n" + pCode + "\n";
+	}
+	else
+	{
+		source += "int main(int argc,char *argv[])\n{\n#line 1 \"snippet\"\n" + pCode + "\n;return EXIT_SUCCESS;\n}\n";
+	}
+
+	rSourceFile = folder / (HashToString(HashString(source)) + ".cpp");
+	return WriteFileOnce(rSourceFile,source);
+}
+
+bool BuildSnippetPreamble(const std::string& pCompiler,const std::filesystem::path& pTempFolder,const std::vector<std::string>& pFlags,std::string& rOutput)
+{
+	// Gcc looks in a .gch folder for a precompiled header that matches the flags being used, there is one for each set of flags.
+	std::string name = pCompiler;
+	for( const std::string& flag : pFlags )
+		name += "\n" + flag;
+
+	const std::filesystem::path preamble = GetSnippetFolder(pTempFolder) / "preamble.h";
+	const std::filesystem::path folder = (std::filesystem::path(preamble) += ".gch");
+	const std::filesystem::path pchFile = folder / (HashToString(HashString(name + "\n" + SNIPPET_PREAMBLE)) + ".gch");
+	if( std::filesystem::exists(pchFile) )
+		return true;
+
+	std::error_code ec;
+	std::filesystem::create_directories(folder,ec);
+
+	// Built outside the folder, gcc would try to use one that is only half written.
+	const std::filesystem::path newFile = (std::filesystem::path(folder) += "." + pchFile.stem().string() + "." + std::to_string(getpid()));
+	// The -c stops the libraries in the flags being linked into nothing.
+	std::vector<std::string> args = {"-x","c++-header",preamble.string()};
+	args.insert(args.end(),pFlags.begin(),pFlags.end());
+	args.push_back("-c");
+	args.push_back("-o");
+	args.push_back(newFile.string());
+
+	if( ExecuteShellCommand(pCompiler,args,rOutput) == false )
+	{
+		std::filesystem::remove(newFile,ec);
+		return false;
+	}
+
+	std::filesystem::rename(newFile,pchFile,ec);
+	return ec ? false : true;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file snippet.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __SNIPPET_H__
+#define __SNIPPET_H__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// A snippet is code given on the command line with -e, or on stdin with -, and not in a file.
+// It is written to the temp folder as a script named by a hash of it's text, so running the same snippet again finds the
+// exec that was built for it the first time. The code is put inside a main after the preamble, a header of the commonly used
+// std headers and a using namespace std. If the code has it's own main it is only put after the preamble.
+// The preamble is the same for every snippet so it is precompiled, once for each compiler and set of flags.
+
+// Returns true if the argument starts a snippet, -e or -.
+bool IsSnippetArgument(const char* pArg);
+
+// Writes the script for the snippet, if there is not one already, and returns it's file name.
+bool WriteSnippetSource(const std::filesystem::path& pTempFolder,const std::string& pCode,std::filesystem::path& rSourceFile);
+
+// Builds the precompiled preamble for the compiler and flags if it is not already built. Snippets build without it, just slower.
+bool BuildSnippetPreamble(const std::string& pCompiler,const std::filesystem::path& pTempFolder,const std::vector<std::string>& pFlags,std::string& rOutput);
+
+#endif //#ifndef __SNIPPET_H__
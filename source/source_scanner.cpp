@@ -0,0 +1,470 @@
+/**
+ * @file source_scanner.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "source_scanner.h"
+#include "hash.h"
+
+MappedFile::MappedFile(const std::filesystem::path& pFilename)
+{
+	const int fd = open(pFilename.c_str(),O_RDONLY|O_CLOEXEC);
+	if( fd < 0 )
+		return;
+
+	struct stat Stats;
+	if( fstat(fd,&Stats) == 0 && S_ISREG(Stats.st_mode) )
+	{
+		if( Stats.st_size > 0 )
+		{
+			void* data = mmap(nullptr,(size_t)Stats.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+			if( data != MAP_FAILED )
+			{
+				// We only ever read it front to back, once.
+				madvise(data,(size_t)Stats.st_size,MADV_SEQUENTIAL);
+				mData = (const char*)data;
+				mSize = (size_t)Stats.st_size;
+				mOpen = true;
+			}
+		}
+		else
+		{
+			mOpen = true;
+		}
+	}
+	close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if( mData )
+		munmap((void*)mData,mSize);
+}
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static inline bool IsIdentifier(char c)
+{
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+static bool IsBlank(const char* pStart,const char* pEnd)
+{
+	for( ; pStart < pEnd ; pStart++ )
+	{
+		if( IsSpace(*pStart) == false )
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Does a backslash come before the new line at pNewLine, with or without a \r, so the line goes on to the next.
+ */
+static bool IsSplicedNewLine(const char* pLineStart,const char* pNewLine)
+{
+	if( pNewLine > pLineStart && pNewLine[-1] == '\r' )
+		pNewLine--;
+	return pNewLine > pLineStart && pNewLine[-1] == '\\';
+}
+
+/**
+ * @brief Finds the next byte that can change what the scanner is looking at, new line, #, /, " or '.
+ * Most of a source file is none of these so it is skipped sixteen bytes at a time where SSE2 is there.
+ */
+static const char* FindNextSpecial(const char* p,const char* pEnd)
+{
+#if defined(__SSE2__)
+	const __m128i newLine = _mm_set1_epi8('\n');
+	const __m128i hash = _mm_set1_epi8('#');
+	const __m128i slash = _mm_set1_epi8('/');
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i apostrophe = _mm_set1_epi8('\'');
+	while( pEnd - p >= 16 )
+	{
+		const __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+		const __m128i hits = _mm_or_si128(
+								_mm_or_si128(_mm_cmpeq_epi8(chunk,newLine),_mm_cmpeq_epi8(chunk,hash)),
+								_mm_or_si128(_mm_cmpeq_epi8(chunk,slash),_mm_or_si128(_mm_cmpeq_epi8(chunk,quote),_mm_cmpeq_epi8(chunk,apostrophe))));
+		const int mask = _mm_movemask_epi8(hits);
+		if( mask != 0 )
+			return p + __builtin_ctz(mask);
+		p += 16;
+	}
+#endif
+	for( ; p < pEnd ; p++ )
+	{
+		const char c = *p;
+		if( c == '\n' || c == '#' || c == '/' || c == '"' || c == '\'' )
+			return p;
+	}
+	return pEnd;
+}
+
+/**
+ * @brief Skips a string or character literal, p is just after the opening quote.
+ * Stops at the end of the line if it is not terminated so a stray quote can not eat the rest of the file.
+ */
+static const char* SkipQuoted(const char* p,const char* pEnd,char pQuote)
+{
+	while( p < pEnd )
+	{
+		const char c = *p;
+		if( c == '\\' )
+			p += 2;
+		else if( c == pQuote )
+			return p + 1;
+		else if( c == '\n' )
+			return p;
+		else
+			p++;
+	}
+	return pEnd;
+}
+
+/**
+ * @brief Checks if the " at p starts a raw string, R"delim( ... )delim", allowing for the u8, u, U and L prefixes.
+ */
+static bool IsRawString(const char* pSource,const char* p)
+{
+	if( p - pSource < 1 || p[-1] != 'R' )
+		return false;
+
+	const char* prefix = p - 1;
+	if( prefix > pSource && (prefix[-1] == 'u' || prefix[-1] == 'U' || prefix[-1] == 'L') )
+		prefix--;
+	else if( prefix - pSource >= 2 && prefix[-1] == '8' && prefix[-2] == 'u' )
+		prefix -= 2;
+
+	return prefix == pSource || IsIdentifier(prefix[-1]) == false;
+}
+
+/**
+ * @brief Skips a raw string, p is just after the opening quote.
+ */
+static const char* SkipRawString(const char* p,const char* pEnd)
+{
+	const char* delimiter = p;
+	while( p < pEnd && *p != '(' && *p != '\n' && p - delimiter <= 16 )
+		p++;
+
+	if( p >= pEnd || *p != '(' )
+		return p;// Malformed, carry on from here.
+
+	const size_t delimiterLength = p - delimiter;
+	while( (p = (const char*)memchr(p,')',pEnd - p)) != nullptr )
+	{
+		p++;
+		if( (size_t)(pEnd - p) > delimiterLength && memcmp(p,delimiter,delimiterLength) == 0 && p[delimiterLength] == '"' )
+			return p + delimiterLength + 1;
+	}
+	return pEnd;
+}
+
+/**
+ * @brief Checks if the ' at p is a C++14 digit separator, as in 1'000'000, by looking back for the start of the number.
+ */
+static bool IsDigitSeparator(const char* pSource,const char* p)
+{
+	const char* start = p;
+	while( start > pSource && (IsIdentifier(start[-1]) || start[-1] == '\'' || start[-1] == '.') )
+		start--;
+	return start < p && isdigit((unsigned char)*start);
+}
+
+/**
+ * @brief p is just after a # at the start of a line. If it is #include "file" the name is passed on.
+ * Returns where to carry on scanning from.
+ */
+static const char* ParseDirective(const char* p,const char* pEnd,const IncludeCallback& pFound)
+{
+	while( p < pEnd && IsSpace(*p) )
+		p++;
+
+	if( pEnd - p < 8 || memcmp(p,"include",7) != 0 )
+		return p;
+	p += 7;
+
+	if( IsSpace(*p) == false && *p != '"' && *p != '<' )
+		return p;// Something like #include_next, not for us.
+
+	while( p < pEnd && IsSpace(*p) )
+		p++;
+
+	// Don't include files included with <> as these SHOULD be system headers.
+	// There is a difference between #include "" and #include <>. Changes compiler search priorities.
+	if( p < pEnd && *p == '"' )
+	{
+		const char* name = ++p;
+		while( p < pEnd && *p != '"' && *p != '\n' )
+			p++;
+
+		if( p < pEnd && *p == '"' )
+		{
+			if( p > name )
+				pFound(name,p - name);
+			return p + 1;
+		}
+	}
+	return p;
+}
+
+void ScanIncludes(const char* pSource,size_t pSize,const IncludeCallback& pFound)
+{
+	const char* p = pSource;
+	const char* const end = pSource + pSize;
+	const char* lineStart = pSource;
+
+	// A block comment can come before a directive on the same line, /* like this */ #include "this.h".
+	// These track where the last one ended and if the line was blank up to where it started.
+	const char* commentEnd = nullptr;
+	bool blankBeforeComment = true;
+
+	// Is everything on this line, before pWhere, white space or comments?
+	auto lineBlankUpTo = [&](const char* pWhere)
+	{
+		if( commentEnd != nullptr && commentEnd > lineStart )
+			return blankBeforeComment && IsBlank(commentEnd,pWhere);
+		return IsBlank(lineStart,pWhere);
+	};
+
+	while( (p = FindNextSpecial(p,end)) < end )
+	{
+		switch( *p )
+		{
+		case '\n':
+			lineStart = ++p;
+			break;
+
+		case '#':
+			if( lineBlankUpTo(p) )
+				p = ParseDirective(p + 1,end,pFound);
+			else
+				p++;
+			break;
+
+		case '/':
+			if( p + 1 < end && p[1] == '/' )
+			{// Line comment, leave the new line for the next time round so the line start is tracked. It goes on to the next line if this one ends in a backslash.
+				const char* newLine = p + 2;
+				while( (newLine = (const char*)memchr(newLine,'\n',end - newLine)) != nullptr && IsSplicedNewLine(p + 2,newLine) )
+					newLine++;
+				p = newLine ? newLine : end;
+			}
+			else if( p + 1 < end && p[1] == '*' )
+			{
+				blankBeforeComment = lineBlankUpTo(p);
+				const char* star = p + 2;
+				p = end;
+				while( (star = (const char*)memchr(star,'*',end - star)) != nullptr && star + 1 < end )
+				{
+					if( star[1] == '/' )
+					{
+						p = star + 2;
+						break;
+					}
+					star++;
+				}
+				commentEnd = p;
+			}
+			else
+			{
+				p++;
+			}
+			break;
+
+		case '"':
+			if( IsRawString(pSource,p) )
+				p = SkipRawString(p + 1,end);
+			else
+				p = SkipQuoted(p + 1,end,'"');
+			break;
+
+		case '\'':
+			if( IsDigitSeparator(pSource,p) )
+				p++;
+			else
+				p = SkipQuoted(p + 1,end,'\'');
+			break;
+		}
+	}
+}
+
+bool ScanIncludesInFile(const std::filesystem::path& pFilename,const IncludeCallback& pFound)
+{
+	MappedFile file(pFilename);
+	if( file.IsOpen() == false )
+		return false;
+
+	ScanIncludes(file.Data(),file.Size(),pFound);
+	return true;
+}
+
+/**
+ * @brief Could the two bytes be part of the same token, or change the token, if the white space between them went?
+ * Letters, digits, literals and dots can run together, as can the operator characters. Brackets and separators never need a space.
+ */
+static bool NeedsSpaceBetween(char pLast,char pNext)
+{
+	auto isWord = [](char c){return IsIdentifier(c) || (unsigned char)c >= 0x80 || c == '$' || c == '.' || c == '"' || c == '\'' || c == '\\';};
+	auto isOperator = [](char c){return c != 0 && strchr("+-*/%<>=!&|^.:#?~",c) != nullptr;};
+	return (isWord(pLast) && isWord(pNext)) || (isOperator(pLast) && isOperator(pNext));
+}
+
+/**
+ * @brief Is there a backslash and new line at p, that joins two lines into one.
+ */
+static size_t LineSpliceLength(const char* p,const char* pEnd)
+{
+	if( p[0] != '\\' )
+		return 0;
+	if( p + 1 < pEnd && p[1] == '\n' )
+		return 2;
+	if( p + 2 < pEnd && p[1] == '\r' && p[2] == '\n' )
+		return 3;
+	return 0;
+}
+
+uint64_t HashSourceTokens(const char* pSource,size_t pSize,uint64_t pHash)
+{
+	const char* p = pSource;
+	const char* const end = pSource + pSize;
+
+	char last = 0;				// The last byte hashed.
+	bool pendingSpace = false;	// There was white space, or a comment, since then.
+	bool pendingNewLine = false;// A directive ended, or is about to start, since then.
+	bool inDirective = false;
+	bool lineBlank = true;
+	uint32_t line = 1;			// Of the last token hashed, counted up to lineCounted.
+	uint32_t hashedLine = 1;	// The last line number that went into the hash.
+	const char* lineCounted = pSource;
+
+	auto hashToken = [&](const char* pStart,const char* pEnd)
+	{
+		// The line a token is on is part of the hash, so an edit that moves code up or down rebuilds, __LINE__ and the debug info would be wrong.
+		line += (uint32_t)std::count(lineCounted,pStart,'\n');
+		lineCounted = pStart;
+		if( line != hashedLine )
+		{
+			pHash = HashBytes(&line,sizeof(line),pHash);
+			hashedLine = line;
+		}
+
+		if( pendingNewLine )
+			pHash = HashBytes("\n",1,pHash);
+		else if( pendingSpace && (inDirective || NeedsSpaceBetween(last,*pStart)) )
+			pHash = HashBytes(" ",1,pHash);
+
+		pendingSpace = pendingNewLine = false;
+		pHash = HashBytes(pStart,pEnd - pStart,pHash);
+		last = pEnd[-1];
+		lineBlank = false;
+	};
+
+	while( p < end )
+	{
+		const char c = *p;
+		const size_t splice = LineSpliceLength(p,end);
+		if( splice > 0 )
+		{
+			pendingSpace = true;
+			p += splice;
+		}
+		else if( c == '\n' )
+		{
+			if( inDirective )
+			{
+				inDirective = false;
+				pendingNewLine = true;
+			}
+			pendingSpace = true;
+			lineBlank = true;
+			p++;
+		}
+		else if( IsSpace(c) )
+		{
+			pendingSpace = true;
+			p++;
+		}
+		else if( c == '/' && p + 1 < end && p[1] == '/' )
+		{// A line comment goes on to the next line if this one ends in a backslash.
+			p += 2;
+			while( p < end && *p != '\n' )
+			{
+				const size_t commentSplice = LineSpliceLength(p,end);
+				p += commentSplice > 0 ? commentSplice : 1;
+			}
+			pendingSpace = true;
+		}
+		else if( c == '/' && p + 1 < end && p[1] == '*' )
+		{
+			const char* star = p + 2;
+			p = end;
+			while( (star = (const char*)memchr(star,'*',end - star)) != nullptr && star + 1 < end )
+			{
+				if( star[1] == '/' )
+				{
+					p = star + 2;
+					break;
+				}
+				star++;
+			}
+			pendingSpace = true;
+		}
+		else if( c == '#' && lineBlank )
+		{
+			inDirective = true;
+			pendingNewLine = true;
+			hashToken(p,p + 1);
+			p++;
+		}
+		else if( c == '"' )
+		{
+			const char* literalEnd = IsRawString(pSource,p) ? SkipRawString(p + 1,end) : SkipQuoted(p + 1,end,'"');
+			hashToken(p,literalEnd);
+			p = literalEnd;
+		}
+		else if( c == '\'' && IsDigitSeparator(pSource,p) == false )
+		{
+			const char* literalEnd = SkipQuoted(p + 1,end,'\'');
+			hashToken(p,literalEnd);
+			p = literalEnd;
+		}
+		else
+		{
+			hashToken(p,p + 1);
+			p++;
+		}
+	}
+	return pHash;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file source_scanner.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __SOURCE_SCANNER_H__
+#define __SOURCE_SCANNER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <filesystem>
+
+// A read only memory mapping of a whole file. Empty files are not mapped, Data() is nullptr and Size() zero.
+class MappedFile
+{
+public:
+	MappedFile(const std::filesystem::path& pFilename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool IsOpen()const{return mOpen;}
+	const char* Data()const{return mData;}
+	size_t Size()const{return mSize;}
+
+private:
+	bool mOpen = false;
+	const char* mData = nullptr;
+	size_t mSize = 0;
+};
+
+// Called for each #include "file" found, the name points into the scanned source and is not null terminated.
+typedef std::function<void(const char* pName,size_t pLength)> IncludeCallback;
+
+// Finds the #include "file" directives in the source. #include <file> is skipped as they should be system headers.
+// Block and line comments, string and character literals are skipped. Nothing is allocated as the source is scanned.
+void ScanIncludes(const char* pSource,size_t pSize,const IncludeCallback& pFound);
+
+// Maps the file and scans it, returns false if the file could not be opened.
+bool ScanIncludesInFile(const std::filesystem::path& pFilename,const IncludeCallback& pFound);
+
+// Hashes the source as a stream of tokens, so editing a comment or changing the white space does not change the hash.
+// Comments are white space, white space is dropped where it can not change what the tokens are and a run of it is one space where it can.
+// Preprocessor directives are kept to their lines and the white space in them always counts, #define F (x) is not #define F(x).
+// Literals are hashed as they are. The line each token is on is part of the hash, so edits that add or remove lines before
+// code change it, as they would change __LINE__, assert messages and the lines in the debug info.
+uint64_t HashSourceTokens(const char* pSource,size_t pSize,uint64_t pHash);
+
+#endif //#ifndef __SOURCE_SCANNER_H__
@@ -0,0 +1,365 @@
+/**
+ * @file stat_cache.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <algorithm>
+
+#include "stat_cache.h"
+#include "hash.h"
+
+typedef std::atomic<uint64_t> Word;
+static_assert(Word::is_always_lock_free,"The stat cache is shared between processes, so needs lock free 64 bit atomics");
+
+// The last digits are the version, bumped when the layout changes so a file with the old one is replaced.
+static const uint64_t STAT_CACHE_MAGIC = 0x5342535441540002ULL;
+static const size_t STAT_SLOTS = 1 << 15;
+static const size_t INCLUDES_SLOTS = 1 << 13;
+static const size_t ARENA_SIZE = 4 * 1024 * 1024;
+static const size_t MAX_PROBES = 8;
+// A write takes microseconds, a slot that has been odd for longer than this was left by a writer that died and is taken over.
+static const uint64_t ABANDONED_WRITE_NS = 1000000000ULL;
+
+struct CacheHeader
+{
+	Word mMagic;
+	Word mArenaUsed;
+};
+
+struct StatSlot
+{
+	Word mSequence;		// Odd while it's being written, it is then the monotonic time the write started.
+	Word mKey;			// Hash of the path, zero for an empty slot.
+	Word mChecked;		// When the stat was taken, in monotonic nanoseconds.
+	Word mFound;
+	Word mSeconds;
+	Word mNanoseconds;
+	Word mDevice;
+	Word mInode;
+	Word mSize;
+	Word mHash;			// Of the rest, so a write by a writer that was taken over and then woke up is not used.
+};
+
+struct IncludesSlot
+{
+	Word mSequence;
+	Word mKey;			// Hash of the file's signature.
+	Word mOffset;		// Where the names are in the arena.
+	Word mLength;
+	Word mHash;			// Of the names, checked when they are read.
+};
+
+static const size_t STATS_OFFSET = 64;
+static const size_t INCLUDES_OFFSET = STATS_OFFSET + STAT_SLOTS * sizeof(StatSlot);
+static const size_t ARENA_OFFSET = INCLUDES_OFFSET + INCLUDES_SLOTS * sizeof(IncludesSlot);
+static const size_t CACHE_SIZE = ARENA_OFFSET + ARENA_SIZE;
+
+static int64_t GetNow()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Zero marks an empty slot so can't be a key.
+ */
+static uint64_t MakeKey(uint64_t pHash)
+{
+	return pHash != 0 ? pHash : 1;
+}
+
+static uint64_t MakeSignatureKey(const SharedStat& pFile)
+{
+	const uint64_t signature[] = {pFile.mDevice,pFile.mInode,pFile.mSize,(uint64_t)pFile.mTime.tv_sec,(uint64_t)pFile.mTime.tv_nsec};
+	return MakeKey(HashBytes(signature,sizeof(signature)));
+}
+
+static uint64_t HashStatSlot(uint64_t pKey,int64_t pChecked,const SharedStat& pStat)
+{
+	const uint64_t words[] = {pKey,(uint64_t)pChecked,pStat.mFound ? 1ULL : 0ULL,(uint64_t)pStat.mTime.tv_sec,(uint64_t)pStat.mTime.tv_nsec,pStat.mDevice,pStat.mInode,pStat.mSize};
+	return HashBytes(words,sizeof(words));
+}
+
+/**
+ * @brief The odd sequence a write starts with, the time now so if the writer dies it can be seen how long ago it started.
+ * It is always more than the last, so a reader can't see the same even sequence before and after a write. Unless the last
+ * is far ahead of now, then it was from before the host rebooted and the monotonic clock started again.
+ */
+static uint64_t GetWriteSequence(uint64_t pSequence,uint64_t pNow)
+{
+	if( pSequence > pNow + ABANDONED_WRITE_NS )
+		return pNow | 1;
+	return std::max(pNow | 1,(pSequence + 1) | 1);
+}
+
+/**
+ * @brief The slot the key is in, or nullptr. A reader has to check the slot's sequence is even and the same after reading it.
+ */
+template<class SLOT> static SLOT* FindSlot(SLOT* pTable,size_t pSlotCount,uint64_t pKey)
+{
+	for( size_t probe = 0 ; probe < MAX_PROBES ; probe++ )
+	{
+		SLOT& slot = pTable[(pKey + probe) & (pSlotCount - 1)];
+		const uint64_t key = slot.mKey.load(std::memory_order_relaxed);
+		if( key == pKey )
+			return &slot;
+		if( key == 0 )
+			return nullptr;
+	}
+	return nullptr;
+}
+
+/**
+ * @brief The slot with the key or the first empty one. If the probes are all taken by other keys the first is written over.
+ * Returns nullptr if another process is writing it. Once all is written EndWrite has to be called.
+ * A slot left odd by a writer that died part way is taken over once it has been odd for ABANDONED_WRITE_NS, or else it
+ * would be lost until the file is replaced.
+ */
+template<class SLOT> static SLOT* BeginWrite(SLOT* pTable,size_t pSlotCount,uint64_t pKey,uint64_t& rSequence)
+{
+	SLOT* found = &pTable[pKey & (pSlotCount - 1)];
+	for( size_t probe = 0 ; probe < MAX_PROBES ; probe++ )
+	{
+		SLOT& slot = pTable[(pKey + probe) & (pSlotCount - 1)];
+		const uint64_t key = slot.mKey.load(std::memory_order_relaxed);
+		if( key == pKey || key == 0 )
+		{
+			found = &slot;
+			break;
+		}
+	}
+
+	uint64_t sequence = found->mSequence.load(std::memory_order_relaxed);
+	const uint64_t now = (uint64_t)GetNow();
+	const uint64_t sinceWriteStarted = now >= sequence ? now - sequence : sequence - now;
+	if( (sequence & 1) && sinceWriteStarted < ABANDONED_WRITE_NS )
+		return nullptr;
+
+	rSequence = GetWriteSequence(sequence,now);
+	if( found->mSequence.compare_exchange_strong(sequence,rSequence,std::memory_order_acquire) == false )
+		return nullptr;
+
+	// So no reader sees what we write next without also seeing the sequence is odd.
+	std::atomic_thread_fence(std::memory_order_release);
+	return found;
+}
+
+/**
+ * @brief Only if the slot is still ours, if we took so long it was taken over the write is left to the one that took it.
+ */
+template<class SLOT> static void EndWrite(SLOT* pSlot,uint64_t pSequence)
+{
+	pSlot->mSequence.compare_exchange_strong(pSequence,pSequence + 1,std::memory_order_release,std::memory_order_relaxed);
+}
+
+SharedStatCache::SharedStatCache(const std::filesystem::path& pTempFolder,int pValidMS):
+	mCacheFile(pTempFolder / ".seabang" / "stat-cache"),
+	mValidNS((int64_t)pValidMS * 1000000LL)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(mCacheFile.parent_path(),ec);
+
+	// If it's from an older seabang it's replaced, once.
+	for( int attempt = 0 ; attempt < 2 && mMap == nullptr ; attempt++ )
+	{
+		const int file = open(mCacheFile.c_str(),O_RDWR|O_CREAT|O_CLOEXEC,0644);
+		if( file < 0 )
+			return;
+
+		const bool mapped = Map(file);
+		close(file);
+		if( mapped == false && attempt == 0 )
+			Replace();
+	}
+}
+
+SharedStatCache::~SharedStatCache()
+{
+	if( mMap )
+		munmap(mMap,CACHE_SIZE);
+}
+
+bool SharedStatCache::Map(int pFile)
+{
+	// A new file is made the right size by whoever gets to it first, the pages are all zero till they are written.
+	struct stat Stats;
+	if( fstat(pFile,&Stats) != 0 )
+		return false;
+	if( Stats.st_size == 0 && ftruncate(pFile,CACHE_SIZE) != 0 )
+		return false;
+	if( Stats.st_size != 0 && (size_t)Stats.st_size != CACHE_SIZE )
+		return false;
+
+	void* map = mmap(nullptr,CACHE_SIZE,PROT_READ|PROT_WRITE,MAP_SHARED,pFile,0);
+	if( map == MAP_FAILED )
+		return false;
+
+	CacheHeader* header = (CacheHeader*)map;
+	uint64_t magic = 0;
+	header->mMagic.compare_exchange_strong(magic,STAT_CACHE_MAGIC);
+	if( header->mMagic.load() != STAT_CACHE_MAGIC )
+	{
+		munmap(map,CACHE_SIZE);
+		return false;
+	}
+
+	mMap = (uint8_t*)map;
+	return true;
+}
+
+void SharedStatCache::Replace()
+{
+	const std::filesystem::path newFile = (std::filesystem::path(mCacheFile) += "." + std::to_string(getpid()));
+	const int file = open(newFile.c_str(),O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC,0644);
+	if( file < 0 )
+		return;
+
+	const bool sized = ftruncate(file,CACHE_SIZE) == 0;
+	close(file);
+
+	std::error_code ec;
+	if( sized )
+		std::filesystem::rename(newFile,mCacheFile,ec);
+	if( sized == false || ec )
+		std::filesystem::remove(newFile,ec);
+}
+
+bool SharedStatCache::GetStat(std::string_view pPath,SharedStat& rStat)
+{
+	if( mMap == nullptr )
+		return false;
+
+	const uint64_t key = MakeKey(HashBytes(pPath.data(),pPath.size()));
+	StatSlot* slot = FindSlot((StatSlot*)(mMap + STATS_OFFSET),STAT_SLOTS,key);
+	if( slot == nullptr )
+		return false;
+
+	const uint64_t sequence = slot->mSequence.load(std::memory_order_acquire);
+	if( sequence & 1 )
+		return false;
+
+	SharedStat stat;
+	const int64_t checked = (int64_t)slot->mChecked.load(std::memory_order_relaxed);
+	stat.mFound = slot->mFound.load(std::memory_order_relaxed) != 0;
+	stat.mTime.tv_sec = (time_t)slot->mSeconds.load(std::memory_order_relaxed);
+	stat.mTime.tv_nsec = (long)slot->mNanoseconds.load(std::memory_order_relaxed);
+	stat.mDevice = slot->mDevice.load(std::memory_order_relaxed);
+	stat.mInode = slot->mInode.load(std::memory_order_relaxed);
+	stat.mSize = slot->mSize.load(std::memory_order_relaxed);
+	const uint64_t slotKey = slot->mKey.load(std::memory_order_relaxed);
+	const uint64_t hash = slot->mHash.load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if( slot->mSequence.load(std::memory_order_relaxed) != sequence || slotKey != key || HashStatSlot(key,checked,stat) != hash )
+		return false;
+
+	const int64_t age = GetNow() - checked;
+	if( age < 0 || age > mValidNS )
+		return false;
+
+	rStat = stat;
+	return true;
+}
+
+void SharedStatCache::PutStat(std::string_view pPath,const SharedStat& pStat)
+{
+	if( mMap == nullptr )
+		return;
+
+	const uint64_t key = MakeKey(HashBytes(pPath.data(),pPath.size()));
+	uint64_t sequence;
+	StatSlot* slot = BeginWrite((StatSlot*)(mMap + STATS_OFFSET),STAT_SLOTS,key,sequence);
+	if( slot == nullptr )
+		return;
+
+	const int64_t checked = GetNow();
+	slot->mKey.store(key,std::memory_order_relaxed);
+	slot->mChecked.store((uint64_t)checked,std::memory_order_relaxed);
+	slot->mFound.store(pStat.mFound ? 1 : 0,std::memory_order_relaxed);
+	slot->mSeconds.store((uint64_t)pStat.mTime.tv_sec,std::memory_order_relaxed);
+	slot->mNanoseconds.store((uint64_t)pStat.mTime.tv_nsec,std::memory_order_relaxed);
+	slot->mDevice.store(pStat.mDevice,std::memory_order_relaxed);
+	slot->mInode.store(pStat.mInode,std::memory_order_relaxed);
+	slot->mSize.store(pStat.mSize,std::memory_order_relaxed);
+	slot->mHash.store(HashStatSlot(key,checked,pStat),std::memory_order_relaxed);
+	EndWrite(slot,sequence);
+}
+
+bool SharedStatCache::GetIncludes(const SharedStat& pFile,std::string& rNames)
+{
+	if( mMap == nullptr || pFile.mFound == false )
+		return false;
+
+	const uint64_t key = MakeSignatureKey(pFile);
+	IncludesSlot* slot = FindSlot((IncludesSlot*)(mMap + INCLUDES_OFFSET),INCLUDES_SLOTS,key);
+	if( slot == nullptr )
+		return false;
+
+	const uint64_t sequence = slot->mSequence.load(std::memory_order_acquire);
+	if( sequence & 1 )
+		return false;
+
+	const uint64_t offset = slot->mOffset.load(std::memory_order_relaxed);
+	const uint64_t length = slot->mLength.load(std::memory_order_relaxed);
+	const uint64_t hash = slot->mHash.load(std::memory_order_relaxed);
+	const uint64_t slotKey = slot->mKey.load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if( slot->mSequence.load(std::memory_order_relaxed) != sequence || slotKey != key || offset > ARENA_SIZE || length > ARENA_SIZE - offset )
+		return false;
+
+	// The arena is never written over, but the hash is checked in case a writer died half way through.
+	rNames.assign((const char*)mMap + ARENA_OFFSET + offset,length);
+	return HashString(rNames) == hash;
+}
+
+void SharedStatCache::PutIncludes(const SharedStat& pFile,const std::string& pNames)
+{
+	if( mMap == nullptr || pFile.mFound == false )
+		return;
+
+	// Whoever takes it past the end replaces the file, the rest just don't add theirs.
+	CacheHeader* header = (CacheHeader*)mMap;
+	const uint64_t offset = header->mArenaUsed.fetch_add(pNames.size(),std::memory_order_relaxed);
+	if( offset + pNames.size() > ARENA_SIZE )
+	{
+		if( offset <= ARENA_SIZE )
+			Replace();
+		return;
+	}
+	memcpy(mMap + ARENA_OFFSET + offset,pNames.data(),pNames.size());
+
+	const uint64_t key = MakeSignatureKey(pFile);
+	uint64_t sequence;
+	IncludesSlot* slot = BeginWrite((IncludesSlot*)(mMap + INCLUDES_OFFSET),INCLUDES_SLOTS,key,sequence);
+	if( slot == nullptr )
+		return;
+
+	slot->mKey.store(key,std::memory_order_relaxed);
+	slot->mOffset.store(offset,std::memory_order_relaxed);
+	slot->mLength.store(pNames.size(),std::memory_order_relaxed);
+	slot->mHash.store(HashString(pNames),std::memory_order_relaxed);
+	EndWrite(slot,sequence);
+}
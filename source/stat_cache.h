@@ -0,0 +1,78 @@
+/**
+ * @file stat_cache.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __STAT_CACHE_H__
+#define __STAT_CACHE_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <string_view>
+#include <filesystem>
+
+// With --seabang-stat-cache the seabangs on a host share the stats and includes they find while checking dependencies, so
+// when dozens start at once the shared headers are only looked at by the first. It's a file in the temp folder, mapped
+// shared by all of them, there is no daemon. The file holds two lock free hash tables, each slot has a sequence number that
+// is odd while it's being written, a reader that sees it change while reading takes it as a miss. A writer that finds the
+// slot already being written does not wait, it's only a cache. The odd sequence is when the write started, so a slot left
+// odd by a writer that died is taken over by the next writer a second later.
+// A stat is used if it was taken in the last few hundred milliseconds, a header changed in that time may not be seen.
+// The includes of a file are keyed by it's device, inode, size and modification time, so are good till it changes.
+// They are the names as written, they are still looked for in the search paths by each seabang.
+// The names are kept in an arena that is only ever added to. When it's full the file is replaced by a new empty one,
+// those that have the old one mapped carry on with it.
+
+const int STAT_CACHE_DEFAULT_VALID_MS = 200;
+
+struct SharedStat
+{
+	bool mFound = false;	// False if there is no regular file at the path.
+	timespec mTime = {0,0};
+	uint64_t mDevice = 0;
+	uint64_t mInode = 0;
+	uint64_t mSize = 0;
+};
+
+class SharedStatCache
+{
+public:
+	SharedStatCache(const std::filesystem::path& pTempFolder,int pValidMS);
+	~SharedStatCache();
+
+	// Returns false if the cache could not be opened, it can still be used, it just never has anything.
+	bool IsOpen()const{return mMap != nullptr;}
+
+	// Returns false if no seabang has statted the path recently.
+	bool GetStat(std::string_view pPath,SharedStat& rStat);
+	void PutStat(std::string_view pPath,const SharedStat& pStat);
+
+	// The names the file includes, each followed by a nul. Returns false if they are not known for the file as it is now.
+	bool GetIncludes(const SharedStat& pFile,std::string& rNames);
+	void PutIncludes(const SharedStat& pFile,const std::string& pNames);
+
+private:
+	const std::filesystem::path mCacheFile;
+	const int64_t mValidNS;
+	uint8_t* mMap = nullptr;		// The layout is in stat_cache.cpp.
+
+	bool Map(int pFile);
+	void Replace();
+};
+
+#endif //#ifndef __STAT_CACHE_H__
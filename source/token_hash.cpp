@@ -0,0 +1,169 @@
+/**
+ * @file token_hash.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "token_hash.h"
+#include "source_scanner.h"
+#include "hash.h"
+
+// Past this the entries not used this time are dropped when saving, so files that have gone do not pile up.
+static const size_t MAX_CACHED_TOKEN_HASHES = 20000;
+
+// A file modified this recently could be modified again within the same tick of the clock without its stat changing, so is not kept.
+static const int64_t RECENTLY_MODIFIED_NS = 2000000000LL;
+
+// The name has the version of HashSourceTokens in it, so hashes made by an older one are not used.
+TokenHashCache::TokenHashCache(const std::filesystem::path& pTempFolder) :
+	mCacheFile(pTempFolder / ".seabang" / "token-hashes-2")
+{
+}
+
+void TokenHashCache::Load()
+{
+	mLoaded = true;
+
+	// hash device inode size modified path
+	std::ifstream file(mCacheFile);
+	std::string line;
+	while( std::getline(file,line) )
+	{
+		std::istringstream fields(line);
+		std::string hash;
+		Entry entry;
+		if( fields >> hash >> entry.mDevice >> entry.mInode >> entry.mSize >> entry.mModified && fields.get() == ' ' )
+		{
+			std::string path;
+			std::getline(fields,path);
+			entry.mHash = strtoull(hash.c_str(),nullptr,16);
+			mEntries[path] = entry;
+		}
+	}
+}
+
+bool TokenHashCache::GetHash(const std::filesystem::path& pFile,uint64_t& rHash)
+{
+	if( mLoaded == false )
+		Load();
+
+	struct stat Stats;
+	if( stat(pFile.c_str(),&Stats) != 0 )
+		return false;
+
+	const int64_t modified = (int64_t)Stats.st_mtim.tv_sec * 1000000000LL + Stats.st_mtim.tv_nsec;
+	Entry& entry = mEntries[pFile.string()];
+	entry.mUsed = true;
+	if( entry.mModified == modified && entry.mSize == (uint64_t)Stats.st_size && entry.mInode == (uint64_t)Stats.st_ino && entry.mDevice == (uint64_t)Stats.st_dev )
+	{
+		rHash = entry.mHash;
+		return true;
+	}
+
+	MappedFile source(pFile);
+	if( source.IsOpen() == false )
+	{
+		mEntries.erase(pFile.string());
+		return false;
+	}
+	rHash = HashSourceTokens(source.Data(),source.Size(),HASH_SEED);
+
+	timespec now;
+	clock_gettime(CLOCK_REALTIME,&now);
+	if( (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec - modified < RECENTLY_MODIFIED_NS )
+	{
+		mEntries.erase(pFile.string());
+		return true;
+	}
+
+	entry.mDevice = Stats.st_dev;
+	entry.mInode = Stats.st_ino;
+	entry.mSize = Stats.st_size;
+	entry.mModified = modified;
+	entry.mHash = rHash;
+	mChanged = true;
+	return true;
+}
+
+void TokenHashCache::Save()
+{
+	if( mChanged == false )
+		return;
+
+	// Written to the side and renamed into place, so a seabang loading it never sees half a file.
+	std::error_code ec;
+	std::filesystem::create_directories(mCacheFile.parent_path(),ec);
+	const std::filesystem::path tempFile = (std::filesystem::path(mCacheFile) += "." + std::to_string(getpid()));
+	{
+		std::ofstream file(tempFile,std::ios::trunc);
+		const bool onlyUsed = mEntries.size() > MAX_CACHED_TOKEN_HASHES;
+		for( const auto& [path,entry] : mEntries )
+		{
+			if( onlyUsed == false || entry.mUsed )
+			{
+				file << HashToString(entry.mHash) << " " << entry.mDevice << " " << entry.mInode << " " << entry.mSize << " " << entry.mModified << " " << path << "\n";
+			}
+		}
+		if( file.good() == false )
+		{
+			file.close();
+			std::filesystem::remove(tempFile,ec);
+			return;
+		}
+	}
+	std::filesystem::rename(tempFile,mCacheFile,ec);
+	mChanged = false;
+}
+
+std::filesystem::path GetTokenHashFilename(const std::filesystem::path& pExeName)
+{
+	return (std::filesystem::path(pExeName) += ".tokens");
+}
+
+bool ReadTokenHashes(const std::filesystem::path& pExeName,TokenHashes& rHashes)
+{
+	// hash path
+	std::ifstream file(GetTokenHashFilename(pExeName));
+	if( !file )
+		return false;
+
+	std::string line;
+	while( std::getline(file,line) )
+	{
+		if( line.size() < 18 || line[16] != ' ' )
+			return false;
+		rHashes.emplace_back(line.substr(17),strtoull(line.substr(0,16).c_str(),nullptr,16));
+	}
+	return rHashes.size() > 0;
+}
+
+bool WriteTokenHashes(const std::filesystem::path& pExeName,const TokenHashes& pHashes)
+{
+	std::ofstream file(GetTokenHashFilename(pExeName),std::ios::trunc);
+	for( const auto& [path,hash] : pHashes )
+	{
+		file << HashToString(hash) << " " << path << "\n";
+	}
+	return file.good();
+}
@@ -0,0 +1,72 @@
+/**
+ * @file token_hash.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TOKEN_HASH_H__
+#define __TOKEN_HASH_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+// For --seabang-ignore-cosmetic, files are compared by a hash of their tokens, see HashSourceTokens, and not by their dates.
+// Working the hash out means reading the whole file, so the hashes are kept in the temp folder keyed by the file's path and
+// stat signature, the device, inode, size and modification time. A file is only read again once one of those changes.
+
+class TokenHashCache
+{
+public:
+	TokenHashCache(const std::filesystem::path& pTempFolder);
+
+	// Returns false if the file could not be read.
+	bool GetHash(const std::filesystem::path& pFile,uint64_t& rHash);
+
+	// Writes the cache back, if any hashes were worked out. Another seabang saving at the same time may lose ours, it's only a cache.
+	void Save();
+
+private:
+	struct Entry
+	{
+		uint64_t mDevice = 0;
+		uint64_t mInode = 0;
+		uint64_t mSize = 0;
+		int64_t mModified = 0;
+		uint64_t mHash = 0;
+		bool mUsed = false;
+	};
+
+	const std::filesystem::path mCacheFile;
+	std::unordered_map<std::string,Entry> mEntries;
+	bool mLoaded = false;
+	bool mChanged = false;
+
+	void Load();
+};
+
+// The path and token hash of every file an exec was built from, the source first. Kept next to the exec as <exec>.tokens.
+typedef std::vector<std::pair<std::string,uint64_t>> TokenHashes;
+
+std::filesystem::path GetTokenHashFilename(const std::filesystem::path& pExeName);
+
+// Returns false if there is no record for the exec.
+bool ReadTokenHashes(const std::filesystem::path& pExeName,TokenHashes& rHashes);
+bool WriteTokenHashes(const std::filesystem::path& pExeName,const TokenHashes& pHashes);
+
+#endif //#ifndef __TOKEN_HASH_H__
@@ -0,0 +1,169 @@
+/**
+ * @file toolchain.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <map>
+
+#include "toolchain.h"
+#include "execute_command.h"
+#include "hash.h"
+
+std::string ToolchainFingerprint::ToString()const
+{
+	return mVersion + " | " + mRealPath.string() +
+			" inode=" + std::to_string(mInode) +
+			" mtime=" + std::to_string(mModifiedTime) +
+			" size=" + std::to_string(mSize) +
+			" version=" + mVersionHash;
+}
+
+/**
+ * @brief Finds the compiler the same way execvp will, if it has a / in it it's used as is, if not the PATH is searched.
+ */
+static bool ResolveCompiler(const std::string& pCompiler,std::filesystem::path& rResolvedPath)
+{
+	if( pCompiler.find('/') != std::string::npos )
+	{
+		rResolvedPath = std::filesystem::absolute(pCompiler);
+		return access(rResolvedPath.c_str(),X_OK) == 0;
+	}
+
+	const char* path = getenv("PATH");
+	std::string searchPath = path ? path : "/usr/local/bin:/usr/bin:/bin";
+	size_t start = 0;
+	while( start <= searchPath.size() )
+	{
+		size_t end = searchPath.find(':',start);
+		if( end == std::string::npos )
+			end = searchPath.size();
+
+		const std::string folder = searchPath.substr(start,end - start);
+		const std::filesystem::path candidate = std::filesystem::path(folder.empty() ? "." : folder) / pCompiler;
+		struct stat Stats;
+		if( stat(candidate.c_str(),&Stats) == 0 && S_ISREG(Stats.st_mode) && access(candidate.c_str(),X_OK) == 0 )
+		{
+			rResolvedPath = candidate;
+			return true;
+		}
+		start = end + 1;
+	}
+	return false;
+}
+
+static int64_t StatTime(const struct stat& pStats)
+{
+	return (int64_t)pStats.st_mtim.tv_sec * 1000000000LL + pStats.st_mtim.tv_nsec;
+}
+
+static bool ReadCachedFingerprint(const std::filesystem::path& pCacheFile,ToolchainFingerprint& rFingerprint)
+{
+	std::ifstream file(pCacheFile);
+	std::map<std::string,std::string> fields;
+	std::string line;
+	while( std::getline(file,line) )
+	{
+		const size_t equality = line.find('=');
+		if( equality != std::string::npos )
+			fields[line.substr(0,equality)] = line.substr(equality+1);
+	}
+
+	if( fields.size() != 7 )
+		return false;
+
+	try
+	{
+		rFingerprint.mResolvedPath = fields["resolved"];
+		rFingerprint.mRealPath = fields["real"];
+		rFingerprint.mInode = std::stoull(fields["inode"]);
+		rFingerprint.mModifiedTime = std::stoll(fields["mtime"]);
+		rFingerprint.mSize = std::stoull(fields["size"]);
+		rFingerprint.mVersion = fields["version"];
+		rFingerprint.mVersionHash = fields["version-hash"];
+	}
+	catch(...)
+	{
+		return false;
+	}
+	return true;
+}
+
+static void WriteCachedFingerprint(const std::filesystem::path& pCacheFile,const ToolchainFingerprint& pFingerprint)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(pCacheFile.parent_path(),ec);
+
+	// Written to the side and renamed so a seabang running at the same time never sees half of it.
+	const std::filesystem::path tempFile = (std::filesystem::path(pCacheFile) += "." + std::to_string(getpid()));
+	{
+		std::ofstream file(tempFile,std::ios::trunc);
+		file << "resolved=" << pFingerprint.mResolvedPath.string() << "\n";
+		file << "real=" << pFingerprint.mRealPath.string() << "\n";
+		file << "inode=" << pFingerprint.mInode << "\n";
+		file << "mtime=" << pFingerprint.mModifiedTime << "\n";
+		file << "size=" << pFingerprint.mSize << "\n";
+		file << "version=" << pFingerprint.mVersion << "\n";
+		file << "version-hash=" << pFingerprint.mVersionHash << "\n";
+		if( !file )
+			return;
+	}
+	std::filesystem::rename(tempFile,pCacheFile,ec);
+}
+
+bool GetToolchainFingerprint(const std::string& pCompiler,const std::filesystem::path& pTempFolder,ToolchainFingerprint& rFingerprint)
+{
+	// The PATH is part of the key as it changes which compiler is found.
+	const char* path = getenv("PATH");
+	const std::filesystem::path cacheFile = pTempFolder / ".seabang" / "toolchain" / HashToString(HashString(pCompiler + "\n" + (path ? path : "")));
+
+	// The hot path, one stat. stat follows links so if an alternatives link is switched the inode changes too.
+	struct stat Stats;
+	if( ReadCachedFingerprint(cacheFile,rFingerprint) &&
+		stat(rFingerprint.mResolvedPath.c_str(),&Stats) == 0 &&
+		(uint64_t)Stats.st_ino == rFingerprint.mInode &&
+		StatTime(Stats) == rFingerprint.mModifiedTime &&
+		(uint64_t)Stats.st_size == rFingerprint.mSize )
+	{
+		return true;
+	}
+
+	// Not seen it before, or it has changed.
+	rFingerprint = ToolchainFingerprint();
+	if( ResolveCompiler(pCompiler,rFingerprint.mResolvedPath) == false || stat(rFingerprint.mResolvedPath.c_str(),&Stats) != 0 )
+		return false;
+
+	std::error_code ec;
+	rFingerprint.mRealPath = std::filesystem::canonical(rFingerprint.mResolvedPath,ec);
+	rFingerprint.mInode = (uint64_t)Stats.st_ino;
+	rFingerprint.mModifiedTime = StatTime(Stats);
+	rFingerprint.mSize = (uint64_t)Stats.st_size;
+
+	std::string output;
+	if( ExecuteShellCommand(rFingerprint.mResolvedPath,{"--version"},output) == false )
+		return false;
+
+	rFingerprint.mVersion = output.substr(0,output.find('\n'));
+	rFingerprint.mVersionHash = HashToString(HashString(output));
+
+	WriteCachedFingerprint(cacheFile,rFingerprint);
+	return true;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file toolchain.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TOOLCHAIN_H__
+#define __TOOLCHAIN_H__
+
+#include <stdint.h>
+#include <string>
+#include <filesystem>
+
+// Identifies the compiler binary that will be run, so that when it is upgraded the execs it built are rebuilt.
+struct ToolchainFingerprint
+{
+	std::filesystem::path mResolvedPath;	// Where the compiler was found on the PATH, can be a symbolic link.
+	std::filesystem::path mRealPath;		// With all the links followed.
+	uint64_t mInode = 0;
+	int64_t mModifiedTime = 0;				// Nanoseconds.
+	uint64_t mSize = 0;
+	std::string mVersion;					// First line of --version.
+	std::string mVersionHash;				// Hash of all of the --version output.
+
+	// The fingerprint as one line, this is what goes into the build key.
+	std::string ToString()const;
+};
+
+// Finds the fingerprint of the compiler. The result is cached in the temporay folder, keyed on the compiler and PATH,
+// so normally this costs one stat of the compiler to see it has not changed.
+// Returns false if the compiler can not be found.
+bool GetToolchainFingerprint(const std::string& pCompiler,const std::filesystem::path& pTempFolder,ToolchainFingerprint& rFingerprint);
+
+#endif //#ifndef __TOOLCHAIN_H__
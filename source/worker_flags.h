@@ -0,0 +1,56 @@
+/**
+ * @file worker_flags.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __WORKER_FLAGS_H__
+#define __WORKER_FLAGS_H__
+
+#include <string>
+
+// The flags a compile worker is allowed to be sent. seabang uses it to decide what can go to a worker and
+// tools/seabang-compile-worker.cpp checks every request with it again, as anyone who can reach the worker can send one.
+// Inline as the worker is built from it's one file and this header, it does not link any of seabang.
+
+/**
+ * @brief The worker only takes flags that change the code made. Ones that name files, load code into the compiler or are for the
+ * CPU the compiler is running on are not allowed, the worker is not this host. The worker runs the compiler in an empty folder
+ * for the job, so a relative name left in a flag that is allowed can only be a file of that job.
+ */
+inline bool IsWorkerFlag(const std::string& pFlag)
+{
+	if( pFlag.find('/') != std::string::npos || pFlag.find("native") != std::string::npos )
+		return false;
+
+	// Ones that read or write a file they are given, or one next to the output.
+	for( const char* prefix : {"-fplugin","-fprofile","-fauto-profile","-ftest-coverage","-fdump","-fopt-info","-fsave-optimization-record",
+								"-fstack-usage","-fcallgraph-info","-fself-test","-fmodule","-fdiagnostics-format","-fcompare-debug",
+								"-fsanitize-blacklist","-fsanitize-ignorelist","-gsplit-dwarf","-Wa,","-Wp,"} )
+	{
+		if( pFlag.rfind(prefix,0) == 0 )
+			return false;
+	}
+
+	for( const char* prefix : {"-O","-g","-f","-m","-W","-w","-std=","-pedantic","-pthread","-ansi"} )
+	{
+		if( pFlag.rfind(prefix,0) == 0 )
+			return true;
+	}
+	return false;
+}
+
+#endif //#ifndef __WORKER_FLAGS_H__
@@ -0,0 +1,601 @@
+/**
+ * @file zygote.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <fstream>
+
+#include "zygote.h"
+#include "execute_command.h"
+#include "background_job.h"
+#include "hash.h"
+
+// Built as C, and kept to plain posix calls, so it does not care what the script was built with.
+static const char* ZYGOTE_RUNTIME_SOURCE = R"RUNTIME(
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define ZYGOTE_MAGIC 0x315a4253u
+#define MAX_PENDING 256
+#define MAX_REQUEST (16 * 1024 * 1024)
+
+extern int __seabang_script_main(int argc,char** argv,char** envp);
+
+struct Request
+{
+	uint32_t mMagic;
+	uint32_t mArgc;
+	uint32_t mEnvc;
+	uint32_t mSize;
+};
+
+struct Pending
+{
+	pid_t mPid;
+	int mClient;
+};
+
+static struct Pending gPending[MAX_PENDING];
+static int gNumPending = 0;
+static int gListen = -1;
+static int gSignals = -1;
+
+static int ReadAll(int fd,void* buffer,size_t size)
+{
+	char* p = (char*)buffer;
+	while( size > 0 )
+	{
+		const ssize_t n = read(fd,p,size);
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return 0;
+		p += n;
+		size -= (size_t)n;
+	}
+	return 1;
+}
+
+static void SendInt(int fd,int32_t value)
+{
+	const char* p = (const char*)&value;
+	size_t size = sizeof(value);
+	while( size > 0 )
+	{
+		const ssize_t n = write(fd,p,size);
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return;
+		p += n;
+		size -= (size_t)n;
+	}
+}
+
+static int ExeChanged(const char* exe,const struct stat* started)
+{
+	struct stat now;
+	if( stat(exe,&now) != 0 )
+		return 1;
+	return now.st_dev != started->st_dev || now.st_ino != started->st_ino ||
+			now.st_mtim.tv_sec != started->st_mtim.tv_sec || now.st_mtim.tv_nsec != started->st_mtim.tv_nsec;
+}
+
+static void StopListening(const char* socketPath,const struct stat* ours)
+{
+	if( gListen < 0 )
+		return;
+
+	/* Only remove the socket if it is still ours, a newer zygote may have replaced it. */
+	struct stat now;
+	if( stat(socketPath,&now) == 0 && now.st_dev == ours->st_dev && now.st_ino == ours->st_ino )
+		unlink(socketPath);
+	close(gListen);
+	gListen = -1;
+}
+
+/*
+	In the forked child, reads the request and takes on the caller's stdio, environment and working folder before running the script.
+	The request is read here and not in the zygote so a client that connects and then stalls only holds up its own run.
+*/
+static void RunScript(int client,const sigset_t* oldMask)
+{
+	close(gListen);
+	close(gSignals);
+	for( int n = 0 ; n < gNumPending ; n++ )
+		close(gPending[n].mClient);
+	sigprocmask(SIG_SETMASK,oldMask,NULL);
+
+	/* A client that stops talking is given up on. */
+	struct timeval timeout = {5,0};
+	setsockopt(client,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+
+	struct Request request;
+	char control[CMSG_SPACE(sizeof(int) * 3)];
+	struct iovec iov = {&request,sizeof(request)};
+	struct msghdr msg;
+	memset(&msg,0,sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	int fds[3] = {-1,-1,-1};
+	const ssize_t got = recvmsg(client,&msg,MSG_WAITALL|MSG_CMSG_CLOEXEC);
+	struct cmsghdr* cmsg = got > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+	if( cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(int) * 3) )
+		memcpy(fds,CMSG_DATA(cmsg),sizeof(fds));
+
+	char* blob = NULL;
+	int ok = got == (ssize_t)sizeof(request) && fds[2] >= 0 && request.mMagic == ZYGOTE_MAGIC && request.mSize <= MAX_REQUEST;
+	if( ok )
+	{
+		blob = malloc(request.mSize + 1);
+		ok = blob && ReadAll(client,blob,request.mSize);
+		if( ok )
+			blob[request.mSize] = 0;
+	}
+	close(client);
+
+	if( ok == 0 )
+	{
+		fprintf(stderr,"seabang zygote failed to read the request from a client\n");
+		_exit(127);
+	}
+
+	for( int n = 0 ; n < 3 ; n++ )
+		dup2(fds[n],n);
+	for( int n = 0 ; n < 3 ; n++ )
+		if( fds[n] > 2 )
+			close(fds[n]);
+
+	char* p = blob;
+	const char* cwd = p;
+	p += strlen(p) + 1;
+
+	char** argv = calloc(request.mArgc + 1,sizeof(char*));
+	for( uint32_t n = 0 ; n < request.mArgc ; n++ )
+	{
+		argv[n] = p;
+		p += strlen(p) + 1;
+	}
+
+	clearenv();
+	for( uint32_t n = 0 ; n < request.mEnvc ; n++ )
+	{
+		putenv(p);
+		p += strlen(p) + 1;
+	}
+
+	if( chdir(cwd) != 0 )
+	{
+		fprintf(stderr,"seabang zygote failed to change to %s: %s\n",cwd,strerror(errno));
+		_exit(127);
+	}
+	exit(__seabang_script_main((int)request.mArgc,argv,environ));
+}
+
+static void HandleConnection(const char* exe,const struct stat* exeStarted,const char* socketPath,const struct stat* socketStat,const sigset_t* oldMask)
+{
+	const int client = accept4(gListen,NULL,NULL,SOCK_CLOEXEC);
+	if( client < 0 )
+		return;
+
+	/* Refuse once the exec has been rebuilt, the client runs the new one itself. */
+	const int changed = ExeChanged(exe,exeStarted);
+	if( changed )
+		StopListening(socketPath,socketStat);
+
+	/* The child reads the request, nothing is read from the client here so it can not hold up the other runs. */
+	pid_t pid = -1;
+	if( changed == 0 && gNumPending < MAX_PENDING )
+	{
+		fflush(NULL);
+		pid = fork();
+		if( pid == 0 )
+			RunScript(client,oldMask);
+	}
+
+	if( pid <= 0 )
+	{
+		SendInt(client,0);
+		close(client);
+		return;
+	}
+
+	SendInt(client,(int32_t)pid);
+	gPending[gNumPending].mPid = pid;
+	gPending[gNumPending].mClient = client;
+	gNumPending++;
+}
+
+static void ReapChildren(void)
+{
+	int status;
+	pid_t pid;
+	while( (pid = waitpid(-1,&status,WNOHANG)) > 0 )
+	{
+		for( int n = 0 ; n < gNumPending ; n++ )
+		{
+			if( gPending[n].mPid == pid )
+			{
+				SendInt(gPending[n].mClient,(int32_t)status);
+				close(gPending[n].mClient);
+				gPending[n] = gPending[--gNumPending];
+				break;
+			}
+		}
+	}
+}
+
+static int Serve(const char* socketPath,const char* lockPath,const char* exe,int idleSeconds)
+{
+	/* Only one zygote per exec, if another has the lock let it do the work. */
+	const int lock = open(lockPath,O_RDWR|O_CREAT|O_CLOEXEC,0644);
+	if( lock < 0 || flock(lock,LOCK_EX|LOCK_NB) != 0 )
+		return 0;
+
+	struct stat exeStarted;
+	if( stat(exe,&exeStarted) != 0 )
+	{
+		fprintf(stderr,"seabang zygote failed to stat %s: %s\n",exe,strerror(errno));
+		return 1;
+	}
+
+	sigset_t mask,oldMask;
+	sigemptyset(&mask);
+	sigaddset(&mask,SIGCHLD);
+	sigaddset(&mask,SIGTERM);
+	sigaddset(&mask,SIGINT);
+	sigaddset(&mask,SIGHUP);
+	sigprocmask(SIG_BLOCK,&mask,&oldMask);
+	gSignals = signalfd(-1,&mask,SFD_CLOEXEC);
+
+	/* Bound to the side and renamed into place so clients never see a socket that is not listening yet. */
+	struct sockaddr_un address;
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	if( snprintf(address.sun_path,sizeof(address.sun_path),"%s.%d",socketPath,(int)getpid()) >= (int)sizeof(address.sun_path) )
+	{
+		fprintf(stderr,"seabang zygote socket path is too long %s\n",socketPath);
+		return 1;
+	}
+
+	gListen = socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+	unlink(address.sun_path);
+	if( gSignals < 0 || gListen < 0 || bind(gListen,(struct sockaddr*)&address,sizeof(address)) != 0 || listen(gListen,64) != 0 || rename(address.sun_path,socketPath) != 0 )
+	{
+		fprintf(stderr,"seabang zygote failed to listen on %s: %s\n",socketPath,strerror(errno));
+		unlink(address.sun_path);
+		return 1;
+	}
+
+	struct stat socketStat;
+	stat(socketPath,&socketStat);
+
+	while( gListen >= 0 || gNumPending > 0 )
+	{
+		struct pollfd fds[2] = {{gSignals,POLLIN,0},{gListen,POLLIN,0}};
+		const int timeout = (gNumPending == 0 && idleSeconds > 0) ? idleSeconds * 1000 : -1;
+		const int ready = poll(fds,2,timeout);
+		if( ready < 0 && errno == EINTR )
+			continue;
+
+		if( ready <= 0 )
+		{
+			StopListening(socketPath,&socketStat);
+			continue;
+		}
+
+		if( fds[0].revents & POLLIN )
+		{
+			struct signalfd_siginfo info;
+			if( read(gSignals,&info,sizeof(info)) == sizeof(info) )
+			{
+				if( info.ssi_signo == SIGCHLD )
+					ReapChildren();
+				else
+					StopListening(socketPath,&socketStat);
+			}
+		}
+
+		if( gListen >= 0 && (fds[1].revents & POLLIN) )
+			HandleConnection(exe,&exeStarted,socketPath,&socketStat,&oldMask);
+	}
+	return 0;
+}
+
+int main(int argc,char** argv,char** envp)
+{
+	const char* socketPath = getenv("SEABANG_ZYGOTE_SOCKET");
+	if( socketPath == NULL || socketPath[0] == 0 )
+		return __seabang_script_main(argc,argv,envp);
+
+	char* socketCopy = strdup(socketPath);
+	char* lock = strdup(getenv("SEABANG_ZYGOTE_LOCK") ? getenv("SEABANG_ZYGOTE_LOCK") : "");
+	const char* idle = getenv("SEABANG_ZYGOTE_IDLE");
+	const int idleSeconds = idle ? atoi(idle) : 0;
+	unsetenv("SEABANG_ZYGOTE_SOCKET");
+	unsetenv("SEABANG_ZYGOTE_LOCK");
+	unsetenv("SEABANG_ZYGOTE_IDLE");
+	return Serve(socketCopy,lock,argv[0],idleSeconds);
+}
+)RUNTIME";
+
+static std::filesystem::path GetZygoteLockFilename(const std::filesystem::path& pExeName)
+{
+	return (std::filesystem::path(pExeName) += ".zygote.lock");
+}
+
+static std::filesystem::path GetZygotePidFilename(const std::filesystem::path& pExeName)
+{
+	return (std::filesystem::path(pExeName) += ".zygote.pid");
+}
+
+bool BuildZygoteRuntime(const std::string& pCompiler,const std::filesystem::path& pTempFolder,std::filesystem::path& rRuntimeObject,std::string& rOutput)
+{
+	// Named by what it's built from, so it's only built once per compiler.
+	const std::string name = "runtime-" + HashToString(HashString(pCompiler + "\n" + ZYGOTE_RUNTIME_SOURCE));
+	const std::filesystem::path folder = pTempFolder / ".seabang" / "zygote";
+	rRuntimeObject = folder / (name + ".o");
+	if( std::filesystem::exists(rRuntimeObject) )
+		return true;
+
+	std::error_code ec;
+	std::filesystem::create_directories(folder,ec);
+
+	const std::string unique = "." + std::to_string(getpid());
+	const std::filesystem::path sourceFile = folder / (name + unique + ".c");
+	const std::filesystem::path objectFile = folder / (name + unique + ".o");
+	{
+		std::ofstream file(sourceFile,std::ios::trunc);
+		file << ZYGOTE_RUNTIME_SOURCE;
+	}
+
+	const bool builtOK = ExecuteShellCommand(pCompiler,{"-x","c","-O2","-c",sourceFile.string(),"-o",objectFile.string()},rOutput);
+	std::filesystem::remove(sourceFile,ec);
+	if( builtOK == false )
+	{
+		std::filesystem::remove(objectFile,ec);
+		return false;
+	}
+
+	std::filesystem::rename(objectFile,rRuntimeObject,ec);
+	return ec ? false : true;
+}
+
+bool RenameMainForZygote(const std::filesystem::path& pObjectFile,std::string& rOutput)
+{
+	return ExecuteShellCommand("objcopy",{"--redefine-sym","main=" ZYGOTE_SCRIPT_MAIN,pObjectFile.string()},rOutput);
+}
+
+std::filesystem::path GetZygoteSocketFilename(const std::filesystem::path& pTempFolder,const std::filesystem::path& pExeName)
+{
+	return pTempFolder / ".seabang" / "zygote" / (HashToString(HashString(pExeName.string())) + ".sock");
+}
+
+bool StartZygote(const std::filesystem::path& pSocketFile,const std::filesystem::path& pExeName,int pIdleSeconds)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(pSocketFile.parent_path(),ec);
+
+	const std::filesystem::path lockFile = GetZygoteLockFilename(pExeName);
+	const std::filesystem::path logFile = (std::filesystem::path(pExeName) += ".zygote.log");
+	const std::filesystem::path pidFile = GetZygotePidFilename(pExeName);
+
+	// The job process becomes the zygote, so it's pid is the one to stop. The zygote takes the lock again after the exec.
+	return StartBackgroundJob(lockFile,logFile,[&]()
+	{
+		{
+			std::ofstream file(pidFile,std::ios::trunc);
+			file << getpid() << "\n";
+		}
+
+		setenv("SEABANG_ZYGOTE_SOCKET",pSocketFile.c_str(),1);
+		setenv("SEABANG_ZYGOTE_LOCK",lockFile.c_str(),1);
+		setenv("SEABANG_ZYGOTE_IDLE",std::to_string(pIdleSeconds).c_str(),1);
+
+		const std::string exeName = pExeName.string();
+		char* const args[] = {(char*)exeName.c_str(),nullptr};
+		execv(args[0],args);
+		std::cerr << "Failed to start zygote " << pExeName << " " << strerror(errno) << "\n";
+	});
+}
+
+void StopZygote(const std::filesystem::path& pExeName)
+{
+	const std::filesystem::path pidFile = GetZygotePidFilename(pExeName);
+	std::ifstream file(pidFile);
+	pid_t pid = 0;
+	if( !(file >> pid) || pid <= 0 )
+		return;
+
+	// Only trust the pid while the lock is held, if it's not the zygote has gone and the pid could be anyone.
+	if( IsBackgroundJobRunning(GetZygoteLockFilename(pExeName)) )
+	{
+		kill(pid,SIGTERM);
+	}
+
+	std::error_code ec;
+	std::filesystem::remove(pidFile,ec);
+}
+
+static volatile sig_atomic_t gZygoteRunPid = 0;
+
+static void ForwardSignal(int pSignal)
+{
+	if( gZygoteRunPid > 0 )
+		kill(gZygoteRunPid,pSignal);
+}
+
+static bool ReadInt(int pSocket,int32_t& rValue)
+{
+	char* p = (char*)&rValue;
+	size_t size = sizeof(rValue);
+	while( size > 0 )
+	{
+		const ssize_t n = read(pSocket,p,size);
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return false;
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+static bool WriteAll(int pSocket,const std::string& pData)
+{
+	const char* p = pData.data();
+	size_t size = pData.size();
+	while( size > 0 )
+	{
+		const ssize_t n = write(pSocket,p,size);
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return false;
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+bool RunInZygote(const std::filesystem::path& pSocketFile,const std::filesystem::path& pExeName,const std::vector<std::string>& pArgs,int& rExitCode)
+{
+	sockaddr_un address;
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	if( pSocketFile.string().size() >= sizeof(address.sun_path) )
+		return false;
+	strcpy(address.sun_path,pSocketFile.c_str());
+
+	const int zygote = socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+	if( zygote < 0 )
+		return false;
+
+	if( connect(zygote,(sockaddr*)&address,sizeof(address)) != 0 )
+	{
+		close(zygote);
+		return false;
+	}
+
+	std::string blob;
+	blob += std::filesystem::current_path().string() + '\0';
+	blob += pExeName.string() + '\0';
+	for( const std::string& arg : pArgs )
+		blob += arg + '\0';
+
+	uint32_t envc = 0;
+	for( char** env = environ ; *env ; env++ )
+	{
+		blob += std::string(*env) + '\0';
+		envc++;
+	}
+
+	ZygoteRequest request;
+	request.mMagic = ZYGOTE_MAGIC;
+	request.mArgc = (uint32_t)pArgs.size() + 1;
+	request.mEnvc = envc;
+	request.mSize = (uint32_t)blob.size();
+
+	// Our stdio goes with the header so the run reads and writes where we would have.
+	const int fds[3] = {STDIN_FILENO,STDOUT_FILENO,STDERR_FILENO};
+	char control[CMSG_SPACE(sizeof(fds))];
+	memset(control,0,sizeof(control));
+	iovec iov = {&request,sizeof(request)};
+	msghdr msg;
+	memset(&msg,0,sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg),fds,sizeof(fds));
+
+	// Anything we have buffered has to come out before the run's output.
+	std::cout << std::flush;
+	std::clog << std::flush;
+
+	int32_t pid = 0;
+	if( sendmsg(zygote,&msg,MSG_NOSIGNAL) != (ssize_t)sizeof(request) || WriteAll(zygote,blob) == false || ReadInt(zygote,pid) == false || pid <= 0 )
+	{
+		close(zygote);
+		return false;
+	}
+
+	// From here the run has started, so can not fall back. Pass on the signals a user, or a parent, would send to it.
+	gZygoteRunPid = pid;
+	struct sigaction forward;
+	memset(&forward,0,sizeof(forward));
+	forward.sa_handler = ForwardSignal;
+	sigemptyset(&forward.sa_mask);
+	for( int sig : {SIGINT,SIGTERM,SIGHUP,SIGQUIT} )
+		sigaction(sig,&forward,nullptr);
+
+	int32_t status = 0;
+	const bool finished = ReadInt(zygote,status);
+	close(zygote);
+	gZygoteRunPid = 0;
+
+	if( finished == false )
+	{
+		std::cerr << "Lost contact with the zygote for " << pExeName << "\n";
+		rExitCode = EXIT_FAILURE;
+	}
+	else if( WIFEXITED(status) )
+	{
+		rExitCode = WEXITSTATUS(status);
+	}
+	else if( WIFSIGNALED(status) )
+	{
+		rExitCode = 128 + WTERMSIG(status);// The same as the shell does.
+	}
+	else
+	{
+		rExitCode = EXIT_FAILURE;
+	}
+	return true;
+}
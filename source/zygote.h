@@ -0,0 +1,73 @@
+/**
+ * @file zygote.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __ZYGOTE_H__
+#define __ZYGOTE_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// A zygote exec has the script's main renamed and a small runtime linked in that provides the real main.
+// Run normally the runtime just calls the script's main. Run with SEABANG_ZYGOTE_SOCKET set it does all the loading
+// and static initialisation once and then waits on that unix socket. Each request forks it, the child gets the
+// caller's args, environment, working folder and stdio and runs the script's main, the exit status is sent back.
+// The zygote stops taking requests when its exec is replaced, so a rebuild invalidates it, or after being idle for a while.
+
+// The request starts with this header, the fds for stdin, stdout and stderr are sent with it.
+// Then comes the working folder, the args and the environment as nul terminated strings.
+// The zygote replies with the pid of the run, zero if it will not do it, then the wait status when it's finished.
+// The module host, see module_host.h, takes the same requests.
+const uint32_t ZYGOTE_MAGIC = 0x315a4253;	// SBZ1
+
+struct ZygoteRequest
+{
+	uint32_t mMagic;
+	uint32_t mArgc;
+	uint32_t mEnvc;
+	uint32_t mSize;
+};
+
+// The symbol the script's main is renamed to.
+#define ZYGOTE_SCRIPT_MAIN "__seabang_script_main"
+
+// How long a zygote waits for a request before exiting, in seconds.
+const int ZYGOTE_DEFAULT_IDLE_SECONDS = 300;
+
+// Compiles the runtime, as C, into an object that is shared by all zygote execs built with the same compiler.
+bool BuildZygoteRuntime(const std::string& pCompiler,const std::filesystem::path& pTempFolder,std::filesystem::path& rRuntimeObject,std::string& rOutput);
+
+// Renames main in the script's object file so the runtime's main can be linked in its place.
+bool RenameMainForZygote(const std::filesystem::path& pObjectFile,std::string& rOutput);
+
+// The unix socket a zygote for the exec listens on. Kept short, and out of the project folders, as socket paths have a small size limit.
+std::filesystem::path GetZygoteSocketFilename(const std::filesystem::path& pTempFolder,const std::filesystem::path& pExeName);
+
+// Starts a zygote for the exec in the background, does nothing if one is already running.
+bool StartZygote(const std::filesystem::path& pSocketFile,const std::filesystem::path& pExeName,int pIdleSeconds);
+
+// Stops the zygote for the exec if it is running, it finishes the runs it has started first.
+void StopZygote(const std::filesystem::path& pExeName);
+
+// Runs the exec in its zygote, signals sent to us are passed on to the run.
+// Returns false if there is no zygote, or it would not take the run, so the caller can run the exec the normal way.
+bool RunInZygote(const std::filesystem::path& pSocketFile,const std::filesystem::path& pExeName,const std::vector<std::string>& pArgs,int& rExitCode);
+
+#endif //#ifndef __ZYGOTE_H__
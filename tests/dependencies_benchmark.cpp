@@ -0,0 +1,121 @@
+/**
+ * @file dependencies_benchmark.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// Times the dependency graph on a generated tree, 100k headers by default, each including three others so there are
+// plenty of include cycles. Not run by ctest, run it by hand after changing dependencies.cpp.
+// Usage: dependencies_benchmark [header count]
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <filesystem>
+
+#include "dependencies.h"
+
+static void SetFileTime(const std::filesystem::path& pFile,time_t pTime)
+{
+	const timespec times[2] = {{pTime,0},{pTime,0}};
+	utimensat(AT_FDCWD,pFile.c_str(),times,0);
+}
+
+static std::string HeaderName(int pHeader)
+{
+	return "h" + std::to_string(pHeader) + ".h";
+}
+
+/**
+ * @brief Runs the function and returns how long it took in milliseconds.
+ */
+template<typename FUNCTION> static double TimeMS(FUNCTION pFunction)
+{
+	const auto start = std::chrono::steady_clock::now();
+	pFunction();
+	return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc,char *argv[])
+{
+	const int headerCount = argc > 1 ? atoi(argv[1]) : 100000;
+	if( headerCount < 1 )
+	{
+		std::cerr << "Usage: dependencies_benchmark [header count]\n";
+		return EXIT_FAILURE;
+	}
+
+	char folderTemplate[] = "/tmp/seabang-dependencies-benchmark-XXXXXX";
+	if( mkdtemp(folderTemplate) == nullptr )
+	{
+		std::cerr << "Failed to make the temp folder for the benchmark\n";
+		return EXIT_FAILURE;
+	}
+	const std::filesystem::path folder = folderTemplate;
+	const std::filesystem::path source = folder / "main.cpp";
+	const std::filesystem::path exec = folder / "main.exe";
+
+	// Header n includes n / 2, which links them all to h0, and two spread out ones that make cycles.
+	const double generateMS = TimeMS([&]()
+	{
+		for( int n = 0 ; n < headerCount ; n++ )
+		{
+			const std::filesystem::path header = folder / HeaderName(n);
+			std::ofstream(header) << "#include \"" << HeaderName(n / 2) << "\"\n"
+								  << "#include <vector>\n"
+								  << "#include \"" << HeaderName((int)(((int64_t)n * 7 + 1) % headerCount)) << "\"\n"
+								  << "// A comment with #include \"not_this.h\" in it.\n"
+								  << "#include \"" << HeaderName((int)(((int64_t)n * 13 + 5) % headerCount)) << "\"\n";
+			SetFileTime(header,1000);
+		}
+		std::ofstream(source) << "#include \"h0.h\"\nint main(){}\n";
+		SetFileTime(source,1000);
+		std::ofstream(exec) << "";
+		SetFileTime(exec,2000);
+	});
+	std::cout << "Generated " << headerCount << " headers in " << generateMS << "ms\n";
+
+	const Dependencies::PathVec includePaths = {folder};
+	Dependencies::PathVec found;
+	{
+		Dependencies dependencies;
+		const double ms = TimeMS([&](){dependencies.GetDependencies(source,includePaths,found);});
+		std::cout << "GetDependencies, cold, found " << found.size() << " in " << ms << "ms\n";
+	}
+
+	Dependencies dependencies;
+	bool rebuild = false;
+	const double coldMS = TimeMS([&](){rebuild = dependencies.RequiresRebuild(source,exec,includePaths);});
+	std::cout << "RequiresRebuild, cold, " << (rebuild ? "rebuild" : "up to date") << " in " << coldMS << "ms\n";
+
+	const int WARM_RUNS = 10;
+	const double warmMS = TimeMS([&]()
+	{
+		for( int n = 0 ; n < WARM_RUNS ; n++ )
+			rebuild = dependencies.RequiresRebuild(source,exec,includePaths);
+	});
+	std::cout << "RequiresRebuild, warm, " << (rebuild ? "rebuild" : "up to date") << " in " << warmMS / WARM_RUNS << "ms a check\n";
+
+	const double foundMS = TimeMS([&](){dependencies.GetDependencies(source,includePaths,found);});
+	std::cout << "GetDependencies, warm, found " << found.size() << " in " << foundMS << "ms\n";
+
+	std::filesystem::remove_all(folder);
+	return EXIT_SUCCESS;
+}
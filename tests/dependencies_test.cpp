@@ -0,0 +1,209 @@
+/**
+ * @file dependencies_test.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// Checks the dependency graph on trees written to a temp folder, include cycles, a path table that grows part way through
+// a scan, walk epochs that wrap and includes shared through the stat cache. Returns non zero if any check fails.
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "dependencies.h"
+#include "stat_cache.h"
+
+static int gFailures = 0;
+#define CHECK(__TEST) {if( !(__TEST) ){std::cerr << __FILE__ << ":" << __LINE__ << " failed, " << #__TEST << "\n"; gFailures++;}}
+
+/**
+ * @brief Can see the walk's epoch and visited marks, which are private to Dependencies.
+ */
+class DependenciesTest
+{
+public:
+	// Sets the epoch of the last walk and marks every file as visited in the given epoch.
+	static void SetEpoch(Dependencies& pDependencies,uint32_t pEpoch,uint32_t pVisited)
+	{
+		pDependencies.mEpoch = pEpoch;
+		for( Dependencies::FileNode& node : pDependencies.mFiles )
+			node.mVisited = pVisited;
+	}
+
+	static size_t GetFileCount(const Dependencies& pDependencies){return pDependencies.mFiles.size();}
+};
+
+static void SetFileTime(const std::filesystem::path& pFile,time_t pTime)
+{
+	const timespec times[2] = {{pTime,0},{pTime,0}};
+	utimensat(AT_FDCWD,pFile.c_str(),times,0);
+}
+
+static void WriteFile(const std::filesystem::path& pFile,const std::string& pContent,time_t pTime)
+{
+	std::ofstream(pFile) << pContent;
+	SetFileTime(pFile,pTime);
+}
+
+/**
+ * @brief a.h and b.h include each other and c.h includes itself, each file is only seen once and the chain to a trigger is right.
+ */
+static void TestIncludeCycles(const std::filesystem::path& pFolder)
+{
+	const std::filesystem::path folder = pFolder / "cycles";
+	std::filesystem::create_directories(folder);
+	WriteFile(folder / "main.cpp","#include \"a.h\"\nint main(){}\n",1000);
+	WriteFile(folder / "a.h","#include \"b.h\"\n",1000);
+	WriteFile(folder / "b.h","#include \"a.h\"\n#include \"c.h\"\n",1000);
+	WriteFile(folder / "c.h","#include \"c.h\"\n",1000);
+	WriteFile(folder / "main.exe","",2000);
+
+	const Dependencies::PathVec includePaths = {folder};
+	Dependencies::PathVec found;
+	Dependencies dependencies;
+	dependencies.GetDependencies(folder / "main.cpp",includePaths,found);
+	CHECK( found == Dependencies::PathVec({folder / "a.h",folder / "b.h",folder / "c.h"}) );
+	CHECK( dependencies.RequiresRebuild(folder / "main.cpp",folder / "main.exe",includePaths) == false );
+
+	// Stats are kept by the object, so a new one is needed to see the change.
+	SetFileTime(folder / "c.h",3000);
+	Dependencies changed;
+	CHECK( changed.RequiresRebuild(folder / "main.cpp",folder / "main.exe",includePaths) );
+	CHECK( changed.GetRebuildTrigger() == folder / "c.h" );
+	Dependencies::PathVec chain;
+	changed.GetRebuildChain(chain);
+	CHECK( chain == Dependencies::PathVec({folder / "main.cpp",folder / "a.h",folder / "b.h",folder / "c.h"}) );
+	SetFileTime(folder / "c.h",1000);
+}
+
+/**
+ * @brief main.cpp includes thousands of headers, so the path table grows while it is being scanned.
+ * The headers are in an include folder that is searched after one they are not in, so missing paths are interned too.
+ */
+static void TestPathTableGrowth(const std::filesystem::path& pFolder,SharedStatCache* pSharedCache)
+{
+	const int HEADER_COUNT = 3000;
+	const std::filesystem::path folder = pFolder / "growth";
+	const std::filesystem::path includeFolder = folder / "include";
+	std::filesystem::create_directories(includeFolder);
+
+	std::string main;
+	Dependencies::PathVec expected;
+	for( int n = 0 ; n < HEADER_COUNT ; n++ )
+	{
+		const std::string name = "h" + std::to_string(n) + ".h";
+		main += "#include \"" + name + "\"\n";
+		WriteFile(includeFolder / name,"#include \"h" + std::to_string((n + 1) % HEADER_COUNT) + ".h\"\n#include \"missing" + std::to_string(n) + ".h\"\n",1000);
+		expected.push_back(includeFolder / name);
+	}
+	std::sort(expected.begin(),expected.end());
+	WriteFile(folder / "main.cpp",main + "int main(){}\n",1000);
+	WriteFile(folder / "main.exe","",2000);
+
+	const Dependencies::PathVec includePaths = {folder,includeFolder};
+	Dependencies dependencies;
+	dependencies.SetSharedCache(pSharedCache);
+	Dependencies::PathVec found;
+	dependencies.GetDependencies(folder / "main.cpp",includePaths,found);
+	CHECK( found == expected );
+	CHECK( DependenciesTest::GetFileCount(dependencies) > (size_t)HEADER_COUNT * 2 );
+
+	// Warm checks on the same object, everything is already interned and scanned.
+	CHECK( dependencies.RequiresRebuild(folder / "main.cpp",folder / "main.exe",includePaths) == false );
+	CHECK( dependencies.RequiresRebuild(folder / "main.cpp",folder / "main.exe",includePaths) == false );
+
+	SetFileTime(includeFolder / "h2999.h",3000);
+	Dependencies changed;
+	changed.SetSharedCache(pSharedCache);
+	CHECK( changed.RequiresRebuild(folder / "main.cpp",folder / "main.exe",includePaths) );
+	CHECK( changed.GetRebuildTrigger() == includeFolder / "h2999.h" );
+
+	// A header that can not be found is not a dependency, the compiler will say it's missing.
+	std::filesystem::remove(includeFolder / "h1500.h");
+	expected.erase(std::find(expected.begin(),expected.end(),includeFolder / "h1500.h"));
+	Dependencies missing;
+	missing.SetSharedCache(pSharedCache);
+	missing.GetDependencies(folder / "main.cpp",includePaths,found);
+	CHECK( found == expected );
+}
+
+/**
+ * @brief Every file is marked as visited in epoch 1 and the last walk as UINT32_MAX, the next walk wraps to epoch 1.
+ * Unless the marks are cleared when it wraps that walk would think it had already seen every file.
+ */
+static void TestEpochWrap(const std::filesystem::path& pFolder)
+{
+	const std::filesystem::path folder = pFolder / "cycles";
+	const Dependencies::PathVec includePaths = {folder};
+	const Dependencies::PathVec expected = {folder / "a.h",folder / "b.h",folder / "c.h"};
+
+	Dependencies dependencies;
+	Dependencies::PathVec found;
+	dependencies.GetDependencies(folder / "main.cpp",includePaths,found);
+	CHECK( found == expected );
+
+	DependenciesTest::SetEpoch(dependencies,UINT32_MAX,1);
+	for( int walk = 0 ; walk < 4 ; walk++ )
+	{
+		dependencies.GetDependencies(folder / "main.cpp",includePaths,found);
+		CHECK( found == expected );
+	}
+
+	// The same for a check, only the walk into the includes can find c.h is newer.
+	SetFileTime(folder / "c.h",3000);
+	Dependencies changed;
+	changed.GetDependencies(folder / "main.cpp",includePaths,found);
+	DependenciesTest::SetEpoch(changed,UINT32_MAX,1);
+	CHECK( changed.RequiresRebuild(folder / "main.cpp",folder / "main.exe",includePaths) );
+	CHECK( changed.GetRebuildTrigger() == folder / "c.h" );
+}
+
+int main()
+{
+	char folderTemplate[] = "/tmp/seabang-dependencies-test-XXXXXX";
+	if( mkdtemp(folderTemplate) == nullptr )
+	{
+		std::cerr << "Failed to make the temp folder for the test\n";
+		return EXIT_FAILURE;
+	}
+	const std::filesystem::path folder = folderTemplate;
+
+	TestIncludeCycles(folder);
+	TestPathTableGrowth(folder,nullptr);
+	TestEpochWrap(folder);
+
+	// Again with the includes of each header coming from the cache the first walk put them in.
+	// Stats are never valid for long enough to be used, so the changes the test makes are seen.
+	std::filesystem::remove_all(folder / "growth");
+	SharedStatCache sharedCache(folder / "cache",0);
+	TestPathTableGrowth(folder,&sharedCache);
+
+	std::filesystem::remove_all(folder);
+	if( gFailures > 0 )
+	{
+		std::cerr << gFailures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "PASS\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file guarded_buffer.h
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __GUARDED_BUFFER_H__
+#define __GUARDED_BUFFER_H__
+
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <string>
+
+// A copy of some bytes that ends right where a page that can not be read starts, so the tests crash on any read past the end.
+// Reads past the end of a std::string or vector would go unseen, there is always more of the heap after them.
+class GuardedBuffer
+{
+public:
+	GuardedBuffer(const std::string& pBytes)
+	{
+		const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		mMappedSize = ((pBytes.size() + page - 1) / page + 1) * page;
+		mMapped = (char*)mmap(nullptr,mMappedSize,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+		if( mMapped == MAP_FAILED )
+		{
+			mMapped = nullptr;
+			return;
+		}
+		mprotect(mMapped + mMappedSize - page,page,PROT_NONE);
+		mData = mMapped + mMappedSize - page - pBytes.size();
+		memcpy(mData,pBytes.data(),pBytes.size());
+		mSize = pBytes.size();
+	}
+
+	~GuardedBuffer()
+	{
+		if( mMapped )
+			munmap(mMapped,mMappedSize);
+	}
+
+	GuardedBuffer(const GuardedBuffer&) = delete;
+	GuardedBuffer& operator=(const GuardedBuffer&) = delete;
+
+	const char* Data()const{return mData;}
+	char* Data(){return mData;}
+	size_t Size()const{return mSize;}
+
+private:
+	char* mMapped = nullptr;
+	size_t mMappedSize = 0;
+	char* mData = nullptr;
+	size_t mSize = 0;
+};
+
+#endif //#ifndef __GUARDED_BUFFER_H__
@@ -0,0 +1,188 @@
+/**
+ * @file lz_compress_test.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// Round trips for the codec the cold cache tier stores execs with, and streams that are cut off or corrupt, which must be
+// refused without reading past the end of them. Returns non zero if any check fails.
+
+#include <stdlib.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lz_compress.h"
+#include "guarded_buffer.h"
+
+static int gFailures = 0;
+#define CHECK(__TEST) {if( !(__TEST) ){std::cerr << __FILE__ << ":" << __LINE__ << " failed, " << #__TEST << "\n"; gFailures++;}}
+
+// The same bytes every run, so a failure can be run again.
+static uint64_t gRandom = 0x9e3779b97f4a7c15ULL;
+static uint8_t RandomByte()
+{
+	gRandom ^= gRandom << 13;
+	gRandom ^= gRandom >> 7;
+	gRandom ^= gRandom << 17;
+	return (uint8_t)(gRandom >> 24);
+}
+
+static std::string RandomBytes(size_t pSize)
+{
+	std::string bytes(pSize,0);
+	for( char& c : bytes )
+		c = (char)RandomByte();
+	return bytes;
+}
+
+static std::string Repeat(const std::string& pPattern,size_t pSize)
+{
+	std::string bytes;
+	while( bytes.size() < pSize )
+		bytes += pPattern;
+	bytes.resize(pSize);
+	return bytes;
+}
+
+/**
+ * @brief Decompresses from a buffer that ends at a page that can't be read, so a read past the end crashes the test.
+ */
+static bool Decompress(const std::string& pStored,size_t pDecompressedSize,std::string& rOutput)
+{
+	const GuardedBuffer stored(pStored);
+	std::vector<uint8_t> output;
+	const bool worked = LZDecompress(stored.Data(),stored.Size(),pDecompressedSize,output);
+	rOutput.assign(output.begin(),output.end());
+	return worked;
+}
+
+static std::string Compress(const std::string& pData)
+{
+	const GuardedBuffer data(pData);
+	const std::vector<uint8_t> compressed = LZCompress(data.Data(),data.Size());
+	return std::string(compressed.begin(),compressed.end());
+}
+
+/**
+ * @brief Compresses and decompresses the data, then checks the stream is refused when it's cut short, has a byte changed
+ * or is said to be the wrong size. A cut or change that still makes exactly the data is fine, only a wrong answer is not.
+ */
+static void TestRoundTrip(const std::string& pName,const std::string& pData,size_t pMaxStoredSize)
+{
+	const std::string stored = Compress(pData);
+	std::string output;
+	if( Decompress(stored,pData.size(),output) == false || output != pData )
+	{
+		std::cerr << pName << " did not round trip\n";
+		gFailures++;
+		return;
+	}
+
+	if( stored.size() > pMaxStoredSize )
+	{
+		std::cerr << pName << " compressed to " << stored.size() << " bytes, expected no more than " << pMaxStoredSize << "\n";
+		gFailures++;
+	}
+
+	CHECK( Decompress(stored,pData.size() + 1,output) == false );
+	if( pData.size() > 0 )
+		CHECK( Decompress(stored,pData.size() - 1,output) == false );
+
+	// Every cut for small streams, a spread of them for big ones.
+	const size_t cutStep = stored.size() < 4096 ? 1 : stored.size() / 1024;
+	for( size_t cut = 0 ; cut < stored.size() ; cut += cutStep )
+	{
+		if( Decompress(stored.substr(0,cut),pData.size(),output) && output != pData )
+		{
+			std::cerr << pName << " cut to " << cut << " bytes decompressed to the wrong data\n";
+			gFailures++;
+		}
+	}
+
+	const size_t changeStep = stored.size() < 1024 ? 1 : stored.size() / 256;
+	for( size_t at = 0 ; at < stored.size() ; at += changeStep )
+	{
+		for( const uint8_t bits : {0x01,0x10,0x80,0xff} )
+		{
+			std::string corrupt = stored;
+			corrupt[at] ^= bits;
+			// Can't be expected to be refused, a change to a literal still decodes, but it must not crash.
+			Decompress(corrupt,pData.size(),output);
+			CHECK( output.size() == pData.size() );
+		}
+	}
+}
+
+/**
+ * @brief Streams that were never compressed, made to look like they could be, none of them should be read past the end of.
+ */
+static void TestGarbage()
+{
+	std::string output;
+	CHECK( Decompress("",0,output) );
+	CHECK( Decompress("",1,output) == false );
+	CHECK( Decompress(std::string(1,'\xf0'),0,output) == false );			// Literals to come, then the end.
+	CHECK( Decompress(std::string("\xf0\xff",2),1000,output) == false );		// A length that is still going at the end.
+	CHECK( Decompress(std::string("\x10" "a" "\x00\x00",4),5,output) == false );// A match with an offset of zero.
+	CHECK( Decompress(std::string("\x10" "a" "\x02\x00",4),5,output) == false );// A match from before the start.
+	CHECK( Decompress(std::string("\x10" "a" "\x01",3),5,output) == false );	// The offset cut off.
+	CHECK( Decompress(std::string("\x1f" "a" "\x01\x00\xff",5),400,output) == false );// The match length cut off.
+	CHECK( Decompress(std::string("\x10" "a" "\x01\x00",4),5,output) && output == "aaaaa" );	// A run, from one byte.
+	CHECK( Decompress(std::string("\x10" "a" "\x01\x00",4),4,output) == false );// More than it should make.
+
+	for( int n = 0 ; n < 2000 ; n++ )
+	{
+		const std::string garbage = RandomBytes(RandomByte() % 64);
+		Decompress(garbage,RandomByte() * 4,output);
+	}
+}
+
+int main()
+{
+	TestGarbage();
+
+	TestRoundTrip("empty","",1);
+	TestRoundTrip("one byte","x",2);
+	TestRoundTrip("shorter than a match","abc",4);
+	TestRoundTrip("one match","abcdabcd",9);
+	TestRoundTrip("fourteen literals",RandomBytes(14),15);
+	TestRoundTrip("fifteen literals",RandomBytes(15),17);
+	TestRoundTrip("literal length over 255",RandomBytes(15 + 255),15 + 255 + 3);
+	TestRoundTrip("incompressible",RandomBytes(256 * 1024),256 * 1024 + 256 * 1024 / 255 + 16);
+	TestRoundTrip("a run of one byte",std::string(1024 * 1024,'\0'),1024 * 1024 / 255 + 16);
+	TestRoundTrip("a long match",Repeat(RandomBytes(1000),200 * 1000),1000 + 200 * 1000 / 255 + 64);
+	// Far matches in random data are seldom found, it steps through long runs of literals quickly, so only the round trip counts.
+	TestRoundTrip("matches as far back as they can be",Repeat(RandomBytes(65535),65535 * 3),65535 * 3 + 65535 * 3 / 255 + 16);
+	TestRoundTrip("repeats one past the furthest match",Repeat(RandomBytes(65536),65536 * 2),65536 * 2 + 65536 * 2 / 255 + 16);
+	TestRoundTrip("matches that end at the end",RandomBytes(100) + std::string(100,'z'),100 + 16);
+
+	// Something like what it is for, this test's own exec.
+	std::ifstream self("/proc/self/exe",std::ios::binary);
+	std::stringstream exec;
+	exec << self.rdbuf();
+	TestRoundTrip("an exec",exec.str(),exec.str().size());
+
+	if( gFailures > 0 )
+	{
+		std::cerr << gFailures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "PASS\n";
+	return EXIT_SUCCESS;
+}
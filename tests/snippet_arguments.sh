@@ -0,0 +1,44 @@
+#!/bin/sh
+# A -e or - after the script is for the script, only one before it, or in place of it, is a snippet.
+# Usage: snippet_arguments.sh <path to seabang>
+
+SEABANG="$1"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir -p "$WORK/cache"
+export SEABANG_TEMPORARY_FOLDER="$WORK/cache"
+
+fail()
+{
+    echo "FAIL: $1"
+    exit 1
+}
+
+write_script()
+{
+    cat > "$WORK/$1" <<SCRIPT
+#!$SEABANG $2
+#include <iostream>
+int main(int argc,char *argv[])
+{
+    for( int n = 1 ; n < argc ; n++ )
+        std::cout << argv[n] << "\n";
+    return 0;
+}
+SCRIPT
+    chmod +x "$WORK/$1"
+}
+
+cd "$WORK" || fail "no work folder"
+
+write_script args.cpp ""
+[ "$(./args.cpp -e x | tr '\n' ' ')" = "-e x " ] || fail "./args.cpp -e x did not pass -e x to the script"
+[ "$(./args.cpp - < /dev/null | tr '\n' ' ')" = "- " ] || fail "./args.cpp - did not pass - to the script"
+
+write_script options.cpp "--compact-path"
+[ "$(./options.cpp -e x | tr '\n' ' ')" = "-e x " ] || fail "./options.cpp -e x, with shebang options, did not pass -e x to the script"
+
+[ "$("$SEABANG" -e 'cout << argv[1] << "\n";' hello)" = "hello" ] || fail "seabang -e did not run the snippet"
+[ "$(printf '%s\n' 'cout << 42 << "\n";' | "$SEABANG" "--compact-path" -)" = "42" ] || fail "seabang - did not run the snippet from stdin"
+
+echo "PASS"
@@ -0,0 +1,278 @@
+/**
+ * @file source_scanner_test.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// Table tests for the source scanner. The include scanner must only find #include "file" directives, not ones in comments
+// or literals, and must not read past the end of the source, that is not null terminated. For the token hash, edits that can not change what is built must keep the hash and
+// ones that can must change it, as a wrong answer runs a stale exec. Returns non zero if any check fails.
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <chrono>
+
+#include "source_scanner.h"
+#include "token_hash.h"
+#include "hash.h"
+#include "guarded_buffer.h"
+
+static int gFailures = 0;
+#define CHECK(__TEST) {if( !(__TEST) ){std::cerr << __FILE__ << ":" << __LINE__ << " failed, " << #__TEST << "\n"; gFailures++;}}
+
+static std::string ScanForIncludes(const std::string& pSource)
+{
+	const GuardedBuffer source(pSource);
+	std::string found;
+	ScanIncludes(source.Data(),source.Size(),[&found](const char* pName,size_t pLength)
+	{
+		found += (found.size() > 0 ? "," : "") + std::string(pName,pLength);
+	});
+	return found;
+}
+
+struct IncludeCase
+{
+	const char* mName;
+	const char* mSource;
+	const char* mIncludes;	// The names found, comma separated.
+};
+
+static const IncludeCase INCLUDE_CASES[] =
+{
+	{"plain",							"#include \"a.h\"\n#include \"b.h\"\n",							"a.h,b.h"},
+	{"no space before the name",		"#include\"a.h\"\n",												"a.h"},
+	{"spaces around the #",				"  #  include  \"a.h\"\n#\tinclude\t\"b.h\"\n",					"a.h,b.h"},
+	{"<> is a system header",			"#include <stdio.h>\n#include<vector>\n#include \"a.h\"\n",		"a.h"},
+	{"not a directive",					"#include_next \"a.h\"\n#includes \"b.h\"\n#define include \"c.h\"\n",	""},
+	{"not at the start of the line",	"int a; #include \"a.h\"\n",										""},
+	{"empty name",						"#include \"\"\n",													""},
+	{"name not closed",					"#include \"a.h\n#include \"b.h\"\n",									"b.h"},
+
+	{"in a block comment",				"/*\n#include \"a.h\"\n*/\n#include \"b.h\"\n",					"b.h"},
+	{"after a block comment",			"/* note */ #include \"a.h\"\n",									"a.h"},
+	{"after a block comment of lines",	"/* one\n two */ #include \"a.h\"\n",								"a.h"},
+	{"after code and a block comment",	"int a; /* note */ #include \"a.h\"\n",								""},
+	{"block comment not closed",		"/*\n#include \"a.h\"\n",											""},
+	{"in a line comment",				"// #include \"a.h\"\n#include \"b.h\"\n",						"b.h"},
+	{"line comment spliced",			"// note \\\n#include \"a.h\"\n#include \"b.h\"\n",				"b.h"},
+	{"line comment spliced CRLF",		"// note \\\r\n#include \"a.h\"\r\n#include \"b.h\"\r\n",		"b.h"},
+	{"line comment, not a splice",		"// note \\ \n#include \"a.h\"\n",								"a.h"},
+	{"slash that is not a comment",		"int a = 4 / 2;\n#include \"a.h\"\n",								"a.h"},
+
+	{"in a string",						"const char* s = \"\\\n#include \\\"a.h\\\"\";\n#include \"b.h\"\n",	"b.h"},
+	{"string spliced",					"const char* s = \"x\\\n#include \";\n#include \"b.h\"\n",			"b.h"},
+	{"string not closed",				"const char* s = \"x;\n#include \"a.h\"\n",							"a.h"},
+	{"quote in a char",					"char q = '\"';\n#include \"a.h\"\n",								"a.h"},
+	{"comment start in a char",			"char q = '/'; char r = '*';\n#include \"a.h\"\n",					"a.h"},
+	{"comment start in a string",		"const char* s = \"/*\";\n#include \"a.h\"\n",						"a.h"},
+	{"in a raw string",					"const char* s = R\"(\n#include \"a.h\"\n)\";\n#include \"b.h\"\n",	"b.h"},
+	{"raw string with a delimiter",		"auto s = u8R\"x(\n)\"\n#include \"a.h\"\n)x\";\n#include \"b.h\"\n",	"b.h"},
+	{"R at the end of a name",			"#define FOR(x) x\nconst char* FOR\"(\";\n#include \"a.h\"\n",			"a.h"},
+
+	// If the ' were taken as a char literal it would end at the second one and the comment would not be seen.
+	{"digit separator",					"int n = 1'000; /* '\n#include \"a.h\" */\n#include \"b.h\"\n",		"b.h"},
+	{"digit separators in hex",			"int n = 0xFF'FF'FF; /* '\n#include \"a.h\" */\n",					""},
+	{"char after a number",				"int n = 1 + 'a';\n#include \"a.h\"\n",								"a.h"},
+
+	{"no new line at the end",			"#include \"a.h\"",													"a.h"},
+	{"cut off in the name",				"#include \"a.h",														""},
+	{"cut off in the directive",		"#inclu",																""},
+	{"only a #",						"#",																	""},
+	{"empty",							"",																		""},
+};
+
+static void TestScanIncludesTable()
+{
+	for( const IncludeCase& test : INCLUDE_CASES )
+	{
+		const std::string found = ScanForIncludes(test.mSource);
+		if( found != test.mIncludes )
+		{
+			std::cerr << "Include case \"" << test.mName << "\" found \"" << found << "\" and not \"" << test.mIncludes << "\"\n";
+			gFailures++;
+		}
+	}
+}
+
+/**
+ * @brief The sixteen bytes at a time scan is only done while there are sixteen left, the directive is moved through the
+ * last of them and across the point they are read from, with no new line after it.
+ */
+static void TestScanIncludesAtTheEnd()
+{
+	for( size_t padding = 0 ; padding < 48 ; padding++ )
+	{
+		const std::string padded = std::string(padding,' ') + "\n";
+		CHECK( ScanForIncludes(padded + "#include \"end.h\"") == "end.h" );
+		CHECK( ScanForIncludes(padded + "// #include \"end.h\"") == "" );
+		CHECK( ScanForIncludes(padded + "x = \"#include \\\"end.h\\\"\"") == "" );
+		CHECK( ScanForIncludes(padded + "#include <end.h>") == "" );
+		CHECK( ScanForIncludes(padded + "#include \"end.h") == "" );
+	}
+
+	// A directive found through the file mapping, the file ends at the closing quote.
+	const std::filesystem::path file = std::filesystem::temp_directory_path() / ("seabang-scan-end-" + std::to_string(getpid()) + ".h");
+	std::ofstream(file,std::ios::trunc) << std::string(4096 - 17,'\n') << "#include \"end.h\"";
+	std::string found;
+	CHECK( ScanIncludesInFile(file,[&found](const char* pName,size_t pLength){found.assign(pName,pLength);}) );
+	CHECK( found == "end.h" );
+	std::filesystem::remove(file);
+	CHECK( ScanIncludesInFile(file,[](const char*,size_t){}) == false );
+}
+
+static uint64_t HashTokens(const std::string& pSource)
+{
+	return HashSourceTokens(pSource.data(),pSource.size(),HASH_SEED);
+}
+
+static const std::string TOKEN_SOURCE =
+	"#include <stdio.h>\n"
+	"#define SQUARE(x) ((x)*(x))\n"
+	"int main()\n"
+	"{\n"
+	"\tint a = 1, b = 2;\n"
+	"\tconst char* s = \"a  b\";\n"
+	"\tconst char* r = R\"x( \"// not a comment\" )x\";\n"
+	"\tchar c = 'x';\n"
+	"\tprintf(\"%d %s %s %c\\n\",SQUARE(a+ +b),s,r,c); // what it does\n"
+	"\t/* a block\n"
+	"\t   comment */ return 0;\n"
+	"}\n";
+
+struct TokenEdit
+{
+	const char* mName;
+	const char* mFind;		// Replaced by mReplace in TOKEN_SOURCE.
+	const char* mReplace;
+	bool mSameHash;
+};
+
+static const TokenEdit TOKEN_EDITS[] =
+{
+	{"line comment edited",						"// what it does",				"// prints them",					true},
+	{"line comment removed",					" // what it does",				"",									true},
+	{"block comment edited",					"a block\n\t   comment */",		"other\n\t   words */",				true},
+	{"block comment added inside a line",		"int a = 1, b",					"int a = 1, /* note */ b",			true},
+	{"spaces inside a line",					"int a = 1, b = 2;",			"int  a=1,b =2;",					true},
+	{"indent changed",							"\tchar c",						"        char c",					true},
+	{"trailing white space",					"int main()\n",					"int main()  \t\n",					true},
+	{"spaces that don't join tokens",			"SQUARE(a+ +b)",				"SQUARE( a +  + b )",				true},
+
+	{"white space inside a #define",			"((x)*(x))",					"((x) * (x))",						false},
+	{"#define made object like",				"SQUARE(x)",					"SQUARE (x)",						false},
+	{"string literal",							"\"a  b\"",						"\"a b\"",							false},
+	{"char literal",							"'x'",							"'y'",								false},
+	{"raw string, white space",					"R\"x( \"// not",				"R\"x(  \"// not",					false},
+	{"raw string, the comment in it",			"not a comment",				"still not a comment",				false},
+	{"tokens pasted together",					"SQUARE(a+ +b)",				"SQUARE(a++b)",						false},
+	{"line inserted above the code",			"int main()\n",					"\nint main()\n",					false},
+	{"comment line inserted above the code",	"int main()\n",					"// main\nint main()\n",			false},
+	{"block comment grows a line",				"a block\n",					"a block\n\tmore\n",				false},
+	{"code changed",							"return 0;",					"return 1;",						false},
+};
+
+static void TestTokenHashTable()
+{
+	const uint64_t original = HashTokens(TOKEN_SOURCE);
+	for( const TokenEdit& edit : TOKEN_EDITS )
+	{
+		std::string edited = TOKEN_SOURCE;
+		const size_t found = edited.find(edit.mFind);
+		if( found == std::string::npos )
+		{
+			std::cerr << "Token edit \"" << edit.mName << "\" does not match the source\n";
+			gFailures++;
+			continue;
+		}
+		edited.replace(found,strlen(edit.mFind),edit.mReplace);
+
+		if( (HashTokens(edited) == original) != edit.mSameHash )
+		{
+			std::cerr << "Token edit \"" << edit.mName << "\" should " << (edit.mSameHash ? "keep" : "change") << " the hash\n";
+			gFailures++;
+		}
+	}
+
+	// The seed is carried through, so the files of an exec can be chained.
+	CHECK( HashSourceTokens(TOKEN_SOURCE.data(),TOKEN_SOURCE.size(),1) != HashSourceTokens(TOKEN_SOURCE.data(),TOKEN_SOURCE.size(),2) );
+	CHECK( HashTokens("") == HASH_SEED );
+}
+
+/**
+ * @brief The cache must give the hash of what is in the file now, and what it saved must read back the same.
+ */
+static void TestTokenHashCache(const std::filesystem::path& pFolder)
+{
+	const std::filesystem::path file = pFolder / "source.cpp";
+	auto write = [&](const std::string& pSource,int pSecondsAgo)
+	{
+		std::ofstream(file,std::ios::trunc) << pSource;
+		std::filesystem::last_write_time(file,std::filesystem::file_time_type::clock::now() - std::chrono::seconds(pSecondsAgo));
+	};
+
+	uint64_t first = 0,cosmetic = 0,changed = 0,loaded = 0;
+	{
+		TokenHashCache cache(pFolder);
+		write(TOKEN_SOURCE,30);
+		CHECK( cache.GetHash(file,first) );
+		CHECK( first == HashTokens(TOKEN_SOURCE) );
+
+		write(TOKEN_SOURCE + "// more\n",20);
+		CHECK( cache.GetHash(file,cosmetic) );
+		CHECK( cosmetic == first );
+
+		write(TOKEN_SOURCE + "int more;\n",10);
+		CHECK( cache.GetHash(file,changed) );
+		CHECK( changed != first );
+		cache.Save();
+	}
+
+	TokenHashCache reloaded(pFolder);
+	CHECK( reloaded.GetHash(file,loaded) );
+	CHECK( loaded == changed );
+	CHECK( reloaded.GetHash(pFolder / "missing.cpp",loaded) == false );
+}
+
+int main()
+{
+	char folderTemplate[] = "/tmp/seabang-source-scanner-test-XXXXXX";
+	if( mkdtemp(folderTemplate) == nullptr )
+	{
+		std::cerr << "Failed to make the temp folder for the test\n";
+		return EXIT_FAILURE;
+	}
+	const std::filesystem::path folder = folderTemplate;
+
+	TestScanIncludesTable();
+	TestScanIncludesAtTheEnd();
+	TestTokenHashTable();
+	TestTokenHashCache(folder);
+
+	std::filesystem::remove_all(folder);
+	if( gFailures > 0 )
+	{
+		std::cerr << gFailures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "PASS\n";
+	return EXIT_SUCCESS;
+}
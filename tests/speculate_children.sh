@@ -0,0 +1,58 @@
+#!/bin/sh
+# A speculative build runs alongside seabang's other compiler runs, such as getting the compiler's version for the
+# remote cache. Each has to wait for only its own child, or the speculative build's status is lost and a good build fails.
+# The compiler is wrapped so --version is slow and the speculative build is always done first.
+# Usage: speculate_children.sh <path to seabang>
+
+SEABANG="$1"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir -p "$WORK/cache"
+export SEABANG_TEMPORARY_FOLDER="$WORK/cache"
+
+fail()
+{
+    echo "FAIL: $1"
+    exit 1
+}
+
+cat > "$WORK/slow-version-c++" <<'WRAPPER'
+#!/bin/sh
+for arg in "$@"; do
+    [ "$arg" = "--version" ] && sleep 2
+done
+exec c++ "$@"
+WRAPPER
+chmod +x "$WORK/slow-version-c++"
+export SEABANG_CXX_COMPILER="$WORK/slow-version-c++"
+
+# Lots of headers so the dependency check is still going when the speculative build is started.
+cd "$WORK" || fail "no work folder"
+n=0
+: > headers.h
+while [ $n -lt 500 ]; do
+    echo "#define HEADER_$n" > "h$n.h"
+    echo "#include \"h$n.h\"" >> headers.h
+    n=$((n + 1))
+done
+
+cat > spec.cpp <<SCRIPT
+#!$SEABANG --seabang-speculate=0 --seabang-remote-cache=http://127.0.0.1:1/ --verbose
+#include <iostream>
+#include "headers.h"
+int main()
+{
+    std::cout << "built" << "\n";
+    return 0;
+}
+SCRIPT
+chmod +x spec.cpp
+
+./spec.cpp > first.log 2>&1 || fail "first build failed, $(cat first.log)"
+sleep 1
+touch h499.h
+./spec.cpp > second.log 2>&1 || fail "rebuild with a speculative build failed, $(tail -5 second.log)"
+grep -q "^built$" second.log || fail "the script did not run after the rebuild"
+grep -q "Using the speculative build" second.log || echo "NOTE: the dependency check was done before the speculative build started"
+
+echo "PASS"
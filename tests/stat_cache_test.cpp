@@ -0,0 +1,286 @@
+/**
+ * @file stat_cache_test.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// Checks the shared stat cache's lock free table. Writers in their own processes hammer one slot while readers check every
+// stat they are given is one that was written whole. A slot with a field from another write must not be read, a slot left
+// odd by a writer that died must not be written or read till it's taken over a second later. Returns non zero if any check fails.
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <filesystem>
+
+#include "stat_cache.h"
+#include "hash.h"
+
+static int gFailures = 0;
+#define CHECK(__TEST) {if( !(__TEST) ){std::cerr << __FILE__ << ":" << __LINE__ << " failed, " << #__TEST << "\n"; gFailures++;}}
+
+// The layout of the stats table in stat_cache.cpp, the test pokes the slots as a writer that died or was slow would leave them.
+static const size_t STATS_OFFSET = 64;
+static const size_t STAT_SLOTS = 1 << 15;
+static const size_t STAT_SLOT_WORDS = 10;
+enum StatSlotWord {SEQUENCE = 0,KEY = 1,SIZE = 8};
+static const uint64_t SECOND_NS = 1000000000ULL;
+
+static const int WRITERS = 4;
+static const int READERS = 2;
+static const int HAMMER_MS = 1000;
+
+static uint64_t GetNow()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return (uint64_t)now.tv_sec * SECOND_NS + now.tv_nsec;
+}
+
+/**
+ * @brief A stat whose fields can all be worked out from any one of them, so one read with fields from two writes is seen.
+ */
+static SharedStat MakeStat(uint64_t pValue)
+{
+	SharedStat stat;
+	stat.mFound = true;
+	stat.mTime.tv_sec = (time_t)(pValue & 0x7fffffff);
+	stat.mTime.tv_nsec = (long)(pValue % SECOND_NS);
+	stat.mDevice = pValue;
+	stat.mInode = pValue * 3;
+	stat.mSize = pValue * 7;
+	return stat;
+}
+
+static bool IsWhole(const SharedStat& pStat)
+{
+	const SharedStat made = MakeStat(pStat.mDevice);
+	return pStat.mFound && pStat.mTime.tv_sec == made.mTime.tv_sec && pStat.mTime.tv_nsec == made.mTime.tv_nsec && pStat.mInode == made.mInode && pStat.mSize == made.mSize;
+}
+
+/**
+ * @brief The cache file mapped as another seabang would have it, to get at the slot a path is written to.
+ */
+class CacheFileSlot
+{
+public:
+	CacheFileSlot(const std::filesystem::path& pTempFolder,const std::string& pPath)
+	{
+		const int file = open((pTempFolder / ".seabang" / "stat-cache").c_str(),O_RDWR|O_CLOEXEC);
+		if( file < 0 )
+			return;
+		mSize = (size_t)lseek(file,0,SEEK_END);
+		void* map = mmap(nullptr,mSize,PROT_READ|PROT_WRITE,MAP_SHARED,file,0);
+		close(file);
+		if( map == MAP_FAILED )
+			return;
+		mMap = (uint8_t*)map;
+
+		// The first probe, the table is empty till the test writes it.
+		const uint64_t hash = HashBytes(pPath.data(),pPath.size());
+		mKey = hash != 0 ? hash : 1;
+		mSlot = (std::atomic<uint64_t>*)(mMap + STATS_OFFSET) + (mKey & (STAT_SLOTS - 1)) * STAT_SLOT_WORDS;
+	}
+
+	~CacheFileSlot()
+	{
+		if( mMap )
+			munmap(mMap,mSize);
+	}
+
+	bool IsOpen()const{return mSlot != nullptr;}
+	uint64_t GetKey()const{return mKey;}
+	std::atomic<uint64_t>& operator[](StatSlotWord pWord){return mSlot[pWord];}
+
+private:
+	uint8_t* mMap = nullptr;
+	size_t mSize = 0;
+	uint64_t mKey = 0;
+	std::atomic<uint64_t>* mSlot = nullptr;
+};
+
+/**
+ * @brief Writers keep writing the one path while readers read it, every stat a reader gets has to be whole.
+ */
+static void TestHammer(const std::filesystem::path& pFolder)
+{
+	const std::string path = "/hammered.h";
+	const uint64_t deadline = GetNow() + HAMMER_MS * 1000000ULL;
+
+	std::vector<pid_t> writers,readers;
+	for( int n = 0 ; n < WRITERS + READERS ; n++ )
+	{
+		const bool writer = n < WRITERS;
+		const pid_t child = fork();
+		if( child == 0 )
+		{
+			SharedStatCache cache(pFolder,60000);
+			uint64_t count = 0,good = 0,torn = 0;
+			while( GetNow() < deadline )
+			{
+				if( writer )
+				{
+					cache.PutStat(path,MakeStat(((uint64_t)(n + 1) << 32) | ++count));
+				}
+				else
+				{
+					SharedStat stat;
+					if( cache.GetStat(path,stat) )
+						(IsWhole(stat) ? good : torn)++;
+				}
+			}
+			// A reader that never got a stat has not tested anything.
+			_exit( writer ? 0 : (torn > 0 ? 1 : (good == 0 ? 2 : 0)) );
+		}
+		(writer ? writers : readers).push_back(child);
+	}
+
+	for( pid_t writer : writers )
+	{
+		int status = 0;
+		waitpid(writer,&status,0);
+		CHECK( WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+	}
+	for( pid_t reader : readers )
+	{
+		int status = 0;
+		waitpid(reader,&status,0);
+		if( WIFEXITED(status) == false || WEXITSTATUS(status) != 0 )
+		{
+			std::cerr << "Reader " << reader << (WIFEXITED(status) && WEXITSTATUS(status) == 1 ? " was given a torn stat" : WIFEXITED(status) && WEXITSTATUS(status) == 2 ? " never got a stat" : " failed") << "\n";
+			gFailures++;
+		}
+	}
+
+	// All the writers finished, so the slot is not left odd and has a whole stat in it.
+	SharedStatCache cache(pFolder,60000);
+	SharedStat stat;
+	CHECK( cache.GetStat(path,stat) );
+	CHECK( IsWhole(stat) );
+	CacheFileSlot slot(pFolder,path);
+	CHECK( slot.IsOpen() && (slot[SEQUENCE].load() & 1) == 0 );
+}
+
+/**
+ * @brief A write by a writer that was taken over, and woke up after, can leave fields from two writes with an even sequence.
+ * The reader can't see that from the sequence, the hash of the slot has to catch it.
+ */
+static void TestTornSlot(const std::filesystem::path& pFolder)
+{
+	const std::string path = "/torn.h";
+	SharedStatCache cache(pFolder,60000);
+	CacheFileSlot slot(pFolder,path);
+	CHECK( slot.IsOpen() );
+	if( slot.IsOpen() == false )
+		return;
+
+	SharedStat stat;
+	cache.PutStat(path,MakeStat(1));
+	CHECK( slot[KEY].load() == slot.GetKey() );// Else the test has the layout wrong.
+	const uint64_t firstSize = slot[SIZE].load();
+
+	cache.PutStat(path,MakeStat(2));
+	CHECK( cache.GetStat(path,stat) && stat.mDevice == 2 );
+
+	slot[SIZE].store(firstSize);
+	CHECK( cache.GetStat(path,stat) == false );
+
+	// The next whole write makes it good again.
+	cache.PutStat(path,MakeStat(3));
+	CHECK( cache.GetStat(path,stat) && stat.mDevice == 3 && IsWhole(stat) );
+}
+
+/**
+ * @brief A slot left odd is being written, or was by a writer that died. It's not read, and not written till it has been
+ * odd for a second, then the next writer takes it over.
+ */
+static void TestAbandonedSlot(const std::filesystem::path& pFolder)
+{
+	const std::string path = "/abandoned.h";
+	SharedStatCache cache(pFolder,60000);
+	CacheFileSlot slot(pFolder,path);
+	CHECK( slot.IsOpen() );
+	if( slot.IsOpen() == false )
+		return;
+
+	SharedStat stat;
+	cache.PutStat(path,MakeStat(1));
+	CHECK( cache.GetStat(path,stat) && stat.mDevice == 1 );
+
+	// A writer that started just now, and has not finished.
+	const uint64_t writing = GetNow() | 1;
+	slot[SEQUENCE].store(writing);
+	CHECK( cache.GetStat(path,stat) == false );
+	cache.PutStat(path,MakeStat(2));
+	CHECK( slot[SEQUENCE].load() == writing );
+	CHECK( cache.GetStat(path,stat) == false );
+
+	// One that started two seconds ago, it died. The next write takes the slot and it's good again.
+	const uint64_t died = (GetNow() - 2 * SECOND_NS) | 1;
+	slot[SEQUENCE].store(died);
+	CHECK( cache.GetStat(path,stat) == false );
+	cache.PutStat(path,MakeStat(3));
+	CHECK( (slot[SEQUENCE].load() & 1) == 0 && slot[SEQUENCE].load() > died );
+	CHECK( cache.GetStat(path,stat) && stat.mDevice == 3 && IsWhole(stat) );
+
+	// One from before a reboot, the monotonic clock started again so it's far ahead of now. Taken over too.
+	const uint64_t beforeReboot = (GetNow() + 3600 * SECOND_NS) | 1;
+	slot[SEQUENCE].store(beforeReboot);
+	cache.PutStat(path,MakeStat(4));
+	CHECK( (slot[SEQUENCE].load() & 1) == 0 && slot[SEQUENCE].load() < beforeReboot );
+	CHECK( cache.GetStat(path,stat) && stat.mDevice == 4 );
+
+	// And the sequence still goes up from there, so a reader can't see the same even sequence before and after a write.
+	const uint64_t sequence = slot[SEQUENCE].load();
+	cache.PutStat(path,MakeStat(5));
+	CHECK( slot[SEQUENCE].load() > sequence );
+}
+
+int main()
+{
+	char folderTemplate[] = "/tmp/seabang-stat-cache-test-XXXXXX";
+	if( mkdtemp(folderTemplate) == nullptr )
+	{
+		std::cerr << "Failed to make the temp folder for the test\n";
+		return EXIT_FAILURE;
+	}
+	const std::filesystem::path folder = folderTemplate;
+
+	{
+		SharedStatCache cache(folder,60000);
+		CHECK( cache.IsOpen() );
+	}
+
+	TestTornSlot(folder);
+	TestAbandonedSlot(folder);
+	TestHammer(folder);
+
+	std::filesystem::remove_all(folder);
+	if( gFailures > 0 )
+	{
+		std::cerr << gFailures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "PASS\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file seabang-cache-server.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// A small http server for seabang's --seabang-remote-cache, for testing and for small teams.
+// Bundles are stored as files in one folder, named by their key. GET and HEAD fetch one, PUT stores one.
+// Everything else is refused. The key is the last part of the path, so the cache can be given any prefix,
+// http://host:port/seabang/ and http://host:port/ both work.
+//
+// Trust: seabang only checks a downloaded bundle against the manifest in it, not who built it, so anyone who can PUT to
+// this server can have every host that uses it run their code. Do not let untrusted hosts upload. Run it --read-only and
+// fill the folder from a trusted build host, or set SEABANG_REMOTE_CACHE_TOKEN for the server and the hosts that build,
+// then a PUT without that token as it's bearer token is refused. GET is open to anyone who can reach the port either way.
+//
+// Usage: seabang-cache-server [--port=8470] [--folder=./seabang-cache] [--max-upload=BYTES] [--read-only]
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <algorithm>
+
+static std::filesystem::path gCacheFolder = "./seabang-cache";
+static int64_t gMaxUpload = 1024LL * 1024LL * 1024LL;
+static std::atomic<uint64_t> gUploadCount(0);
+static bool gReadOnly = false;
+static std::string gUploadToken;		// If set a PUT has to have it as the bearer token.
+
+static const int SOCKET_TIMEOUT_SECONDS = 30;
+
+static std::string GetArgument(int argc,char *argv[],const std::string& pName,const std::string& pDefault)
+{
+	const std::string prefix = pName + "=";
+	for( int n = 1 ; n < argc ; n++ )
+	{
+		if( std::string(argv[n]).rfind(prefix,0) == 0 )
+			return argv[n] + prefix.size();
+	}
+	return pDefault;
+}
+
+/**
+ * @brief Takes as long for any wrong token of the same length, so it can't be found a character at a time.
+ */
+static bool IsUploadToken(const std::string& pToken)
+{
+	if( pToken.size() != gUploadToken.size() )
+		return false;
+
+	unsigned char difference = 0;
+	for( size_t n = 0 ; n < pToken.size() ; n++ )
+		difference |= (unsigned char)(pToken[n] ^ gUploadToken[n]);
+	return difference == 0;
+}
+
+static bool SendAll(int pSocket,const char* pData,size_t pSize)
+{
+	while( pSize > 0 )
+	{
+		const ssize_t sent = send(pSocket,pData,pSize,MSG_NOSIGNAL);
+		if( sent <= 0 )
+		{
+			if( sent < 0 && errno == EINTR )
+				continue;
+			return false;
+		}
+		pData += sent;
+		pSize -= sent;
+	}
+	return true;
+}
+
+static void SendResponse(int pSocket,int pStatus,const std::string& pReason,int64_t pContentLength = 0)
+{
+	const std::string response = "HTTP/1.1 " + std::to_string(pStatus) + " " + pReason + "\r\n" +
+								"Content-Length: " + std::to_string(pContentLength) + "\r\n" +
+								"Connection: close\r\n\r\n";
+	SendAll(pSocket,response.data(),response.size());
+}
+
+/**
+ * @brief The key is the last part of the path, only letters, digits, - and _ are allowed so it can never point out of the cache folder.
+ */
+static bool GetKeyFromPath(const std::string& pPath,std::string& rKey)
+{
+	rKey = pPath.substr(pPath.rfind('/') + 1);
+	if( rKey.size() == 0 || rKey.size() > 128 )
+		return false;
+
+	for( const char c : rKey )
+	{
+		if( isalnum((unsigned char)c) == false && c != '-' && c != '_' )
+			return false;
+	}
+	return true;
+}
+
+static void SendFile(int pSocket,const std::filesystem::path& pFile,bool pWithBody)
+{
+	const int file = open(pFile.c_str(),O_RDONLY|O_CLOEXEC);
+	struct stat Stats;
+	if( file < 0 || fstat(file,&Stats) != 0 )
+	{
+		if( file >= 0 )
+			close(file);
+		SendResponse(pSocket,404,"Not Found");
+		return;
+	}
+
+	SendResponse(pSocket,200,"OK",Stats.st_size);
+	char buf[64 * 1024];
+	ssize_t got;
+	while( pWithBody && (got = read(file,buf,sizeof(buf))) > 0 )
+	{
+		if( SendAll(pSocket,buf,got) == false )
+			break;
+	}
+	close(file);
+}
+
+/**
+ * @brief Reads the body into a file to the side and renames it into place, a GET at the same time sees the old bundle or the new one, never half of one.
+ */
+static void ReceiveFile(int pSocket,const std::filesystem::path& pFile,int64_t pContentLength,const std::string& pBodyStart)
+{
+	const std::filesystem::path tempFile = gCacheFolder / (".upload." + std::to_string(getpid()) + "." + std::to_string(gUploadCount++));
+	const int file = open(tempFile.c_str(),O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,0644);
+	if( file < 0 )
+	{
+		SendResponse(pSocket,500,"Internal Server Error");
+		return;
+	}
+
+	bool good = pBodyStart.size() <= (size_t)pContentLength && write(file,pBodyStart.data(),pBodyStart.size()) == (ssize_t)pBodyStart.size();
+	int64_t got = (int64_t)pBodyStart.size();
+	char buf[64 * 1024];
+	while( good && got < pContentLength )
+	{
+		const ssize_t read = recv(pSocket,buf,std::min((int64_t)sizeof(buf),pContentLength - got),0);
+		if( read < 0 && errno == EINTR )
+			continue;
+		good = read > 0 && write(file,buf,read) == read;
+		got += read > 0 ? read : 0;
+	}
+	good = close(file) == 0 && good;
+
+	std::error_code ec;
+	if( good )
+		std::filesystem::rename(tempFile,pFile,ec);
+
+	if( good == false || ec )
+	{
+		std::filesystem::remove(tempFile,ec);
+		SendResponse(pSocket,400,"Bad Request");
+		return;
+	}
+	SendResponse(pSocket,201,"Created");
+}
+
+static void HandleConnection(int pSocket)
+{
+	const timeval timeout = {SOCKET_TIMEOUT_SECONDS,0};
+	setsockopt(pSocket,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+	setsockopt(pSocket,SOL_SOCKET,SO_SNDTIMEO,&timeout,sizeof(timeout));
+
+	std::string request;
+	size_t headerEnd;
+	char buf[4096];
+	while( (headerEnd = request.find("\r\n\r\n")) == std::string::npos && request.size() < 16 * 1024 )
+	{
+		const ssize_t got = recv(pSocket,buf,sizeof(buf),0);
+		if( got <= 0 )
+		{
+			close(pSocket);
+			return;
+		}
+		request.append(buf,got);
+	}
+
+	if( headerEnd == std::string::npos )
+	{
+		SendResponse(pSocket,431,"Request Header Fields Too Large");
+		close(pSocket);
+		return;
+	}
+
+	const std::string body = request.substr(headerEnd + 4);
+	request.resize(headerEnd + 2);
+
+	// GET /seabang/0123456789abcdef HTTP/1.1
+	const size_t methodEnd = request.find(' ');
+	const size_t pathEnd = request.find(' ',methodEnd + 1);
+	const std::string method = request.substr(0,methodEnd);
+	const std::string path = methodEnd == std::string::npos || pathEnd == std::string::npos ? "" : request.substr(methodEnd + 1,pathEnd - methodEnd - 1);
+
+	int64_t contentLength = -1;
+	std::string token;
+	for( size_t lineStart = request.find("\r\n") + 2 ; lineStart < request.size() ; )
+	{
+		const size_t lineEnd = request.find("\r\n",lineStart);
+		const std::string line = request.substr(lineStart,lineEnd - lineStart);
+		lineStart = lineEnd + 2;
+		if( strncasecmp(line.c_str(),"Content-Length:",15) == 0 )
+			contentLength = atoll(line.c_str() + 15);
+		else if( strncasecmp(line.c_str(),"Authorization: Bearer ",22) == 0 )
+			token = line.substr(22);
+	}
+
+	std::string key;
+	if( GetKeyFromPath(path,key) == false )
+	{
+		SendResponse(pSocket,400,"Bad Request");
+	}
+	else if( method == "GET" || method == "HEAD" )
+	{
+		SendFile(pSocket,gCacheFolder / key,method == "GET");
+	}
+	else if( method == "PUT" )
+	{
+		if( gReadOnly )
+			SendResponse(pSocket,403,"Forbidden");
+		else if( gUploadToken.size() > 0 && IsUploadToken(token) == false )
+			SendResponse(pSocket,401,"Unauthorized");
+		else if( contentLength < 0 )
+			SendResponse(pSocket,411,"Length Required");
+		else if( contentLength > gMaxUpload )
+			SendResponse(pSocket,413,"Payload Too Large");
+		else
+			ReceiveFile(pSocket,gCacheFolder / key,contentLength,body);
+	}
+	else
+	{
+		SendResponse(pSocket,405,"Method Not Allowed");
+	}
+
+	std::clog << method << " " << path << "\n";
+	close(pSocket);
+}
+
+int main(int argc,char *argv[])
+{
+	for( int n = 1 ; n < argc ; n++ )
+	{
+		if( strcmp(argv[n],"--help") == 0 )
+		{
+			std::cout << "Usage: seabang-cache-server [--port=8470] [--folder=./seabang-cache] [--max-upload=BYTES] [--read-only]\n";
+			std::cout << "    --read-only Refuse every upload, the folder is filled some other way.\n";
+			std::cout << "    If SEABANG_REMOTE_CACHE_TOKEN is set an upload has to send it as it's bearer token.\n";
+			std::cout << "    Anyone who can upload can have every host using the cache run their code, only let trusted hosts.\n";
+			return EXIT_SUCCESS;
+		}
+	}
+
+	const int port = atoi(GetArgument(argc,argv,"--port","8470").c_str());
+	gCacheFolder = GetArgument(argc,argv,"--folder",gCacheFolder.string());
+	gMaxUpload = atoll(GetArgument(argc,argv,"--max-upload",std::to_string(gMaxUpload)).c_str());
+	for( int n = 1 ; n < argc ; n++ )
+	{
+		if( strcmp(argv[n],"--read-only") == 0 )
+			gReadOnly = true;
+	}
+	if( getenv("SEABANG_REMOTE_CACHE_TOKEN") )
+		gUploadToken = getenv("SEABANG_REMOTE_CACHE_TOKEN");
+
+	std::error_code ec;
+	std::filesystem::create_directories(gCacheFolder,ec);
+	if( ec )
+	{
+		std::cerr << "Failed to create the cache folder " << gCacheFolder << " " << ec.message() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	signal(SIGPIPE,SIG_IGN);
+
+	const int listener = socket(AF_INET6,SOCK_STREAM|SOCK_CLOEXEC,0);
+	const int yes = 1;
+	const int no = 0;
+	setsockopt(listener,SOL_SOCKET,SO_REUSEADDR,&yes,sizeof(yes));
+	setsockopt(listener,IPPROTO_IPV6,IPV6_V6ONLY,&no,sizeof(no));
+
+	sockaddr_in6 address = {};
+	address.sin6_family = AF_INET6;
+	address.sin6_addr = in6addr_any;
+	address.sin6_port = htons(port);
+	if( listener < 0 || bind(listener,(sockaddr*)&address,sizeof(address)) != 0 || listen(listener,64) != 0 )
+	{
+		std::cerr << "Failed to listen on port " << port << " " << strerror(errno) << "\n";
+		return EXIT_FAILURE;
+	}
+
+	std::clog << "seabang cache server on port " << port << " storing in " << gCacheFolder << (gReadOnly ? ", read only" : (gUploadToken.size() > 0 ? ", uploads need the token" : ", anyone can upload")) << "\n";
+	for(;;)
+	{
+		const int connection = accept4(listener,nullptr,nullptr,SOCK_CLOEXEC);
+		if( connection < 0 )
+		{
+			if( errno != EINTR && errno != ECONNABORTED )
+				std::cerr << "accept failed " << strerror(errno) << "\n";
+			continue;
+		}
+		std::thread(HandleConnection,connection).detach();
+	}
+}
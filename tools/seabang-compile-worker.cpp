@@ -0,0 +1,461 @@
+/**
+ * @file seabang-compile-worker.cpp
+ * @author Richard e Collins
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ *  seabang is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seabang is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with seabang.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// A compile worker for seabang's --seabang-workers. seabang preprocesses the source and sends it here with the flags,
+// the worker compiles it to an object and sends that back, seabang does the link. The worker only needs the compiler.
+// GET /status says how many compiles are running or waiting, how many are run at once and which compiler this is.
+// POST /compile takes lines of compiler-version and flag, a blank line and the preprocessed source. If the compiler
+// version is not this one's it is refused. The response is the length of what the compiler said on a line, what it
+// said and then the object. If it failed to compile it's a 422 with what the compiler said.
+// Only flags that change the code made are allowed, ones that name files or load plugins are refused, see worker_flags.h.
+// Each compile is run in an empty folder of it's own, so a relative name in a flag can only be a file of that job.
+//
+// Trust: the worker runs the compiler on whatever it is sent, and the flags are not all that can reach a file. The source can,
+// asm(".incbin \"/etc/passwd\"") puts the bytes of any file the worker can read in the object that is sent back. So anyone
+// who can send it a compile can read what the worker can. It only listens on the loopback address unless given --listen, and
+// if SEABANG_WORKER_TOKEN is set every request without that token as it's bearer token is refused. Give it a token, the
+// same one the hosts that use it are given, before listening where others can reach it, and run it as a user that can
+// read nothing it should not send.
+//
+// Usage: seabang-compile-worker [--listen=127.0.0.1] [--port=8471] [--slots=CPUS] [--compiler=c++] [--folder=TEMP/seabang-worker] [--max-upload=BYTES]
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <filesystem>
+
+#include "worker_flags.h"
+
+static std::filesystem::path gJobFolder = std::filesystem::temp_directory_path() / "seabang-worker";
+static std::string gCompiler = "c++";
+static std::string gCompilerVersion;
+static int64_t gMaxUpload = 256LL * 1024LL * 1024LL;
+static int gSlots = 1;
+static std::string gToken;		// If set every request has to have it as the bearer token.
+
+// Running is every compile that has been asked for and not finished, the ones waiting for a slot too.
+static std::atomic<int> gRunning(0);
+static std::atomic<uint64_t> gJobCount(0);
+static std::mutex gSlotLock;
+static std::condition_variable gSlotFree;
+static int gSlotsTaken = 0;
+
+static const int SOCKET_TIMEOUT_SECONDS = 30;
+
+static std::string GetArgument(int argc,char *argv[],const std::string& pName,const std::string& pDefault)
+{
+	const std::string prefix = pName + "=";
+	for( int n = 1 ; n < argc ; n++ )
+	{
+		if( std::string(argv[n]).rfind(prefix,0) == 0 )
+			return argv[n] + prefix.size();
+	}
+	return pDefault;
+}
+
+static bool SendAll(int pSocket,const char* pData,size_t pSize)
+{
+	while( pSize > 0 )
+	{
+		const ssize_t sent = send(pSocket,pData,pSize,MSG_NOSIGNAL);
+		if( sent <= 0 )
+		{
+			if( sent < 0 && errno == EINTR )
+				continue;
+			return false;
+		}
+		pData += sent;
+		pSize -= sent;
+	}
+	return true;
+}
+
+static void SendResponse(int pSocket,int pStatus,const std::string& pReason,const std::string& pBody = "")
+{
+	const std::string response = "HTTP/1.1 " + std::to_string(pStatus) + " " + pReason + "\r\n" +
+								"Content-Length: " + std::to_string(pBody.size()) + "\r\n" +
+								"Connection: close\r\n\r\n";
+	if( SendAll(pSocket,response.data(),response.size()) )
+		SendAll(pSocket,pBody.data(),pBody.size());
+}
+
+/**
+ * @brief Takes as long for any wrong token of the same length, so it can't be found a character at a time.
+ */
+static bool IsWorkerToken(const std::string& pToken)
+{
+	if( pToken.size() != gToken.size() )
+		return false;
+
+	unsigned char difference = 0;
+	for( size_t n = 0 ; n < pToken.size() ; n++ )
+		difference |= (unsigned char)(pToken[n] ^ gToken[n]);
+	return difference == 0;
+}
+
+static std::string ReadFile(const std::filesystem::path& pFile)
+{
+	std::ifstream file(pFile,std::ios::binary);
+	std::stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+static std::string GetCompilerVersion()
+{
+	std::string version;
+	FILE* output = popen((gCompiler + " --version 2>/dev/null").c_str(),"r");
+	if( output )
+	{
+		char line[1024];
+		if( fgets(line,sizeof(line),output) )
+			version = line;
+		pclose(output);
+	}
+	while( version.size() > 0 && (version.back() == '\n' || version.back() == '\r') )
+		version.pop_back();
+	return version;
+}
+
+/**
+ * @brief Holds one of the slots while it's in scope, waiting for one if they are all taken.
+ */
+class Slot
+{
+public:
+	Slot()
+	{
+		std::unique_lock<std::mutex> lock(gSlotLock);
+		gSlotFree.wait(lock,[]{return gSlotsTaken < gSlots;});
+		gSlotsTaken++;
+	}
+
+	~Slot()
+	{
+		{
+			std::lock_guard<std::mutex> lock(gSlotLock);
+			gSlotsTaken--;
+		}
+		gSlotFree.notify_one();
+	}
+};
+
+/**
+ * @brief Runs the compiler on the source in the job's folder, as it's working folder, with what it says going to a file, as a
+ * pipe would need reading while it runs.
+ */
+static bool RunCompiler(const std::vector<std::string>& pFlags,const std::filesystem::path& pJob,const std::string& pSource,const std::string& pObject,const std::string& pLog)
+{
+	std::vector<std::string> args = {gCompiler};
+	args.insert(args.end(),pFlags.begin(),pFlags.end());
+	args.insert(args.end(),{"-c",pSource,"-o",pObject});
+
+	std::vector<char*> argv;
+	for( std::string& arg : args )
+		argv.push_back(arg.data());
+	argv.push_back(nullptr);
+
+	const pid_t child = fork();
+	if( child == 0 )
+	{
+		if( chdir(pJob.c_str()) != 0 )
+			_exit(127);
+
+		const int log = open(pLog.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+		if( log >= 0 )
+		{
+			dup2(log,STDOUT_FILENO);
+			dup2(log,STDERR_FILENO);
+		}
+		execvp(argv[0],argv.data());
+		_exit(127);
+	}
+
+	int status = 0;
+	if( child < 0 )
+		return false;
+	while( waitpid(child,&status,0) < 0 && errno == EINTR );
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void Compile(int pSocket,const std::string& pBody)
+{
+	const size_t headerEnd = pBody.find("\n\n");
+	if( headerEnd == std::string::npos )
+	{
+		SendResponse(pSocket,400,"Bad Request","no source\n");
+		return;
+	}
+
+	std::vector<std::string> flags;
+	std::string version;
+	std::istringstream lines(pBody.substr(0,headerEnd + 1));
+	std::string line;
+	while( std::getline(lines,line) )
+	{
+		const size_t space = line.find(' ');
+		const std::string name = line.substr(0,space);
+		const std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+		if( name == "compiler-version" )
+		{
+			version = value;
+		}
+		else if( name == "flag" )
+		{
+			if( IsWorkerFlag(value) == false )
+			{
+				SendResponse(pSocket,400,"Bad Request","flag not allowed " + value + "\n");
+				return;
+			}
+			flags.push_back(value);
+		}
+	}
+
+	// The name the compiler was run as is the first word, c++ and g++ are the same compiler.
+	auto stripName = [](const std::string& pVersion){return pVersion.substr(pVersion.find(' ') + 1);};
+	if( stripName(version) != stripName(gCompilerVersion) )
+	{
+		SendResponse(pSocket,409,"Conflict","this worker has " + gCompilerVersion + "\n");
+		return;
+	}
+
+	const std::filesystem::path job = gJobFolder / ("job-" + std::to_string(getpid()) + "-" + std::to_string(gJobCount++));
+	std::error_code ec;
+	if( std::filesystem::create_directory(job,ec) == false )
+	{
+		SendResponse(pSocket,500,"Internal Server Error","could not make the job folder\n");
+		return;
+	}
+
+	{
+		std::ofstream file(job / "source.ii",std::ios::binary|std::ios::trunc);
+		file.write(pBody.data() + headerEnd + 2,pBody.size() - headerEnd - 2);
+	}
+
+	bool compiledOK;
+	{
+		Slot slot;
+		compiledOK = RunCompiler(flags,job,"source.ii","source.o","compiler.log");
+	}
+
+	const std::string output = ReadFile(job / "compiler.log");
+	if( compiledOK )
+		SendResponse(pSocket,200,"OK",std::to_string(output.size()) + "\n" + output + ReadFile(job / "source.o"));
+	else
+		SendResponse(pSocket,422,"Unprocessable Entity",output);
+
+	std::filesystem::remove_all(job,ec);
+}
+
+static void HandleConnection(int pSocket)
+{
+	const timeval timeout = {SOCKET_TIMEOUT_SECONDS,0};
+	setsockopt(pSocket,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+	setsockopt(pSocket,SOL_SOCKET,SO_SNDTIMEO,&timeout,sizeof(timeout));
+
+	std::string request;
+	size_t headerEnd;
+	char buf[64 * 1024];
+	while( (headerEnd = request.find("\r\n\r\n")) == std::string::npos && request.size() < 16 * 1024 )
+	{
+		const ssize_t got = recv(pSocket,buf,sizeof(buf),0);
+		if( got <= 0 )
+		{
+			close(pSocket);
+			return;
+		}
+		request.append(buf,got);
+	}
+
+	if( headerEnd == std::string::npos )
+	{
+		SendResponse(pSocket,431,"Request Header Fields Too Large");
+		close(pSocket);
+		return;
+	}
+
+	std::string body = request.substr(headerEnd + 4);
+	request.resize(headerEnd + 2);
+
+	// POST /compile HTTP/1.1
+	const size_t methodEnd = request.find(' ');
+	const size_t pathEnd = request.find(' ',methodEnd + 1);
+	const std::string method = request.substr(0,methodEnd);
+	const std::string path = methodEnd == std::string::npos || pathEnd == std::string::npos ? "" : request.substr(methodEnd + 1,pathEnd - methodEnd - 1);
+
+	int64_t contentLength = -1;
+	std::string token;
+	for( size_t lineStart = request.find("\r\n") + 2 ; lineStart < request.size() ; )
+	{
+		const size_t lineEnd = request.find("\r\n",lineStart);
+		const std::string line = request.substr(lineStart,lineEnd - lineStart);
+		lineStart = lineEnd + 2;
+		if( strncasecmp(line.c_str(),"Content-Length:",15) == 0 )
+			contentLength = atoll(line.c_str() + 15);
+		else if( strncasecmp(line.c_str(),"Authorization: Bearer ",22) == 0 )
+			token = line.substr(22);
+	}
+
+	if( gToken.size() > 0 && IsWorkerToken(token) == false )
+	{
+		SendResponse(pSocket,401,"Unauthorized");
+	}
+	else if( method == "GET" && path == "/status" )
+	{
+		SendResponse(pSocket,200,"OK","running " + std::to_string(gRunning.load()) + "\nslots " + std::to_string(gSlots) + "\ncompiler-version " + gCompilerVersion + "\n");
+	}
+	else if( method == "POST" && path == "/compile" )
+	{
+		if( contentLength < 0 )
+			SendResponse(pSocket,411,"Length Required");
+		else if( contentLength > gMaxUpload || (int64_t)body.size() > contentLength )
+			SendResponse(pSocket,413,"Payload Too Large");
+		else
+		{
+			gRunning++;
+			while( (int64_t)body.size() < contentLength )
+			{
+				const ssize_t got = recv(pSocket,buf,std::min((int64_t)sizeof(buf),contentLength - (int64_t)body.size()),0);
+				if( got < 0 && errno == EINTR )
+					continue;
+				if( got <= 0 )
+					break;
+				body.append(buf,got);
+			}
+
+			if( (int64_t)body.size() == contentLength )
+				Compile(pSocket,body);
+			gRunning--;
+		}
+	}
+	else if( path == "/status" || path == "/compile" )
+	{
+		SendResponse(pSocket,405,"Method Not Allowed");
+	}
+	else
+	{
+		SendResponse(pSocket,404,"Not Found");
+	}
+
+	std::clog << method << " " << path << "\n";
+	close(pSocket);
+}
+
+int main(int argc,char *argv[])
+{
+	for( int n = 1 ; n < argc ; n++ )
+	{
+		if( strcmp(argv[n],"--help") == 0 )
+		{
+			std::cout << "Usage: seabang-compile-worker [--listen=127.0.0.1] [--port=8471] [--slots=CPUS] [--compiler=c++] [--folder=TEMP/seabang-worker] [--max-upload=BYTES]\n";
+			std::cout << "    --listen=ADDR The address to listen on, only this host can reach the loopback address. :: or 0.0.0.0 for all.\n";
+			std::cout << "    If SEABANG_WORKER_TOKEN is set a request has to send it as it's bearer token.\n";
+			std::cout << "    Anyone who can send a compile can read any file the worker can, with .incbin, only let trusted hosts.\n";
+			return EXIT_SUCCESS;
+		}
+	}
+
+	const std::string listenAddress = GetArgument(argc,argv,"--listen","127.0.0.1");
+	const std::string port = GetArgument(argc,argv,"--port","8471");
+	gSlots = std::max(1,atoi(GetArgument(argc,argv,"--slots",std::to_string(std::thread::hardware_concurrency())).c_str()));
+	gCompiler = GetArgument(argc,argv,"--compiler",gCompiler);
+	gJobFolder = std::filesystem::absolute(GetArgument(argc,argv,"--folder",gJobFolder.string()));
+	gMaxUpload = atoll(GetArgument(argc,argv,"--max-upload",std::to_string(gMaxUpload)).c_str());
+	if( getenv("SEABANG_WORKER_TOKEN") )
+		gToken = getenv("SEABANG_WORKER_TOKEN");
+
+	gCompilerVersion = GetCompilerVersion();
+	if( gCompilerVersion.size() == 0 )
+	{
+		std::cerr << "Failed to run the compiler " << gCompiler << "\n";
+		return EXIT_FAILURE;
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(gJobFolder,ec);
+	if( ec )
+	{
+		std::cerr << "Failed to create the job folder " << gJobFolder << " " << ec.message() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	signal(SIGPIPE,SIG_IGN);
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	addrinfo* address = nullptr;
+	const int found = getaddrinfo(listenAddress.c_str(),port.c_str(),&hints,&address);
+	if( found != 0 )
+	{
+		std::cerr << "Failed to find the address " << listenAddress << " " << gai_strerror(found) << "\n";
+		return EXIT_FAILURE;
+	}
+
+	const int listener = socket(address->ai_family,SOCK_STREAM|SOCK_CLOEXEC,0);
+	const int yes = 1;
+	const int no = 0;
+	setsockopt(listener,SOL_SOCKET,SO_REUSEADDR,&yes,sizeof(yes));
+	if( address->ai_family == AF_INET6 )
+		setsockopt(listener,IPPROTO_IPV6,IPV6_V6ONLY,&no,sizeof(no));
+
+	const bool bound = listener >= 0 && bind(listener,address->ai_addr,address->ai_addrlen) == 0 && listen(listener,64) == 0;
+	freeaddrinfo(address);
+	if( bound == false )
+	{
+		std::cerr << "Failed to listen on " << listenAddress << " port " << port << " " << strerror(errno) << "\n";
+		return EXIT_FAILURE;
+	}
+
+	if( gToken.size() == 0 && listenAddress != "127.0.0.1" && listenAddress != "::1" && listenAddress != "localhost" )
+		std::cerr << "Warning, listening on " << listenAddress << " with no SEABANG_WORKER_TOKEN, anyone who can reach it can read the files this worker can\n";
+
+	std::clog << "seabang compile worker on " << listenAddress << " port " << port << " with " << gSlots << " slots, " << gCompilerVersion << "\n";
+	for(;;)
+	{
+		const int connection = accept4(listener,nullptr,nullptr,SOCK_CLOEXEC);
+		if( connection < 0 )
+		{
+			if( errno != EINTR && errno != ECONNABORTED )
+				std::cerr << "accept failed " << strerror(errno) << "\n";
+			continue;
+		}
+		std::thread(HandleConnection,connection).detach();
+	}
+}